@@ -0,0 +1,22 @@
+# double2.tm: 2-tape machine that doubles the string w on tape 0 into ww
+#   in O(n) shifts, by copying w to tape 1 and appending it from there.
+tapes 2
+charset_max 2
+#
+# state 0: copy w to tape 1
+state
+input 1 0 write 1 1 move RR next 0
+input 2 0 write 2 2 move RR next 0
+input 0 0 write 0 0 move NL next 1
+#
+# state 1: rewind tape 1
+state
+input 0 1 write 0 1 move NL next 1
+input 0 2 write 0 2 move NL next 1
+input 0 0 write 0 0 move NR next 2
+#
+# state 2: append tape 1 to tape 0
+state
+input 0 1 write 1 1 move RR next 2
+input 0 2 write 2 2 move RR next 2
+input 0 0 write 0 0 move SS next 2
@@ -0,0 +1,351 @@
+/* cycle.c: Turing Machine cycle detection
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "cycle.h"
+
+
+
+
+/* NAME
+//   cycleNew: allocate a new cycle detector
+//
+//
+// RETURN VALUE
+//   Returns NULL if memory could not be allocated.
+*/
+CycleT *
+cycleNew(void)
+{
+  CycleT *this;
+
+  if((this = calloc(1, sizeof(CycleT))) == NULL) {
+    fprintf(stderr, "cycleNew: out of memory\n");
+    return NULL;
+  }
+
+  return this;
+}
+
+
+
+
+/* NAME
+//   cycleDestroy: free a cycle detector
+*/
+void
+cycleDestroy(CycleT *this)
+{
+  if(NULL == this) return;
+  free(this->saved);
+  free(this);
+}
+
+
+
+
+/* NAME
+//   cyclePrint: print what the cycle detector found
+*/
+void
+cyclePrint(const CycleT *this)
+{
+  if(0 == this->period) {
+    printf("cycle: none found, %lli tape comparisons\n",
+           (long long) this->compares);
+  } else if(0 == this->shift) {
+    printf("cycle: configuration repeats every %lli shifts,"
+           " %lli tape comparisons\n",
+           (long long) this->period, (long long) this->compares);
+  } else {
+    printf("cycle: configuration repeats every %lli shifts,"
+           " %lli frames along the tape, %lli tape comparisons\n",
+           (long long) this->period, (long long) this->shift,
+           (long long) this->compares);
+  }
+}
+
+
+
+
+/* NAME
+//   cycleZobrist: hash key of a tape symbol
+//
+//
+// DESCRIPTION
+//   A scrambled form of the symbol (the finalizer of splitmix64), so
+//   that keys of different symbols have no simple relation to each
+//   other.  The blank symbol has key 0, so that blank frames, stored
+//   or not, add nothing to the hash.
+*/
+static uint64_t
+cycleZobrist(Char symbol)
+{
+  uint64_t z = (uint64_t)(uint16_t)symbol * UINT64_C(0x9e3779b97f4a7c15);
+
+  if(0 == symbol) return 0;
+
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+
+
+
+/* NAME
+//   cyclePower: base raised to a power, modulo 2^64
+*/
+static uint64_t
+cyclePower(uint64_t base, uint64_t n)
+{
+  uint64_t result = 1;
+
+  while(n) {
+    if(n & 1) result *= base;
+    base *= base;
+    n >>= 1;
+  }
+  return result;
+}
+
+
+
+
+/* NAME
+//   cycleExtent: find the first and last non-blank frames of the tape
+//
+//
+// RETURN VALUE
+//   Returns the number of frames from the first to the last non-blank
+//   frame, or 0 if the tape is blank, in which case *first is not set.
+*/
+static int64_t
+cycleExtent(const TuringMachineT *tm, int64_t *first)
+{
+  int64_t left  = tm->left_end;
+  int64_t right = tm->right_end;
+
+  if(0 == tm->tape_len) return 0;
+
+  while((left <= right) && (0 == tmTapeFrameAt(tm, left)))  left ++;
+  while((right >= left) && (0 == tmTapeFrameAt(tm, right))) right --;
+
+  *first = left;
+  return MAX(right - left + 1, 0);
+}
+
+
+
+
+/* NAME
+//   cycleSave: save the current configuration of the machine
+//
+//
+// RETURN VALUE
+//   Returns -1 if memory could not be allocated, 0 otherwise.
+*/
+static int
+cycleSave(CycleT *this, const TuringMachineT *tm, uint64_t hash)
+{
+  int64_t first = 0;
+  int64_t len   = cycleExtent(tm, &first);
+  int64_t i;
+
+  if(len > this->saved_alloc) {
+    Char *saved = realloc(this->saved, sizeof(Char) * len);
+
+    if(NULL == saved) {
+      fprintf(stderr, "cycleSave: out of memory\n");
+      return -1;
+    }
+    this->saved       = saved;
+    this->saved_alloc = len;
+  }
+
+  for(i = 0; i < len; i++) {
+    this->saved[i] = tmTapeFrameAt(tm, first + i);
+  }
+
+  this->saved_hash  = hash;
+  this->saved_state = tm->state;
+  this->saved_here  = tm->here;
+  this->saved_left  = first;
+  this->saved_len   = len;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   cycleMatch: compare the saved configuration with the current one
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine is in the saved state, with the same tape
+//   relative to the head, 0 otherwise.
+*/
+static int
+cycleMatch(const CycleT *this, const TuringMachineT *tm)
+{
+  int64_t first = 0;
+  int64_t len   = cycleExtent(tm, &first);
+  int64_t i;
+
+  if((tm->state != this->saved_state) || (len != this->saved_len)) {
+    return 0;
+  }
+  if(len && (first - tm->here != this->saved_left - this->saved_here)) {
+    return 0;
+  }
+  for(i = 0; i < len; i++) {
+    if(tmTapeFrameAt(tm, first + i) != this->saved[i]) return 0;
+  }
+  return 1;
+}
+
+
+
+
+/* NAME
+//   cycleReset: start looking for cycles from the current configuration
+//
+//
+// RETURN VALUE
+//   Same as cycleSave().
+*/
+static int
+cycleReset(CycleT *this, const TuringMachineT *tm)
+{
+  int64_t  i;
+  uint64_t power;
+
+  this->hash = 0;
+  if(tm->tape_len) {
+    power = (tm->left_end < 0)
+      ? cyclePower(CYCLE_BASE_INV, -tm->left_end)
+      : cyclePower(CYCLE_BASE, tm->left_end);
+
+    for(i = tm->left_end; i <= tm->right_end; i++) {
+      this->hash += cycleZobrist(tmTapeFrameAt(tm, i)) * power;
+      power *= CYCLE_BASE;
+    }
+  }
+
+  if(tm->here < 0) {
+    this->power     = cyclePower(CYCLE_BASE_INV, -tm->here);
+    this->power_inv = cyclePower(CYCLE_BASE, -tm->here);
+  } else {
+    this->power     = cyclePower(CYCLE_BASE, tm->here);
+    this->power_inv = cyclePower(CYCLE_BASE_INV, tm->here);
+  }
+
+  this->lam      = 0;
+  this->limit    = 1;
+  this->period   = 0;
+  this->shift    = 0;
+  this->compares = 0;
+
+  return cycleSave(this, tm, this->hash * this->power_inv);
+}
+
+
+
+
+/* NAME
+//   cycleSimulateSteps: run the machine, looking for a repeated
+//   configuration
+//
+//
+// DESCRIPTION
+//   Runs the machine one shift at a time with tmUpdate(), as
+//   tmSimulateSteps() does, until it stops, *iters reaches max_iters,
+//   or the tape reaches tape_len_max.  After every shift the hash of
+//   the configuration is compared with that of the configuration saved
+//   by Brent's algorithm (see CycleT).  A machine that comes back to a
+//   configuration, where it was or shifted along the tape, will do so
+//   forever, and is given up on.
+//
+//   A machine that leaves a trail behind it as it moves along the tape
+//   never repeats its whole configuration, so it is not caught here.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulateSteps(), or -5 if the machine repeats a
+//   configuration.  The period and shift of the cycle are left in
+//   'this'.
+//
+//
+// SEE ALSO
+//   tmSimulateSteps(), tmSimulate()
+*/
+int
+cycleSimulateSteps(CycleT *this, TuringMachineT *tm, int64_t *iters,
+                   int64_t max_iters, int64_t tape_len_max, int64_t iter_test)
+{
+  if(cycleReset(this, tm) < 0) {
+    return -4;
+  }
+
+  while((*iters < max_iters) && (tm->tape_len < tape_len_max)) {
+    const Char    read  = tmTapeFrameAt(tm, tm->here);
+    const Entry  *entry = &tm->table[tm->state][read];
+    int           stop;
+    uint64_t      hash;
+
+    this->hash += (cycleZobrist(entry->write) - cycleZobrist(read))
+                  * this->power;
+    if(MOVE_LEFT == entry->move) {
+      this->power     *= CYCLE_BASE_INV;
+      this->power_inv *= CYCLE_BASE;
+    } else if(MOVE_RIGHT == entry->move) {
+      this->power     *= CYCLE_BASE;
+      this->power_inv *= CYCLE_BASE_INV;
+    }
+
+    stop = tmUpdate(tm);
+    if(stop < 0) {
+      return -4;
+    }
+
+    (*iters) ++;
+    if(stop) {
+      return 1;
+    }
+    if((*iters <= iter_test) && (0 == tm->state)) {
+      if(tmTapeAllBlank(tm)) {
+        return -3;
+      }
+    }
+
+    this->lam ++;
+    hash = this->hash * this->power_inv;
+    if((hash == this->saved_hash) && (tm->state == this->saved_state)) {
+      this->compares ++;
+      if(cycleMatch(this, tm)) {
+        this->period = this->lam;
+        this->shift  = tm->here - this->saved_here;
+        return -5;
+      }
+    }
+    if(this->lam == this->limit) {
+      if(cycleSave(this, tm, hash) < 0) {
+        return -4;
+      }
+      this->limit *= 2;
+      this->lam    = 0;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+/* cycle.h: Turing Machine cycle detection
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _CYCLE_H__INCLUDED_
+#define _CYCLE_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* CYCLE_BASE: odd multiplier of the configuration hash, and its inverse
+// modulo 2^64
+*/
+#define CYCLE_BASE     UINT64_C(0x9e3779b97f4a7c15)
+#define CYCLE_BASE_INV UINT64_C(0xf1de83e19937733d)
+
+
+
+
+/* CycleT: Brent's cycle detection on hashed machine configurations
+//
+// A configuration is the state and the tape contents relative to the
+// head.  Its hash is
+//
+//   sum over frames i of  zobrist(frame i) * CYCLE_BASE^(i - here)
+//
+// with blank frames adding nothing, so the hash of a configuration
+// does not depend on where the head is, and a configuration that comes
+// back shifted along the tape hashes the same as the one it repeats.
+// 'hash' holds the sum with powers of i alone, which one write changes
+// by a single term; multiplied by 'power_inv' it gives the hash
+// relative to the head.
+//
+// Brent's algorithm keeps a single saved configuration and moves it
+// up to the current one after 1, 2, 4, 8, ... shifts, so the memory
+// used is one copy of the tape.  The saved tape is only compared
+// frame by frame when the hashes match.
+*/
+struct CycleS {
+  uint64_t  hash;      /* hash of the tape, with positions from 0 */
+  uint64_t  power;     /* CYCLE_BASE^here */
+  uint64_t  power_inv; /* CYCLE_BASE^-here */
+
+  int64_t   lam;       /* shifts since the configuration was saved */
+  int64_t   limit;     /* shifts before the saved configuration moves */
+
+  uint64_t  saved_hash;  /* hash of the saved configuration, from here */
+  State     saved_state; /* state of the saved configuration */
+  int64_t   saved_here;  /* head position of the saved configuration */
+  int64_t   saved_left;  /* head position of saved[0] */
+  int64_t   saved_len;   /* number of non-blank frames saved */
+  Char     *saved;       /* saved tape, from its first to its last
+                         // non-blank frame
+                         */
+  int64_t   saved_alloc; /* number of elements allocated for saved[] */
+
+  int64_t   period;    /* shifts in the cycle found, or 0 for none */
+  int64_t   shift;     /* frames the configuration moved in that time */
+  int64_t   compares;  /* number of frame by frame comparisons */
+};
+
+
+
+
+CycleT * cycleNew(void);
+void     cycleDestroy(CycleT *this);
+void     cyclePrint(const CycleT *this);
+int      cycleSimulateSteps(CycleT *this, TuringMachineT *tm, int64_t *iters,
+                            int64_t max_iters, int64_t tape_len_max,
+                            int64_t iter_test);
+
+
+
+#endif
@@ -0,0 +1,305 @@
+/* emit.c: Turing Machine simulators generated as C source code
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "emit.h"
+
+
+
+
+/* emit_prologue: everything in a generated simulator before the states
+//
+// The generated code keeps the head, and the leftmost and rightmost
+// frames visited, as pointers.  The tape grows by doubling whenever the
+// head reaches the first or last frame allocated, so the head never
+// leaves allocated memory.
+*/
+static const char * const emit_prologue[] = {
+  "static Frame  *tape;       /* tape memory */",
+  "static Frame  *tape_last;  /* last frame of tape memory */",
+  "static int64_t tape_alloc; /* number of frames allocated for tape[] */",
+  "static int64_t tape_origin;/* index into tape[] of head position 0 */",
+  "",
+  "",
+  "",
+  "",
+  "/* tapeGrow: double the tape, keeping the old frames in the middle */",
+  "static Frame *",
+  "tapeGrow(Frame *here, Frame **min, Frame **max)",
+  "{",
+  "  const int64_t shift = tape_alloc / 2;",
+  "  Frame        *grown;",
+  "",
+  "  if((grown = calloc(2 * tape_alloc, sizeof(Frame)))==NULL) {",
+  "    fprintf(stderr, \"tapeGrow: out of memory\\n\");",
+  "    exit(1);",
+  "  }",
+  "  memcpy(&grown[shift], tape, sizeof(Frame) * tape_alloc);",
+  "",
+  "  *min = &grown[*min - tape + shift];",
+  "  *max = &grown[*max - tape + shift];",
+  "  here = &grown[here - tape + shift];",
+  "",
+  "  free(tape);",
+  "  tape        = grown;",
+  "  tape_alloc *= 2;",
+  "  tape_last   = &tape[tape_alloc - 1];",
+  "  tape_origin += shift;",
+  "  return here;",
+  "}",
+  "",
+  "",
+  "",
+  "",
+  "/* STEP: count a shift in a state, unless max_iters is reached */",
+  "#define STEP(s) \\",
+  "  if(iters >= max_iters) { state = (s); goto limit; } \\",
+  "  iters ++",
+  "",
+  "/* LEFT, RIGHT: move the head, then go to the next state */",
+  "#define LEFT(next) \\",
+  "  here --; \\",
+  "  if(here < min) { \\",
+  "    min = here; \\",
+  "    if(here == tape) here = tapeGrow(here, &min, &max); \\",
+  "    if(max - min + 1 >= TAPE_LEN_MAX) { state = (next); goto limit; } \\",
+  "  } \\",
+  "  goto S ## next",
+  "",
+  "#define RIGHT(next) \\",
+  "  here ++; \\",
+  "  if(here > max) { \\",
+  "    max = here; \\",
+  "    if(here == tape_last) here = tapeGrow(here, &min, &max); \\",
+  "    if(max - min + 1 >= TAPE_LEN_MAX) { state = (next); goto limit; } \\",
+  "  } \\",
+  "  goto S ## next",
+  "",
+  "/* STOP: the machine stops in the next state */",
+  "#define STOP(next) \\",
+  "  state = (next); \\",
+  "  goto stopped",
+  "",
+  "",
+  "",
+  "",
+  "int",
+  "main(int argc, char **argv)",
+  "{",
+  "  int64_t  max_iters = INT64_MAX; /* maximum number of shifts */",
+  "  int64_t  iters     = 0;         /* number of shifts executed */",
+  "  int64_t  result;                /* same as the value of tmSimulate() */",
+  "  int64_t  ones      = 0;         /* number of 1's on the tape */",
+  "  int64_t  marks     = 0;         /* number of frames not blank */",
+  "  int      state     = 0;         /* current state */",
+  "  Frame   *here;                   /* frame under the tape head */",
+  "  Frame   *min;                    /* leftmost frame visited */",
+  "  Frame   *max;                    /* rightmost frame visited */",
+  "",
+  "  if(argc > 1) {",
+  "    max_iters = strtoll(argv[1], NULL, 0);",
+  "  }",
+  "",
+  "  tape_alloc = 4096;",
+  "  if((tape = calloc(tape_alloc, sizeof(Frame)))==NULL) {",
+  "    fprintf(stderr, \"%s: out of memory\\n\", argv[0]);",
+  "    exit(1);",
+  "  }",
+  "  tape_last = &tape[tape_alloc - 1];",
+  "  tape_origin = tape_alloc / 2;",
+  "  here = min = max = &tape[tape_origin];",
+  "",
+  NULL
+};
+
+
+
+
+/* emit_epilogue: everything in a generated simulator after the states */
+static const char * const emit_epilogue[] = {
+  "",
+  "stopped:",
+  "  result = iters;",
+  "  goto done;",
+  "",
+  "limit:",
+  "  result = (max - min + 1 >= TAPE_LEN_MAX) ? -2 : -1;",
+  "",
+  "done:",
+  "  printf(\"tape was %lli frames long\\n\", (long long) (max - min + 1));",
+  "  if(result >= 0) {",
+  "    printf(\"The machine executed %lli shifts\\n\", (long long) result);",
+  "    printf(\"tape had %lli 1's\\n\", (long long) ones);",
+  "  } else if(-1 == result) {",
+  "    printf(\"too many iterations\\n\");",
+  "  } else if(-2 == result) {",
+  "    printf(\"tape too long\\n\");",
+  "  }",
+  "  printf(\"final state %i, head at %lli\\n\", state,",
+  "         (long long) (here - tape - tape_origin));",
+  "",
+  "  free(tape);",
+  "  return 0;",
+  "}",
+  NULL
+};
+
+
+
+
+/* NAME
+//   emitLines: write lines of text, up to a NULL line
+*/
+static void
+emitLines(FILE *stream, const char * const *lines)
+{
+  for( ; *lines != NULL; lines++) {
+    fprintf(stream, "%s\n", *lines);
+  }
+}
+
+
+
+
+/* NAME
+//   tmTableEmitC: write a C program that simulates one Turing Machine
+//
+//
+// ARGUMENTS
+//   stream: where to write the C source code
+//
+//   machine_file: name of the file the machine was read from, for
+//   the comment at the top of the program
+//
+//   tape_len_max: the program stops when the tape is this long
+//
+//
+// DESCRIPTION
+//   The program simulates the machine on a blank tape exactly as
+//   tmSimulate() does, and prints the tape length, shift count and
+//   number of 1's the way "tm -V" does.  An optional argument to the
+//   program sets max_iters.
+//
+//   Nothing of the state transition table is left in the program but
+//   control flow: each state is a label, each input a case of a switch
+//   on the frame under the head, and each transition a write, a move,
+//   and a goto to the label of the next state.  The tape holds the
+//   narrowest unsigned integer type that holds charset_max.  Where a
+//   transition changes the number of 1's on the tape, or of frames that
+//   are not blank, it adds to or subtracts from a count of them.
+//
+//   If the machine has blank_test set, the program makes the same busy
+//   beaver test as tmSimulate() does.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success.
+//   Returns -1 if the table has a transition to a state that does not
+//   exist.
+//
+//
+// SEE ALSO
+//   tmSimulate(), tmTableWrite()
+*/
+int
+tmTableEmitC(const TuringMachineT *this, FILE *stream,
+             const char *machine_file, int64_t tape_len_max)
+{
+  const int64_t  iter_test = tmIterTest(this);
+  const char    *frame;
+  int            si;
+  int            ii;
+
+  for(si=0; si < this->num_states; si++) {
+    for(ii=0; ii <= this->charset_max; ii++) {
+      const State next = this->table[si][ii].next;
+
+      if((next < 0) || (next >= this->num_states)) {
+        fprintf(stderr, "tmTableEmitC: state %i input %i: no state %i\n",
+                si, ii, next);
+        return -1;
+      }
+    }
+  }
+
+  if(this->charset_max <= UINT8_MAX) {
+    frame = "uint8_t";
+  } else if(this->charset_max <= UINT16_MAX) {
+    frame = "uint16_t";
+  } else {
+    frame = "uint32_t";
+  }
+
+  fprintf(stream, "/* Turing Machine simulator for %s\n", machine_file);
+  fprintf(stream, "//\n");
+  fprintf(stream, "// Generated by tm --emit-c.  %i states, charset_max %i.\n",
+          this->num_states, this->charset_max);
+  fprintf(stream, "*/\n\n");
+
+  fprintf(stream, "#include <stdio.h>\n");
+  fprintf(stream, "#include <stdlib.h>\n");
+  fprintf(stream, "#include <string.h>\n");
+  fprintf(stream, "#include <stdint.h>\n\n\n\n\n");
+
+  fprintf(stream, "typedef %s Frame;\n\n", frame);
+  fprintf(stream, "#define TAPE_LEN_MAX %lli\n", (long long) tape_len_max);
+  fprintf(stream, "#define ITER_TEST %lli\n\n\n\n\n", (long long) iter_test);
+
+  emitLines(stream, emit_prologue);
+
+  for(si=0; si < this->num_states; si++) {
+    fprintf(stream, "S%i:\n", si);
+    if((0 == si) && (iter_test > 0)) {
+      /* Made after every shift that enters state 0 */
+      fprintf(stream, "  if((iters > 0) && (iters <= ITER_TEST) && !marks) {\n");
+      fprintf(stream, "    state  = 0;\n");
+      fprintf(stream, "    result = -3;\n");
+      fprintf(stream, "    goto done;\n");
+      fprintf(stream, "  }\n");
+    }
+    fprintf(stream, "  STEP(%i);\n", si);
+    fprintf(stream, "  switch(*here) {\n");
+    for(ii=0; ii <= this->charset_max; ii++) {
+      const Entry * const entry = &this->table[si][ii];
+      static const char * const move[] = { "LEFT", "RIGHT", "STOP" };
+
+      /* The last input is the default, so the switch covers every frame */
+      if(ii < this->charset_max) {
+        fprintf(stream, "    case %i:", ii);
+      } else {
+        fprintf(stream, "    default:");
+      }
+      if(entry->write != ii) {
+        fprintf(stream, " *here = %i;", entry->write);
+      }
+      if((1 == entry->write) && (1 != ii)) {
+        fprintf(stream, " ones ++;");
+      } else if((1 != entry->write) && (1 == ii)) {
+        fprintf(stream, " ones --;");
+      }
+      if((0 != entry->write) && (0 == ii)) {
+        fprintf(stream, " marks ++;");
+      } else if((0 == entry->write) && (0 != ii)) {
+        fprintf(stream, " marks --;");
+      }
+      fprintf(stream, " %s(%i);\n", move[entry->move], entry->next);
+    }
+    fprintf(stream, "  }\n");
+
+    fprintf(stream, "\n");
+  }
+
+  emitLines(stream, emit_epilogue);
+
+  return 0;
+}
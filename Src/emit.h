@@ -0,0 +1,22 @@
+/* emit.h: Turing Machine simulators generated as C source code
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _EMIT_H__INCLUDED_
+#define _EMIT_H__INCLUDED_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+int      tmTableEmitC(const TuringMachineT *this, FILE *stream,
+                      const char *machine_file, int64_t tape_len_max);
+
+
+
+#endif
@@ -0,0 +1,380 @@
+/* forktest.c: test that forked machines are isolated, and time a fork
+//
+// Provided as is.  No warrentees, express or implied.
+//
+// "make forktest" builds this program over libtm.a, and "make test"
+// runs it.  For each kind of tape (paged, 1-bit and 8-bit), it runs a
+// machine partway, forks it, and checks that neither machine, nor a
+// fork of the fork, sees what the others write.  Then it times
+// tmFork() and tmDestroy() against the length of the tape.  It exits
+// with status 1 if any check fails.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "tm.h"
+
+
+
+
+/* FORKTEST_SPLIT: shifts the parent runs before it is forked */
+#define FORKTEST_SPLIT 1000000
+
+/* FORKTEST_SHIFTS, FORKTEST_ONES: how bb-4098 ends */
+#define FORKTEST_SHIFTS 47176870
+#define FORKTEST_ONES   4098
+
+/* FORKTEST_TAPE_LEN_MAX: tape length no run here comes near */
+#define FORKTEST_TAPE_LEN_MAX ((int64_t) 1 << 30)
+
+
+
+
+/* forktest_bb4098: table of bb-4098.tm, the third input only for the
+// 8-bit tape, which needs charset_max 2.  The machine never reads a 2.
+*/
+static const Entry forktest_bb4098[5][3] = {
+  { {1, MOVE_LEFT,  1}, {1, MOVE_RIGHT, 2}, {1, STOP, 4} },
+  { {1, MOVE_LEFT,  2}, {1, MOVE_LEFT,  1}, {1, STOP, 4} },
+  { {1, MOVE_LEFT,  3}, {0, MOVE_RIGHT, 4}, {1, STOP, 4} },
+  { {1, MOVE_RIGHT, 0}, {1, MOVE_RIGHT, 3}, {1, STOP, 4} },
+  { {1, STOP,       4}, {0, MOVE_RIGHT, 0}, {1, STOP, 4} },
+};
+
+/* forktest_ones: table of a machine that writes 1's rightward forever */
+static const Entry forktest_ones[1][3] = {
+  { {1, MOVE_RIGHT, 0}, {1, MOVE_RIGHT, 0}, {1, MOVE_RIGHT, 0} },
+};
+
+
+
+
+/* ForkTestTapeT: what can be seen of a machine, to compare machines by */
+typedef struct {
+  State    state;
+  int64_t  here;
+  int64_t  left_end;
+  int64_t  right_end;
+  int64_t  ones;
+  Char    *frames;    /* frames[left_end..right_end], from frames[0] */
+} ForkTestTapeT;
+
+
+
+
+/* forkTestKind: name of each kind of tape tested */
+static const char * const forkTestKind[] = { "paged", "1-bit", "8-bit" };
+
+
+
+
+/* NAME
+//   forkTestNew: make a machine on a blank tape
+//
+//
+// ARGUMENTS
+//   rows (in): table, three inputs to a state
+//
+//   num_states (in): number of states in the table
+//
+//   kind (in): 0 for a paged tape, 1 for a 1-bit tape, 2 for an 8-bit
+//   tape; see forkTestKind
+//
+//
+// DESCRIPTION
+//   Sets the machine up as tmTableRead() and tmTapeBlank() would.
+//
+//
+// RETURN VALUE
+//   Returns the machine, or NULL if memory could not be had.
+*/
+static TuringMachineT *
+forkTestNew(const Entry (*rows)[3], State num_states, int kind)
+{
+  TuringMachineT *tm;
+  Entry          *table;
+  State           si;
+  Char            ii;
+
+  if((tm = tmNew())==NULL) return NULL;
+
+  tm->num_states  = num_states;
+  tm->charset_max = (2 == kind) ? 2 : 1;
+  tm->tape_width  = (2 == kind) ? 8 : 1;
+  tm->tape_paged  = (0 == kind);
+  tm->blank_test  = 0;
+
+  table = malloc(sizeof(Entry) * (tm->charset_max + 1) * num_states);
+  if(   (NULL == table)
+     || ((tm->table = malloc(sizeof(Entry *) * num_states))==NULL))
+  {
+    free(table);
+    tmDestroy(tm);
+    return NULL;
+  }
+  for(si = 0; si < num_states; si++) {
+    tm->table[si] = &table[si * (tm->charset_max + 1)];
+    for(ii = 0; ii <= tm->charset_max; ii++) {
+      tm->table[si][ii] = rows[si][ii];
+    }
+  }
+
+  if(   ((tm->symbol_count = calloc(tm->charset_max + 1, sizeof(int64_t)))
+         ==NULL)
+     || (tmTapeBlank(tm) < 0))
+  {
+    tmDestroy(tm);
+    return NULL;
+  }
+  return tm;
+}
+
+
+
+
+/* NAME
+//   forkTestLook: record what can be seen of a machine
+//
+//
+// RETURN VALUE
+//   Returns 0, or -1 if memory could not be had.
+*/
+static int
+forkTestLook(const TuringMachineT *tm, ForkTestTapeT *look)
+{
+  int64_t ti;
+
+  look->state     = tm->state;
+  look->here      = tm->here;
+  look->left_end  = tm->left_end;
+  look->right_end = tm->right_end;
+  look->ones      = tmTapeOneCount(tm);
+  look->frames    = malloc(sizeof(Char) * (tm->right_end - tm->left_end + 1));
+  if(NULL == look->frames) return -1;
+
+  for(ti = tm->left_end; ti <= tm->right_end; ti++) {
+    look->frames[ti - tm->left_end] = tmTapeFrameAt(tm, ti);
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   forkTestCheck: check that a machine looks as it did
+//
+//
+// RETURN VALUE
+//   Returns 0 if it does, and 1, after saying so, if it does not.
+*/
+static int
+forkTestCheck(const TuringMachineT *tm, const ForkTestTapeT *look,
+              int kind, const char *what)
+{
+  ForkTestTapeT now;
+  int           differ;
+
+  if(forkTestLook(tm, &now) < 0) {
+    fprintf(stderr, "forktest: out of memory\n");
+    return 1;
+  }
+  differ =    (now.state     != look->state)
+           || (now.here      != look->here)
+           || (now.left_end  != look->left_end)
+           || (now.right_end != look->right_end)
+           || (now.ones      != look->ones)
+           || memcmp(now.frames, look->frames,
+                     sizeof(Char) * (now.right_end - now.left_end + 1));
+  free(now.frames);
+
+  if(differ) {
+    printf("FAIL %s: %s\n", forkTestKind[kind], what);
+  }
+  return differ;
+}
+
+
+
+
+/* NAME
+//   forkTestIsolation: check that a parent, a fork and its fork are
+//   isolated from each other on one kind of tape
+//
+//
+// DESCRIPTION
+//   The parent runs bb-4098 for FORKTEST_SPLIT shifts and is forked,
+//   and the fork forked again.  The fork runs to the end, then the
+//   parent, then the fork of the fork.  Each must end as bb-4098 does,
+//   and whichever has not run yet must still look as the parent did
+//   when it was forked.  Changing the table of the fork must not change
+//   the table of the parent.
+//
+//
+// RETURN VALUE
+//   Returns the number of checks that failed.
+*/
+static int
+forkTestIsolation(int kind)
+{
+  TuringMachineT *parent, *fork = NULL, *grandchild = NULL;
+  ForkTestTapeT   split, end;
+  int64_t         shifts;
+  int             failed = 0;
+
+  split.frames = end.frames = NULL;
+
+  if(   ((parent = forkTestNew(forktest_bb4098, 5, kind))==NULL)
+     || (tmSimulate(parent, FORKTEST_SPLIT, FORKTEST_TAPE_LEN_MAX) != -1)
+     || (forkTestLook(parent, &split) < 0)
+     || ((fork = tmFork(parent))==NULL)
+     || ((grandchild = tmFork(fork))==NULL))
+  {
+    printf("FAIL %s: could not run and fork the parent\n",
+           forkTestKind[kind]);
+    failed = 1;
+    goto done;
+  }
+  failed += forkTestCheck(fork, &split, kind, "fork differs from parent");
+  failed += forkTestCheck(grandchild, &split, kind,
+                          "fork of fork differs from parent");
+
+  /* The fork runs to the end, and nothing else changes */
+  shifts = tmSimulate(fork, INT64_MAX, FORKTEST_TAPE_LEN_MAX);
+  if(   (shifts != FORKTEST_SHIFTS - FORKTEST_SPLIT)
+     || (tmTapeOneCount(fork) != FORKTEST_ONES))
+  {
+    printf("FAIL %s: fork ran %lli shifts to %lli 1's\n",
+           forkTestKind[kind], (long long) shifts,
+           (long long) tmTapeOneCount(fork));
+    failed ++;
+  }
+  failed += forkTestCheck(parent, &split, kind,
+                          "fork wrote to the parent's tape");
+  failed += forkTestCheck(grandchild, &split, kind,
+                          "fork wrote to its fork's tape");
+  if(forkTestLook(fork, &end) < 0) {
+    printf("FAIL %s: out of memory\n", forkTestKind[kind]);
+    failed ++;
+    goto done;
+  }
+
+  /* The table is the fork's own */
+  fork->table[0][0].write = 0;
+  if(parent->table[0][0].write != 1) {
+    printf("FAIL %s: fork changed the parent's table\n", forkTestKind[kind]);
+    failed ++;
+  }
+
+  /* The parent runs on to where the fork ended, and the fork stays */
+  tmSimulate(parent, INT64_MAX, FORKTEST_TAPE_LEN_MAX);
+  failed += forkTestCheck(parent, &end, kind,
+                          "parent ended unlike the fork");
+  failed += forkTestCheck(fork, &end, kind,
+                          "parent wrote to the fork's tape");
+  failed += forkTestCheck(grandchild, &split, kind,
+                          "parent wrote to its fork's fork's tape");
+
+  /* Last, the fork of the fork, on pages no one else holds by now */
+  tmDestroy(fork);
+  fork = NULL;
+  tmSimulate(grandchild, INT64_MAX, FORKTEST_TAPE_LEN_MAX);
+  failed += forkTestCheck(grandchild, &end, kind,
+                          "fork of fork ended unlike the fork");
+
+done:
+  free(split.frames);
+  free(end.frames);
+  tmDestroy(grandchild);
+  tmDestroy(fork);
+  tmDestroy(parent);
+
+  printf("%s tape: %s\n", forkTestKind[kind], failed ? "FAILED" : "isolated");
+  return failed;
+}
+
+
+
+
+/* NAME
+//   forkTestCost: time tmFork() and tmDestroy() against tape length
+//
+//
+// DESCRIPTION
+//   Writes 'frames' 1's on each kind of tape, then forks and destroys
+//   the machine over and over, and prints the time each pair took.
+//
+//
+// RETURN VALUE
+//   Returns 0, or 1 if a machine could not be made or forked.
+*/
+static int
+forkTestCost(int64_t frames)
+{
+  const int64_t reps = (frames < 100000000) ? (100000000 / frames) : 1;
+  int           kind;
+
+  printf("%12lli", (long long) frames);
+  for(kind = 0; kind < 3; kind++) {
+    TuringMachineT *tm = forkTestNew(forktest_ones, 1, kind);
+    clock_t         start;
+    int64_t         ri;
+
+    if(   (NULL == tm)
+       || (tmSimulate(tm, frames - 1, FORKTEST_TAPE_LEN_MAX) != -1))
+    {
+      printf("\nFAIL %s: could not write the tape\n", forkTestKind[kind]);
+      tmDestroy(tm);
+      return 1;
+    }
+
+    start = clock();
+    for(ri = 0; ri < reps; ri++) {
+      TuringMachineT *fork = tmFork(tm);
+
+      if(NULL == fork) {
+        printf("\nFAIL %s: could not fork\n", forkTestKind[kind]);
+        tmDestroy(tm);
+        return 1;
+      }
+      tmDestroy(fork);
+    }
+    printf(" %12.2f", 1e6 * (clock() - start) / CLOCKS_PER_SEC / reps);
+    tmDestroy(tm);
+  }
+  printf("\n");
+  return 0;
+}
+
+
+
+
+int
+main(int argc, char **argv)
+{
+  int64_t frames_max = 10000000;  /* longest tape to time a fork on */
+  int64_t frames;
+  int     failed = 0;
+  int     kind;
+
+  if(argc > 1) {
+    frames_max = strtoll(argv[1], NULL, 0);
+  }
+
+  for(kind = 0; kind < 3; kind++) {
+    failed += forkTestIsolation(kind);
+  }
+
+  printf("\nmicroseconds to fork and destroy a machine\n");
+  printf("%12s %12s %12s %12s\n", "tape frames",
+         forkTestKind[0], forkTestKind[1], forkTestKind[2]);
+  for(frames = 10000; frames <= frames_max; frames *= 10) {
+    failed += forkTestCost(frames);
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,839 @@
+/* hash.c: Turing Machine simulation with memoized hash-consed tape trees
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "hash.h"
+
+
+
+
+/* HASH_BOUNCES_MAX: most crossings between the halves of one node
+//
+// A machine can run forever without leaving a node.  Once the head has
+// crossed between the two halves of a node HASH_BOUNCES_MAX times, the
+// node is given up on and its result marked 'stuck'.
+*/
+#define HASH_BOUNCES_MAX 65536
+
+
+
+
+/* HASH_NODES_MAX: number of nodes beyond which all nodes are thrown out
+//
+// Nodes are never freed one at a time.  Instead, when there are too
+// many, the block tape is decoded, every node and memoized result is
+// thrown out, and the block tape is encoded again from scratch.
+*/
+#define HASH_NODES_MAX (1 << 24)
+
+
+
+
+/* BLOCK_OF: block number holding head position 'pos' (floor division) */
+#define BLOCK_OF(pos, size) \
+  (((pos) >= 0) ? ((pos) / (size)) : (((pos) + 1) / (size) - 1))
+
+
+
+
+/* hashClear: throw out every node and memoized result */
+static void
+hashClear(HashT *this)
+{
+  this->nodes = HASH_LEAVES;
+  memset(this->index, 0xff, sizeof(int32_t) << this->index_bits);
+  memset(this->memo, 0, sizeof(HashResultT) << this->memo_bits);
+}
+
+
+
+
+/* NAME
+//   hashNode: find the node made of nodes 'a' and 'b', or make one
+//
+//
+// DESCRIPTION
+//   hashNode() is called from deep inside hashRun() and hashBuild(), so
+//   rather than have every level of them check for failure, running out
+//   of memory sets the 'error' flag of 'this' and returns node 0.  The
+//   flag stays set until hashRecover(), and whatever was built while it
+//   was set must be thrown out.
+*/
+static int32_t
+hashNode(HashT *this, int32_t a, int32_t b)
+{
+  uint32_t mask = ((uint32_t)1 << this->index_bits) - 1;
+  uint32_t slot;
+  int32_t  n;
+
+  slot = (uint32_t)(((uint64_t)a * 0x9e3779b97f4a7c15ULL + (uint64_t)b)
+                    * 0xbf58476d1ce4e5b9ULL >> 32) & mask;
+
+  while((n = this->index[slot]) >= 0) {
+    if((this->left[n] == a) && (this->right[n] == b)) {
+      return n;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  if(this->nodes == this->node_alloc) {
+    const int32_t  alloc = 2 * this->node_alloc;
+    int32_t       *left;
+    int32_t       *right;
+
+    if((left = realloc(this->left, sizeof(int32_t) * alloc))==NULL) {
+      this->error = 1;
+      return 0;
+    }
+    this->left = left;
+    if((right = realloc(this->right, sizeof(int32_t) * alloc))==NULL) {
+      this->error = 1;
+      return 0;
+    }
+    this->right      = right;
+    this->node_alloc = alloc;
+  }
+
+  n = this->nodes ++;
+  this->left[n]  = a;
+  this->right[n] = b;
+  this->index[slot] = n;
+
+  /* Keep the index at most half full */
+  if(2 * (int64_t)this->nodes > ((int64_t)1 << this->index_bits)) {
+    int32_t *index;
+    int32_t  m;
+
+    if((index = realloc(this->index, sizeof(int32_t) << (this->index_bits + 1)))
+       ==NULL)
+    {
+      /* Node n is in the index; it only cannot take many more */
+      this->error = 1;
+      return n;
+    }
+    this->index = index;
+    this->index_bits ++;
+    memset(this->index, 0xff, sizeof(int32_t) << this->index_bits);
+
+    mask = ((uint32_t)1 << this->index_bits) - 1;
+    for(m = HASH_LEAVES; m < this->nodes; m++) {
+      slot = (uint32_t)(((uint64_t)this->left[m] * 0x9e3779b97f4a7c15ULL
+                         + (uint64_t)this->right[m])
+                        * 0xbf58476d1ce4e5b9ULL >> 32) & mask;
+      while(this->index[slot] >= 0) {
+        slot = (slot + 1) & mask;
+      }
+      this->index[slot] = m;
+    }
+  }
+
+  return n;
+}
+
+
+
+
+/* hashZero: make the all-blank node of each level
+//
+// Called after hashClear(), when there is always room for these nodes.
+*/
+static void
+hashZero(HashT *this)
+{
+  int level;
+
+  this->zero[0] = 0;
+  for(level = 1; level < 64; level++) {
+    this->zero[level] = hashNode(this, this->zero[level-1],
+                                 this->zero[level-1]);
+  }
+}
+
+
+
+
+/* NAME
+//   hashNew: allocate a new set of tape trees
+//
+//
+// ARGUMENTS
+//   level (in): log2 of the number of tape frames in each block, from 1
+//     to 30
+//
+//   memo_bits (in): log2 of the number of node results kept
+//
+//
+// RETURN VALUE
+//   Returns NULL if the arguments are bad or memory could not be
+//   allocated.
+*/
+HashT *
+hashNew(int level, int memo_bits)
+{
+  HashT *this;
+
+  if((level < 1) || (level > 30)) {
+    fprintf(stderr, "hashNew: level must be from 1 to 30\n");
+    return NULL;
+  }
+  if((memo_bits < 1) || (memo_bits > 30)) {
+    fprintf(stderr, "hashNew: memo_bits must be from 1 to 30\n");
+    return NULL;
+  }
+
+  if((this = calloc(1, sizeof(HashT))) == NULL) {
+    fprintf(stderr, "hashNew: out of memory\n");
+    return NULL;
+  }
+
+  this->level      = level;
+  this->memo_bits  = memo_bits;
+  this->node_alloc = 4 * HASH_LEAVES;
+  this->index_bits = 12;
+
+  this->left  = malloc(sizeof(int32_t) * this->node_alloc);
+  this->right = malloc(sizeof(int32_t) * this->node_alloc);
+  this->index = malloc(sizeof(int32_t) << this->index_bits);
+  this->memo  = malloc(sizeof(HashResultT) << this->memo_bits);
+
+  if(   (NULL == this->left) || (NULL == this->right)
+     || (NULL == this->index) || (NULL == this->memo))
+  {
+    fprintf(stderr, "hashNew: out of memory\n");
+    hashDestroy(this);
+    return NULL;
+  }
+
+  /* The level 0 nodes have no halves */
+  memset(this->left,  0xff, sizeof(int32_t) * HASH_LEAVES);
+  memset(this->right, 0xff, sizeof(int32_t) * HASH_LEAVES);
+
+  hashClear(this);
+  hashZero(this);
+
+  return this;
+}
+
+
+
+
+void
+hashDestroy(HashT *this)
+{
+  if(this != NULL) {
+    free(this->left);
+    free(this->right);
+    free(this->index);
+    free(this->memo);
+    free(this->blocks);
+    free(this);
+  }
+}
+
+
+
+
+/* NAME
+//   hashStepsString: write a wide shift count in decimal
+//
+//
+// ARGUMENTS
+//   string (out): at least 40 characters
+*/
+static char *
+hashStepsString(HashSteps steps, char *string)
+{
+  char digits[40];
+  int  di = 0;
+  int  si = 0;
+
+  do {
+    digits[di++] = '0' + (int)(steps % 10);
+    steps /= 10;
+  } while(steps > 0);
+
+  while(di > 0) {
+    string[si++] = digits[--di];
+  }
+  string[si] = '\0';
+
+  return string;
+}
+
+
+
+
+void
+hashPrint(const HashT *this)
+{
+  const int64_t memory =   (int64_t)this->node_alloc * 2 * sizeof(int32_t)
+                         + ((int64_t)sizeof(int32_t) << this->index_bits)
+                         + ((int64_t)sizeof(HashResultT) << this->memo_bits)
+                         + this->block_alloc * (int64_t)sizeof(int32_t);
+  char steps[40];
+
+  printf("hash: level %i, %lli nodes, %lli lookups, %lli hits (%.1f%%), "
+         "%lli resets\n",
+         this->level, (long long) this->nodes, (long long) this->lookups,
+         (long long) this->hits,
+         this->lookups ? (100.0 * this->hits / this->lookups) : 0.0,
+         (long long) this->resets);
+  printf("hash: %s shifts taken by blocks, %.1f MB memory\n",
+         hashStepsString(this->steps, steps), memory / 1048576.0);
+}
+
+
+
+
+/* NAME
+//   hashReserve: make sure the block tape holds block b
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails, in
+//   which case the block tape is unchanged.
+//
+//
+// SEE ALSO
+//   tmTapeReserve()
+*/
+static int
+hashReserve(HashT *this, int64_t b)
+{
+  const int32_t zero = this->zero[this->level];
+  int64_t       bi;
+  int64_t       i;
+
+  if(NULL == this->blocks) {
+    if((this->blocks = malloc(64 * sizeof(int32_t)))==NULL) {
+      return -1;
+    }
+    for(i = 0; i < 64; i++) this->blocks[i] = zero;
+    this->block_alloc  = 64;
+    this->block_origin = 32 - b;
+  }
+
+  bi = b + this->block_origin;
+
+  if(bi < 0) {
+    const int64_t  grow = MAX(this->block_alloc, -bi);
+    int32_t       *blocks;
+
+    if((blocks = malloc(sizeof(int32_t) * (this->block_alloc + grow)))
+       ==NULL)
+    {
+      return -1;
+    }
+    for(i = 0; i < grow; i++) blocks[i] = zero;
+    memcpy(&blocks[grow], this->blocks, sizeof(int32_t) * this->block_alloc);
+    free(this->blocks);
+
+    this->blocks        = blocks;
+    this->block_alloc  += grow;
+    this->block_origin += grow;
+
+  } else if(bi >= this->block_alloc) {
+    const int64_t  grow = MAX(this->block_alloc, bi - this->block_alloc + 1);
+    int32_t       *blocks;
+
+    if((blocks = realloc(this->blocks,
+                         sizeof(int32_t) * (this->block_alloc + grow)))
+       ==NULL)
+    {
+      return -1;
+    }
+    for(i = 0; i < grow; i++) blocks[this->block_alloc + i] = zero;
+
+    this->blocks       = blocks;
+    this->block_alloc += grow;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   hashRecover: throw out everything built since memory ran out
+//
+//
+// DESCRIPTION
+//   Nodes made after the 'error' flag was set may be node 0 standing in
+//   for a node that could not be made, and so may the results memoized
+//   from them.  hashRecover() throws out every node and memoized result
+//   and clears the flag, leaving 'this' ready for another run.  The
+//   block tape must be loaded again.
+*/
+static void
+hashRecover(HashT *this)
+{
+  hashClear(this);
+  hashZero(this);
+  this->error = 0;
+}
+
+
+
+
+/* hashBuild: make the node of 'level' for the frames starting at 'pos' */
+static int32_t
+hashBuild(HashT *this, const TuringMachineT *tm, int level, int64_t pos)
+{
+  const int64_t size = (int64_t)1 << level;
+
+  if((pos > tm->right_end) || (pos + size - 1 < tm->left_end)) {
+    return this->zero[level];
+  }
+
+  if(0 == level) {
+    return (unsigned char) tmTapeFrameAt(tm, pos);
+  }
+
+  return hashNode(this, hashBuild(this, tm, level - 1, pos),
+                        hashBuild(this, tm, level - 1, pos + size / 2));
+}
+
+
+
+
+/* NAME
+//   hashLoad: encode the Turing Machine tape into blocks of trees
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+hashLoad(HashT *this, const TuringMachineT *tm)
+{
+  const int64_t size = (int64_t)1 << this->level;
+  int64_t       b;
+  int64_t       i;
+
+  for(i = 0; i < this->block_alloc; i++) {
+    this->blocks[i] = this->zero[this->level];
+  }
+
+  if(hashReserve(this, BLOCK_OF(tm->here, size)) < 0) {
+    return -1;
+  }
+
+  for(b = BLOCK_OF(tm->left_end, size); b <= BLOCK_OF(tm->right_end, size);
+      b++)
+  {
+    if(hashReserve(this, b) < 0) {
+      return -1;
+    }
+    this->blocks[b + this->block_origin]
+      = hashBuild(this, tm, this->level, b * size);
+  }
+
+  return this->error ? -1 : 0;
+}
+
+
+
+
+/* hashWrite: decode the frames of 'node' of 'level' starting at 'pos'
+//
+// Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+hashWrite(const HashT *this, TuringMachineT *tm, int level, int32_t node,
+          int64_t pos)
+{
+  if(node == this->zero[level]) {
+    return 0;
+  }
+
+  if(0 == level) {
+    if((pos >= tm->left_end) && (pos <= tm->right_end)) {
+      tm->here = pos;
+      return tmTapeFrameSet(tm, (Char) node);
+    }
+    return 0;
+  }
+
+  if(hashWrite(this, tm, level - 1, this->left[node],  pos) < 0) {
+    return -1;
+  }
+  return hashWrite(this, tm, level - 1, this->right[node],
+                   pos + ((int64_t)1 << (level - 1)));
+}
+
+
+
+
+/* NAME
+//   hashUnload: decode the blocks of trees onto the Turing Machine tape
+//
+//
+// DESCRIPTION
+//   The head position and the extent of the tape (left_end, right_end)
+//   must already be up to date.  Every frame within that extent is
+//   written.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+hashUnload(const HashT *this, TuringMachineT *tm)
+{
+  const int64_t size   = (int64_t)1 << this->level;
+  const int64_t here   = tm->here;
+  int           status = 0;
+  int64_t       pos;
+  int64_t       bi;
+
+  if(tmTapeReserve(tm, tm->left_end, tm->right_end) < 0) {
+    return -1;
+  }
+
+  for(pos = tm->left_end; (0 == status) && (pos <= tm->right_end); pos++) {
+    tm->here = pos;
+    status = tmTapeFrameSet(tm, 0);
+  }
+
+  for(bi = 0; (0 == status) && (bi < this->block_alloc); bi++) {
+    status = hashWrite(this, tm, this->level, this->blocks[bi],
+                       (bi - this->block_origin) * size);
+  }
+
+  tm->here = here;
+  return status;
+}
+
+
+
+
+/* NAME
+//   hashRun: find what the machine does to a tree node
+//
+//
+// ARGUMENTS
+//   level (in): level of 'node'
+//
+//   node (in): tree node the head is in
+//
+//   state (in): state on entry
+//
+//   offset (in): head offset within the node on entry
+//
+//   result (out): what the machine did.  See HashResultT.
+//
+//
+// DESCRIPTION
+//   A level 0 node is a single frame, and takes a single shift.  The
+//   head within a larger node is always in one of its halves.  hashRun
+//   finds what the machine does to that half, recursively, and then to
+//   whichever half the head crosses into, and so on until the head
+//   leaves the node, the machine stops, or the head crosses between the
+//   halves HASH_BOUNCES_MAX times.
+//
+//   Results for a head entering a node at either end are memoized, so
+//   the same tape segment visited the same way again costs one lookup,
+//   and so do all of its parts visited along the way.  Larger and
+//   larger segments repeat as the simulation goes on, so this saves
+//   more the longer the machine runs.
+//
+//   The table must be compiled.
+*/
+static void
+hashRun(HashT *this, const TuringMachineT *tm, int level, int32_t node,
+        State state, int64_t offset, HashResultT *result)
+{
+  const int64_t line_length = tm->charset_max + 1;
+  const int64_t size        = (int64_t)1 << level;
+  const int64_t half        = size / 2;
+  const int     side        = (offset == 0) ? 0 : 1;
+  const int     memoize     = (offset == 0) || (offset == size - 1);
+  const State   state_in    = state;
+  HashResultT  *memo        = NULL;
+  HashSteps     steps       = 0;
+  int64_t       lo          = offset;
+  int64_t       hi          = offset;
+  int32_t       a;
+  int32_t       b;
+  int           bounces     = 0;
+  int           stop        = 0;
+  int           stuck       = 0;
+
+  if(0 == level) {
+    const Op      op    = tm->program[state * line_length + node];
+    const int32_t delta = OP_DELTA(op);
+
+    result->steps  = 1;
+    result->exit   = delta;
+    result->lo     = 0;
+    result->hi     = 0;
+    result->node   = node;
+    result->result = (unsigned char) OP_WRITE(op);
+    result->state  = state;
+    result->next   = OP_ROW(op) / line_length;
+    result->side   = 0;
+    result->stop   = (0 == delta);
+    result->stuck  = 0;
+    return;
+  }
+
+  if(memoize) {
+    const uint64_t key = ((uint64_t)node << 32) | ((uint64_t)state << 1) | side;
+
+    memo = &this->memo[(key * 0x9e3779b97f4a7c15ULL)
+                       >> (64 - this->memo_bits)];
+    this->lookups ++;
+    if(   memo->steps && (memo->node == node) && (memo->state == state)
+       && (memo->side == side))
+    {
+      this->hits ++;
+      *result = *memo;
+      return;
+    }
+  }
+
+  a = this->left[node];
+  b = this->right[node];
+
+  for(;;) {
+    HashResultT sub;
+    int64_t     base;
+
+    if(offset < half) {
+      base = 0;
+      hashRun(this, tm, level - 1, a, state, offset, &sub);
+      a = sub.result;
+    } else {
+      base = half;
+      hashRun(this, tm, level - 1, b, state, offset - half, &sub);
+      b = sub.result;
+    }
+
+    steps  = (steps + sub.steps < steps) ? (HashSteps)-1 : steps + sub.steps;
+    state  = sub.next;
+    lo     = MIN(lo, base + sub.lo);
+    hi     = MAX(hi, base + sub.hi);
+    offset = base + sub.exit;
+
+    if(sub.stop || sub.stuck) {
+      stop  = sub.stop;
+      stuck = sub.stuck;
+      break;
+    }
+    if((offset < 0) || (offset >= size)) {
+      break;
+    }
+    if(++bounces >= HASH_BOUNCES_MAX) {
+      stuck = 1;
+      break;
+    }
+  }
+
+  result->steps  = steps;
+  result->exit   = offset;
+  result->lo     = lo;
+  result->hi     = hi;
+  result->node   = node;
+  result->result = hashNode(this, a, b);
+  result->state  = state_in;
+  result->next   = state;
+  result->side   = side;
+  result->stop   = stop;
+  result->stuck  = stuck;
+
+  if(memoize) {
+    *memo = *result;
+  }
+}
+
+
+
+
+/* NAME
+//   hashRunBlocks: run the Turing Machine on the block tape
+//
+//
+// DESCRIPTION
+//   Finds what the machine does to the block under the head (see
+//   hashRun), and moves on to the next block, until the machine stops,
+//   or until the next block result would take *iters past max_iters or
+//   the tape to tape_len_max, or the head gets stuck in a block.
+//
+//   The state, head position and tape extent of the Turing Machine are
+//   kept up to date, but its tape is not; see hashUnload.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine stopped.
+//   Returns -1 if the memory allocation fails.  The machine is then left
+//   before the block that needed the memory, with the block tape
+//   already decoded onto its tape, and 'this' must be loaded again.
+//   Returns 0 otherwise.
+*/
+static int
+hashRunBlocks(HashT *this, TuringMachineT *tm, int64_t *iters,
+              int64_t max_iters, int64_t tape_len_max)
+{
+  const int64_t size   = (int64_t)1 << this->level;
+  int64_t       b      = BLOCK_OF(tm->here, size);
+  int64_t       offset = tm->here - b * size;
+
+  while(*iters < max_iters) {
+    HashResultT   result;
+    int64_t       left_end;
+    int64_t       right_end;
+
+    if(hashReserve(this, b) < 0) {
+      this->error = 1;
+      break;
+    }
+    hashRun(this, tm, this->level, this->blocks[b + this->block_origin],
+            tm->state, offset, &result);
+    if(this->error) {
+      break;
+    }
+
+    left_end  = MIN(tm->left_end,  b * size + result.lo);
+    right_end = MAX(tm->right_end, b * size + result.hi);
+
+    if(   result.stuck
+       || (result.steps > (HashSteps)(max_iters - *iters))
+       || (right_end - left_end + 1 >= tape_len_max))
+    {
+      /* Leave the rest to single shifts */
+      break;
+    }
+
+    this->blocks[b + this->block_origin] = result.result;
+    this->steps   += result.steps;
+    *iters        += (int64_t) result.steps;
+    tm->state      = result.next;
+    tm->left_end   = left_end;
+    tm->right_end  = right_end;
+    tm->tape_len   = right_end - left_end + 1;
+
+    if(result.stop) {
+      tm->here = b * size + result.exit;
+      return 1;
+    } else if(result.exit < 0) {
+      b --;
+      offset = size - 1;
+    } else {
+      b ++;
+      offset = 0;
+    }
+    tm->here = b * size + offset;
+
+    if(this->nodes > HASH_NODES_MAX) {
+      /* Throw out every node and start again from the tape */
+      if(hashUnload(this, tm) < 0) {
+        return -1;
+      }
+      hashClear(this);
+      hashZero(this);
+      this->resets ++;
+      if(hashLoad(this, tm) < 0) {
+        return -1;
+      }
+    }
+  }
+
+  tm->here = b * size + offset;
+
+  if(this->error) {
+    /* The blocks are as they were before the block that failed */
+    hashUnload(this, tm);
+    return -1;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmHashSimulate: perform a Turing Machine simulation using memoized
+//   tape trees
+//
+//
+// DESCRIPTION
+//   The tape is cut into blocks of 2^level frames, and each block is
+//   kept as a binary tree of hash-consed nodes (see HashT).  What the
+//   machine does to each node it enters is memoized by hashRun, so a
+//   tape segment the machine has already been through the same way is
+//   crossed with a single lookup however many shifts that took.
+//
+//   Shift counts are exact.  When a block would run past max_iters or
+//   tape_len_max, or the head stays in one block too long (see
+//   HASH_BOUNCES_MAX), the blocks are decoded back onto the Turing
+//   Machine tape and the rest of the simulation is done one shift at a
+//   time, so that shift counts, final tapes and return values are
+//   identical to those of tmSimulate().
+//
+//   Memoized results depend on the state transition table, so 'hash'
+//   must not be reused after the table changes.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), hashRun()
+*/
+int64_t
+tmHashSimulate(TuringMachineT *this, HashT *hash, int64_t max_iters,
+               int64_t tape_len_max)
+{
+  int64_t iters  = 0;
+  int     status = 0;
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  if((0 == status) && (iters < max_iters) && (this->tape_len < tape_len_max))
+  {
+    if(hashLoad(hash, this) < 0) {
+      hashRecover(hash);
+      return -4;
+    }
+    status = hashRunBlocks(hash, this, &iters, max_iters, tape_len_max);
+    if(status < 0) {
+      hashRecover(hash);
+      return -4;
+    }
+    if(hashUnload(hash, this) < 0) {
+      return -4;
+    }
+
+    if(0 == status) {
+      /* Finish the rest one shift at a time */
+      status = tmSimulateSteps(this, &iters, max_iters, max_iters,
+                               tape_len_max, 0);
+    }
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
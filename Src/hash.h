@@ -0,0 +1,120 @@
+/* hash.h: Turing Machine simulation with memoized hash-consed tape trees
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _HASH_H__INCLUDED_
+#define _HASH_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* HashSteps: shift counter wide enough for the largest tree node
+//
+// A node of level L can take vastly more than 2^64 shifts before the
+// head leaves it, so shift counts within the tree are kept in 128 bits
+// where the compiler has them.
+*/
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 HashSteps;
+#else
+typedef uint64_t HashSteps;
+#endif
+
+
+
+
+/* HASH_LEVEL: log2 of the number of tape frames in each block */
+#define HASH_LEVEL 12
+
+
+
+
+/* HASH_LEAVES: number of level 0 nodes, one for each possible symbol */
+#define HASH_LEAVES 128
+
+
+
+
+/* HashResultT: what the machine does to a tree node
+//
+// The key is (node, state, side).  The head enters a node at its left
+// or right end.  The rest describes the machine at the moment its head
+// leaves the node, or stops inside it.
+*/
+typedef struct {
+  HashSteps steps;  /* shifts taken.  Zero means this slot is empty. */
+  int64_t   exit;   /* head offset when the head leaves (-1 or node size),
+                    // or where the machine stopped.
+                    */
+  int64_t   lo;     /* leftmost head offset visited */
+  int64_t   hi;     /* rightmost head offset visited */
+  int32_t   node;   /* key: tree node on entry */
+  int32_t   result; /* tree node when the head leaves */
+  State     state;  /* key: state on entry */
+  State     next;   /* state when the head leaves, or after stopping */
+  int8_t    side;   /* key: 0 if the head entered at the left end,
+                    // 1 if at the right end
+                    */
+  int8_t    stop;   /* flag: machine stopped inside the node */
+  int8_t    stuck;  /* flag: head did not leave the node within
+                    // HASH_BOUNCES_MAX crossings between its halves
+                    */
+} HashResultT;
+
+
+
+
+/* HashT: hash-consed tree nodes, memoized results, and the block tape
+//
+// Node n of level L >= 1 covers 2^L tape frames, and is made of node
+// left[n] (the first 2^(L-1) frames) and node right[n] (the rest).
+// Nodes 0 to HASH_LEAVES-1 are the level 0 nodes, each a single frame
+// holding that symbol.  Each distinct (left, right) pair is stored
+// exactly once, so equal tape segments are equal node numbers.
+*/
+typedef struct {
+  int          level;        /* log2 of block size, in tape frames */
+
+  int32_t     *left;         /* left half of each node */
+  int32_t     *right;        /* right half of each node */
+  int32_t      nodes;        /* number of nodes */
+  int32_t      node_alloc;   /* number of elements allocated for left[] */
+  int32_t     *index;        /* open-addressed set of node numbers */
+  int32_t      index_bits;   /* log2 of the number of slots in index[] */
+  int32_t      zero[64];     /* all-blank node of each level */
+
+  int          memo_bits;    /* log2 of the number of memo slots */
+  HashResultT *memo;         /* direct-mapped table of node results */
+
+  int32_t     *blocks;       /* block tape: block b holds head positions
+                             // b<<level to (b<<level) + (1<<level) - 1,
+                             // stored at blocks[b + block_origin]
+                             */
+  int64_t      block_origin; /* index into blocks[] of block 0 */
+  int64_t      block_alloc;  /* number of elements allocated for blocks[] */
+
+  int64_t      lookups;      /* number of memo lookups */
+  int64_t      hits;         /* number of lookups found in the memo */
+  int64_t      resets;       /* number of times the nodes were thrown out */
+  HashSteps    steps;        /* shifts taken by block results */
+
+  int          error;        /* flag: memory ran out making a node */
+} HashT;
+
+
+
+
+HashT *  hashNew(int level, int memo_bits);
+void     hashDestroy(HashT *this);
+void     hashPrint(const HashT *this);
+int64_t  tmHashSimulate(TuringMachineT *this, HashT *hash, int64_t max_iters,
+                        int64_t tape_len_max);
+
+
+
+#endif
@@ -0,0 +1,793 @@
+/* jit.c: Turing Machine simulation by native code compiled at run time
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+
+
+
+#include "tm.h"
+#include "jit.h"
+
+
+
+
+/* JitCodeF: entry point of the native code
+//
+// Runs the machine from regs->state until it stops or has taken
+// regs->budget shifts, and stores the registers back into *regs.
+// Returns 1 if the machine stopped, 0 otherwise.
+*/
+typedef int (*JitCodeF)(JitRegsT *regs);
+
+
+
+
+/* NAME
+//   jitNew: allocate a new JIT engine
+//
+//
+// DESCRIPTION
+//   The native code is compiled by tmJitSimulate(), once the state
+//   transition table is known.
+//
+//
+// RETURN VALUE
+//   Returns NULL if memory could not be allocated.
+*/
+JitT *
+jitNew(void)
+{
+  JitT *this;
+
+  if((this = calloc(1, sizeof(JitT))) == NULL) {
+    fprintf(stderr, "jitNew: out of memory\n");
+    return NULL;
+  }
+
+  return this;
+}
+
+
+
+
+/* NAME
+//   jitFree: release the native code
+*/
+static void
+jitFree(JitT *this)
+{
+#ifdef JIT_X86_64
+  if(this->code != NULL) {
+    munmap(this->code, this->code_size);
+  }
+#endif
+  this->code      = NULL;
+  this->code_size = 0;
+}
+
+
+
+
+void
+jitDestroy(JitT *this)
+{
+  if(this != NULL) {
+    jitFree(this);
+    free(this->tape);
+    free(this);
+  }
+}
+
+
+
+
+void
+jitPrint(const JitT *this)
+{
+  if(this->native) {
+    printf("jit: %lu bytes of native code, %lli shifts in %lli batches\n",
+           (unsigned long) this->code_size, (long long) this->shifts,
+           (long long) this->batches);
+  } else {
+    printf("jit: native code did not run\n");
+  }
+}
+
+
+
+
+#ifdef JIT_X86_64
+/* JitEmitT: x86-64 code being emitted into a buffer */
+typedef struct {
+  unsigned char *code;  /* start of the buffer */
+  size_t         size;  /* bytes in the buffer */
+  size_t         pc;    /* offset of the next byte to emit */
+} JitEmitT;
+
+
+
+
+/* NAME
+//   jitEmit: append bytes of machine code
+//
+//
+// DESCRIPTION
+//   Bytes past the end of the buffer are counted but not written, so
+//   the caller can tell that the buffer was too small by comparing pc
+//   with size afterwards.
+*/
+static void
+jitEmit(JitEmitT *e, const unsigned char *bytes, size_t len)
+{
+  if(e->pc + len <= e->size) {
+    memcpy(&e->code[e->pc], bytes, len);
+  }
+  e->pc += len;
+}
+
+
+
+
+/* jitEmit1, jitEmit32, jitEmit64: append a byte, 32-bit or 64-bit word */
+static void
+jitEmit1(JitEmitT *e, unsigned char b)
+{
+  jitEmit(e, &b, 1);
+}
+
+
+static void
+jitEmit32(JitEmitT *e, uint32_t w)
+{
+  unsigned char bytes[4];
+  int           i;
+
+  for(i = 0; i < 4; i++) bytes[i] = (unsigned char) (w >> (8 * i));
+  jitEmit(e, bytes, 4);
+}
+
+
+static void
+jitEmit64(JitEmitT *e, uint64_t w)
+{
+  jitEmit32(e, (uint32_t) w);
+  jitEmit32(e, (uint32_t) (w >> 32));
+}
+
+
+
+
+/* NAME
+//   jitPatch: point the rel32 operand at offset 'at' to offset 'target'
+*/
+static void
+jitPatch(JitEmitT *e, size_t at, size_t target)
+{
+  const uint32_t rel = (uint32_t) ((int64_t) target - (int64_t) (at + 4));
+  int            i;
+
+  if(at + 4 <= e->size) {
+    for(i = 0; i < 4; i++) e->code[at + i] = (unsigned char) (rel >> (8*i));
+  }
+}
+
+
+
+
+/* NAME
+//   jitJump: emit a 2-byte-opcode or 1-byte-opcode jump with a rel32
+//
+//
+// RETURN VALUE
+//   Returns the offset of the rel32 operand, for jitPatch().
+*/
+static size_t
+jitJump(JitEmitT *e, const unsigned char *opcode, size_t len, size_t target)
+{
+  size_t at;
+
+  jitEmit(e, opcode, len);
+  at = e->pc;
+  jitEmit32(e, 0);
+  jitPatch(e, at, target);
+  return at;
+}
+
+
+
+
+/* NAME
+//   jitEmitExit: emit code that stores the registers and returns
+//
+//
+// DESCRIPTION
+//   On entry to the emitted code, eax holds the state.  The code stores
+//   the registers into the JitRegsT pointed to by r10 and returns
+//   'status'.
+*/
+static void
+jitEmitExit(JitEmitT *e, uint32_t status)
+{
+  static const unsigned char store[] = {
+    0x41, 0x89, 0x42, 0x20,  /* mov [r10+32], eax */
+    0x49, 0x89, 0x3a,        /* mov [r10], rdi */
+    0x49, 0x89, 0x72, 0x08,  /* mov [r10+8], rsi */
+    0x49, 0x89, 0x52, 0x10,  /* mov [r10+16], rdx */
+    0x49, 0x89, 0x4a, 0x18,  /* mov [r10+24], rcx */
+  };
+
+  jitEmit(e, store, sizeof(store));
+  jitEmit1(e, 0xb8);         /* mov eax, status */
+  jitEmit32(e, status);
+  jitEmit1(e, 0xc3);         /* ret */
+}
+
+
+
+
+/* NAME
+//   jitAssemble: emit native code for the compiled program of a machine
+//
+//
+// DESCRIPTION
+//   Register use in the emitted code:
+//     rdi  frame under the head
+//     rsi  leftmost frame visited
+//     rdx  rightmost frame visited
+//     rcx  shift budget
+//     r10  JitRegsT pointer
+//     eax  frame just read, or state on exit
+//
+//   The code for each state is
+//
+//     S:    sub rcx, 1 ; jb X            -- out of budget
+//           movzx eax, byte [rdi]
+//           (dispatch on eax to T0, T1, ...)
+//     Tc:   mov byte [rdi], write
+//           inc rdi ; cmp rdi, rdx ; cmova rdx, rdi   -- or dec, cmovb
+//           jmp next
+//     X:    xor ecx, ecx ; mov eax, S ; jmp budget_exit
+//
+//   Machines with at most 4 symbols dispatch with a chain of compares,
+//   others through a table of addresses.  A stop transition writes,
+//   sets the state, and jumps to stop_exit without moving.
+//
+//   Jumps to states are patched once every state has been emitted.
+//
+//
+// RETURN VALUE
+//   Returns the number of bytes needed.  Nothing past e->size is
+//   written, so if the return value is larger than e->size the code
+//   must be assembled again into a larger buffer.
+*/
+static size_t
+jitAssemble(JitEmitT *e, const TuringMachineT *tm, size_t *state_at,
+            size_t *fixup_at, int32_t *fixup_state)
+{
+  static const unsigned char prologue[] = {
+    0x49, 0x89, 0xfa,        /* mov r10, rdi */
+    0x49, 0x8b, 0x3a,        /* mov rdi, [r10] */
+    0x49, 0x8b, 0x72, 0x08,  /* mov rsi, [r10+8] */
+    0x49, 0x8b, 0x52, 0x10,  /* mov rdx, [r10+16] */
+    0x49, 0x8b, 0x4a, 0x18,  /* mov rcx, [r10+24] */
+    0x41, 0x8b, 0x42, 0x20,  /* mov eax, [r10+32] */
+  };
+  static const unsigned char jb[]    = { 0x0f, 0x82 };
+  static const unsigned char je[]    = { 0x0f, 0x84 };
+  static const unsigned char jmp[]   = { 0xe9 };
+  static const unsigned char entry[] = {
+    0x48, 0x83, 0xe9, 0x01,  /* sub rcx, 1 */
+  };
+  static const unsigned char load[]  = {
+    0x0f, 0xb6, 0x07,        /* movzx eax, byte [rdi] */
+  };
+  static const unsigned char right[] = {
+    0x48, 0xff, 0xc7,        /* inc rdi */
+    0x48, 0x39, 0xd7,        /* cmp rdi, rdx */
+    0x48, 0x0f, 0x47, 0xd7,  /* cmova rdx, rdi */
+  };
+  static const unsigned char left[]  = {
+    0x48, 0xff, 0xcf,        /* dec rdi */
+    0x48, 0x39, 0xf7,        /* cmp rdi, rsi */
+    0x48, 0x0f, 0x42, 0xf7,  /* cmovb rsi, rdi */
+  };
+  const int32_t     line_length = tm->charset_max + 1;
+  const int         chain       = (line_length <= 4);
+  size_t            state_table;
+  size_t            budget_exit;
+  size_t            stop_exit;
+  size_t            fixups      = 0;
+  size_t            fi;
+  int32_t           s;
+
+  e->pc = 0;
+
+  jitEmit(e, prologue, sizeof(prologue));
+  jitEmit1(e, 0x49);          /* mov r11, state_table */
+  jitEmit1(e, 0xbb);
+  state_table = e->pc;
+  jitEmit64(e, 0);
+  jitEmit1(e, 0x41);          /* jmp [r11 + rax*8] */
+  jitEmit1(e, 0xff);
+  jitEmit1(e, 0x24);
+  jitEmit1(e, 0xc3);
+
+  budget_exit = e->pc;
+  jitEmitExit(e, 0);
+  stop_exit = e->pc;
+  jitEmitExit(e, 1);
+
+  for(s = 0; s < tm->num_states; s++) {
+    size_t  exit_at;
+    size_t  symbol_table = 0;
+    size_t  case_at[128];
+    size_t  case_jump[128];
+    int32_t c;
+
+    state_at[s] = e->pc;
+    jitEmit(e, entry, sizeof(entry));
+    exit_at = jitJump(e, jb, sizeof(jb), 0);
+    jitEmit(e, load, sizeof(load));
+
+    if(chain) {
+      /* The last symbol falls through to its own transition */
+      for(c = 0; c < line_length - 1; c++) {
+        jitEmit1(e, 0x3c);    /* cmp al, c */
+        jitEmit1(e, (unsigned char) c);
+        case_jump[c] = jitJump(e, je, sizeof(je), 0);
+      }
+    } else {
+      jitEmit1(e, 0x49);      /* mov r8, symbol_table */
+      jitEmit1(e, 0xb8);
+      symbol_table = e->pc;
+      jitEmit64(e, 0);
+      jitEmit1(e, 0x41);      /* jmp [r8 + rax*8] */
+      jitEmit1(e, 0xff);
+      jitEmit1(e, 0x24);
+      jitEmit1(e, 0xc0);
+    }
+
+    for(c = line_length - 1; c >= 0; c--) {
+      const Op      op    = tm->program[s * line_length + c];
+      const int32_t next  = OP_ROW(op) / line_length;
+      const int32_t delta = OP_DELTA(op);
+
+      case_at[c] = e->pc;
+      if(chain && (c < line_length - 1)) {
+        jitPatch(e, case_jump[c], case_at[c]);
+      }
+
+      jitEmit1(e, 0xc6);      /* mov byte [rdi], write */
+      jitEmit1(e, 0x07);
+      jitEmit1(e, (unsigned char) OP_WRITE(op));
+
+      if(0 == delta) {
+        jitEmit1(e, 0xb8);    /* mov eax, next */
+        jitEmit32(e, (uint32_t) next);
+        jitJump(e, jmp, sizeof(jmp), stop_exit);
+        continue;
+      }
+
+      if(delta > 0) {
+        jitEmit(e, right, sizeof(right));
+      } else {
+        jitEmit(e, left, sizeof(left));
+      }
+      fixup_at[fixups]    = jitJump(e, jmp, sizeof(jmp), 0);
+      fixup_state[fixups] = next;
+      fixups ++;
+    }
+
+    jitPatch(e, exit_at, e->pc);
+    jitEmit1(e, 0x31);        /* xor ecx, ecx */
+    jitEmit1(e, 0xc9);
+    jitEmit1(e, 0xb8);        /* mov eax, s */
+    jitEmit32(e, (uint32_t) s);
+    jitJump(e, jmp, sizeof(jmp), budget_exit);
+
+    if(! chain) {
+      while(e->pc % 8) jitEmit1(e, 0xcc);
+      if(symbol_table + 8 <= e->size) {
+        const uint64_t address = (uint64_t) ((uintptr_t) e->code + e->pc);
+        memcpy(&e->code[symbol_table], &address, 8);
+      }
+      for(c = 0; c < line_length; c++) {
+        jitEmit64(e, (uint64_t) ((uintptr_t) e->code + case_at[c]));
+      }
+    }
+  }
+
+  for(fi = 0; fi < fixups; fi++) {
+    jitPatch(e, fixup_at[fi], state_at[fixup_state[fi]]);
+  }
+
+  while(e->pc % 8) jitEmit1(e, 0xcc);
+  if(state_table + 8 <= e->size) {
+    const uint64_t address = (uint64_t) ((uintptr_t) e->code + e->pc);
+    memcpy(&e->code[state_table], &address, 8);
+  }
+  for(s = 0; s < tm->num_states; s++) {
+    jitEmit64(e, (uint64_t) ((uintptr_t) e->code + state_at[s]));
+  }
+
+  return e->pc;
+}
+#endif
+
+
+
+
+/* NAME
+//   jitCompile: compile the program of a machine into native code
+//
+//
+// DESCRIPTION
+//   The program must already be compiled; see tmTableCompile().  The
+//   code is assembled into memory that is writable, then made
+//   executable and read-only before it runs.
+//
+//
+// RETURN VALUE
+//   Returns 0 if the native code is ready.
+//   Returns -1 if there is no native code for this machine or this
+//   platform; the caller falls back to interpreting the program.
+*/
+static int
+jitCompile(JitT *this, const TuringMachineT *tm)
+{
+#ifdef JIT_X86_64
+  const int32_t  line_length = tm->charset_max + 1;
+  const int64_t  entries     = (int64_t) tm->num_states * line_length;
+  size_t        *state_at;
+  size_t        *fixup_at;
+  int32_t       *fixup_state;
+  JitEmitT       e;
+  size_t         need;
+
+  jitFree(this);
+
+  if((line_length < 1) || (line_length > 128) || (tm->num_states < 1)) {
+    return -1;
+  }
+
+  state_at    = malloc(sizeof(size_t) * tm->num_states);
+  fixup_at    = malloc(sizeof(size_t) * entries);
+  fixup_state = malloc(sizeof(int32_t) * entries);
+  if((NULL == state_at) || (NULL == fixup_at) || (NULL == fixup_state)) {
+    fprintf(stderr, "jitCompile: out of memory\n");
+    free(state_at);
+    free(fixup_at);
+    free(fixup_state);
+    return -1;
+  }
+
+  /* Find the size of the code, then assemble it for real */
+  e.code = NULL;
+  e.size = 0;
+  need = jitAssemble(&e, tm, state_at, fixup_at, fixup_state);
+  need = (need + 4095) & ~(size_t) 4095;
+
+  e.code = mmap(NULL, need, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(MAP_FAILED == e.code) {
+    fprintf(stderr, "jitCompile: could not map %lu bytes of code\n",
+            (unsigned long) need);
+    e.code = NULL;
+  } else {
+    e.size = need;
+    jitAssemble(&e, tm, state_at, fixup_at, fixup_state);
+    if(mprotect(e.code, need, PROT_READ | PROT_EXEC) < 0) {
+      fprintf(stderr, "jitCompile: could not make code executable\n");
+      munmap(e.code, need);
+      e.code = NULL;
+    }
+  }
+
+  free(state_at);
+  free(fixup_at);
+  free(fixup_state);
+
+  if(NULL == e.code) {
+    return -1;
+  }
+
+  this->code      = e.code;
+  this->code_size = need;
+  return 0;
+#else
+  (void) this;
+  (void) tm;
+  return -1;
+#endif
+}
+
+
+
+
+/* NAME
+//   jitReserve: make sure the JIT tape holds head positions left..right
+//
+//
+// NOTE
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails, in
+//   which case the JIT tape is unchanged.
+//
+//
+// SEE ALSO
+//   tmTapeReserve()
+*/
+static int
+jitReserve(JitT *this, int64_t left, int64_t right)
+{
+  int64_t ti;
+
+  if(NULL == this->tape) {
+    const int64_t alloc = MAX(4096, 2 * (right - left + 1));
+
+    if((this->tape = calloc(alloc, 1))==NULL) {
+      return -1;
+    }
+    this->tape_alloc  = alloc;
+    this->tape_origin = alloc / 2 - (left + right) / 2;
+  }
+
+  ti = left + this->tape_origin;
+
+  if(ti < 0) {
+    const int64_t  grow = MAX(this->tape_alloc, -ti);
+    int8_t        *tape;
+
+    if((tape = malloc(this->tape_alloc + grow))==NULL) {
+      return -1;
+    }
+    memset(tape, 0, grow);
+    memcpy(&tape[grow], this->tape, this->tape_alloc);
+    free(this->tape);
+
+    this->tape         = tape;
+    this->tape_alloc  += grow;
+    this->tape_origin += grow;
+  }
+
+  ti = right + this->tape_origin;
+
+  if(ti >= this->tape_alloc) {
+    const int64_t  grow = MAX(this->tape_alloc, ti - this->tape_alloc + 1);
+    int8_t        *tape;
+
+    if((tape = realloc(this->tape, this->tape_alloc + grow))==NULL) {
+      return -1;
+    }
+    memset(&tape[this->tape_alloc], 0, grow);
+
+    this->tape        = tape;
+    this->tape_alloc += grow;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   jitLoad: copy the Turing Machine tape onto the JIT tape
+//
+//
+// RETURN VALUE
+//   Returns 0 on success.
+//   Returns -1 if the tape holds a symbol outside of the charset, which
+//   the native code has no transition for, or if the memory allocation
+//   fails.
+*/
+static int
+jitLoad(JitT *this, const TuringMachineT *tm)
+{
+  int64_t pos;
+
+  if(this->tape != NULL) {
+    memset(this->tape, 0, this->tape_alloc);
+  }
+  if(jitReserve(this, tm->left_end, tm->right_end) < 0) {
+    return -1;
+  }
+
+  for(pos = tm->left_end; pos <= tm->right_end; pos++) {
+    const Char symbol = tmTapeFrameAt(tm, pos);
+
+    if((symbol < 0) || (symbol > tm->charset_max)) {
+      return -1;
+    }
+    this->tape[pos + this->tape_origin] = symbol;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   jitUnload: copy the JIT tape back onto the Turing Machine tape
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+jitUnload(const JitT *this, TuringMachineT *tm)
+{
+  const int64_t here = tm->here;
+  int64_t       pos;
+
+  if(tmTapeReserve(tm, tm->left_end, tm->right_end) < 0) {
+    return -1;
+  }
+
+  for(pos = tm->left_end; pos <= tm->right_end; pos++) {
+    tm->here = pos;
+    if(tmTapeFrameSet(tm, this->tape[pos + this->tape_origin]) < 0) {
+      tm->here = here;
+      return -1;
+    }
+  }
+
+  tm->here = here;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   jitRun: run the native code until the machine stops or reaches a
+//   limit
+//
+//
+// DESCRIPTION
+//   Each call into the native code is given a budget of shifts small
+//   enough that the head stays within the JIT tape, and that the tape
+//   can reach tape_len_max only on the very last shift of the batch.
+//   Reaching tape_len_max takes at least
+//
+//     MIN(here - left_end, right_end - here) + (tape_len_max - tape_len)
+//
+//   shifts, so the native code needs no bounds checks of its own.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine stopped.
+//   Returns -1 if the memory allocation fails.
+//   Returns 0 otherwise.
+*/
+static int
+jitRun(JitT *this, TuringMachineT *tm, int64_t *iters, int64_t max_iters,
+       int64_t tape_len_max)
+{
+  const JitCodeF code = (JitCodeF) (uintptr_t) this->code;
+
+  while((*iters < max_iters) && (tm->tape_len < tape_len_max)) {
+    const int64_t room   = tape_len_max - tm->tape_len;
+    int64_t       budget = MIN(max_iters - *iters, JIT_BATCH_MAX);
+    int8_t       *base;
+    JitRegsT      regs;
+    int64_t       steps;
+    int           stop;
+
+    budget = MIN(budget, MIN(tm->here - tm->left_end,
+                             tm->right_end - tm->here) + room);
+
+    if(jitReserve(this, tm->here - budget, tm->here + budget) < 0) {
+      return -1;
+    }
+    base = this->tape + this->tape_origin;
+
+    regs.head   = base + tm->here;
+    regs.min    = base + tm->left_end;
+    regs.max    = base + tm->right_end;
+    regs.budget = budget;
+    regs.state  = tm->state;
+
+    stop = code(&regs);
+
+    steps         = budget - regs.budget;
+    tm->here      = regs.head - base;
+    tm->left_end  = regs.min  - base;
+    tm->right_end = regs.max  - base;
+    tm->tape_len  = tm->right_end - tm->left_end + 1;
+    tm->state     = regs.state;
+    *iters       += steps;
+
+    this->batches ++;
+    this->shifts  += steps;
+
+    if(stop) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmJitSimulate: perform a Turing Machine simulation in native code
+//
+//
+// DESCRIPTION
+//   Compiles the state transition table into native machine code (see
+//   jitAssemble) and runs it on a byte-per-frame copy of the tape.  The
+//   native code keeps the head, the extent of the tape, and the shift
+//   budget in registers, and goes from state to state by direct jumps,
+//   so a shift costs a handful of instructions and no table lookups.
+//
+//   Where there is no native code generator for the platform, or the
+//   code could not be mapped executable, or the tape holds symbols
+//   outside of the charset, the program is interpreted instead, with a
+//   note on stderr.  Either way the final tape, shift count and return
+//   value are identical to those of tmSimulate().
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), jitRun()
+*/
+int64_t
+tmJitSimulate(TuringMachineT *this, JitT *jit, int64_t max_iters,
+              int64_t tape_len_max)
+{
+  int64_t iters  = 0;
+  int     status = 0;
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  jit->native = 0;
+  if((0 == status) && (iters < max_iters) && (this->tape_len < tape_len_max))
+  {
+    if((jitCompile(jit, this) < 0) || (jitLoad(jit, this) < 0)) {
+      fprintf(stderr, "tmJitSimulate: no native code, interpreting\n");
+    } else {
+      jit->native = 1;
+      status = jitRun(jit, this, &iters, max_iters, tape_len_max);
+      if((jitUnload(jit, this) < 0) || (status < 0)) {
+        return -4;
+      }
+    }
+  }
+
+  if(0 == status) {
+    status = tmSimulateSteps(this, &iters, max_iters, max_iters,
+                             tape_len_max, 0);
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
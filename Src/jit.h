@@ -0,0 +1,74 @@
+/* jit.h: Turing Machine simulation by native code compiled at run time
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _JIT_H__INCLUDED_
+#define _JIT_H__INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* JIT_BATCH_MAX: most shifts taken by one call into the native code */
+#define JIT_BATCH_MAX (1 << 24)
+
+
+
+
+/* JitRegsT: machine registers passed in and out of the native code
+//
+// The native code loads and stores these members by their offsets, so
+// their order and types must not change.
+*/
+typedef struct {
+  int8_t   *head;    /* frame under the tape head */
+  int8_t   *min;     /* leftmost frame the head has been on */
+  int8_t   *max;     /* rightmost frame the head has been on */
+  int64_t   budget;  /* shifts left before the native code returns */
+  int32_t   state;   /* current state */
+} JitRegsT;
+
+
+
+
+/* JitT: native code for one state transition table, and its tape
+//
+// Each state is compiled into a basic block that reads the frame under
+// the head, writes, moves, and jumps straight to the block of the next
+// state.  The only check made on each shift is the shift budget: the
+// caller picks the budget so that the head cannot leave the tape
+// buffer, and the tape cannot reach tape_len_max, before the native
+// code returns.
+*/
+typedef struct {
+  unsigned char *code;        /* native code, or NULL if none */
+  size_t         code_size;   /* bytes mapped for code[] */
+  int            native;      /* flag: the last simulation ran native code */
+
+  int8_t        *tape;        /* one byte per frame: head position "here"
+                              // is stored at tape[here + tape_origin]
+                              */
+  int64_t        tape_origin; /* index into tape[] of head position 0 */
+  int64_t        tape_alloc;  /* number of elements allocated for tape[] */
+
+  int64_t        batches;     /* number of calls into the native code */
+  int64_t        shifts;      /* shifts taken by the native code */
+} JitT;
+
+
+
+
+JitT *   jitNew(void);
+void     jitDestroy(JitT *this);
+void     jitPrint(const JitT *this);
+int64_t  tmJitSimulate(TuringMachineT *this, JitT *jit, int64_t max_iters,
+                       int64_t tape_len_max);
+
+
+
+#endif
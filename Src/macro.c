@@ -0,0 +1,629 @@
+/* macro.c: Turing Machine simulation as a block-symbol macro machine
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "macro.h"
+
+
+
+
+/* MACRO_STEPS_MAX: most shifts simulated for a single macro transition
+//
+// A machine can run forever without leaving a block.  Such a transition
+// stops after MACRO_STEPS_MAX shifts with the head still inside the
+// block, which is a perfectly good (and cacheable) result.
+*/
+#define MACRO_STEPS_MAX 65536
+
+
+
+
+/* MACRO_TRIAL_STEPS: shifts run with each candidate k by macroAutoK */
+#define MACRO_TRIAL_STEPS 200000
+
+
+
+
+/* MACRO_LOOKUP_COST: cost of a macro transition, in simulated shifts
+//
+// Used by macroAutoK to weigh cache lookups against the shifts
+// simulated to fill the cache.
+*/
+#define MACRO_LOOKUP_COST 4
+
+
+
+
+/* BLOCK_OF: block number holding head position 'pos' (floor division) */
+#define BLOCK_OF(pos, k) \
+  (((pos) >= 0) ? ((pos) / (k)) : (((pos) + 1) / (k) - 1))
+
+
+
+
+/* macroSymbolBits: number of bits needed to hold one tape frame */
+static int
+macroSymbolBits(const TuringMachineT *tm)
+{
+  int bits = 1;
+
+  while(((int64_t)1 << bits) <= tm->charset_max) {
+    bits ++;
+  }
+  return bits;
+}
+
+
+
+
+/* NAME
+//   macroNew: allocate a new macro machine for a Turing Machine
+//
+//
+// ARGUMENTS
+//   tm (in): Turing Machine, used for its charset_max
+//
+//   k (in): block length in tape frames.  k * (bits per frame) must
+//     fit in 64 bits.
+//
+//   cache_bits (in): log2 of the number of macro transitions kept
+//
+//
+// RETURN VALUE
+//   Returns NULL if the arguments are bad or memory could not be
+//   allocated.
+*/
+MacroT *
+macroNew(const TuringMachineT *tm, int k, int cache_bits)
+{
+  const int symbol_bits = macroSymbolBits(tm);
+  MacroT   *this;
+
+  if((k < 1) || (k * symbol_bits > 64)) {
+    fprintf(stderr, "macroNew: k must be from 1 to %i for charset_max %i\n",
+            64 / symbol_bits, tm->charset_max);
+    return NULL;
+  }
+  if((cache_bits < 1) || (cache_bits > 30)) {
+    fprintf(stderr, "macroNew: cache_bits must be from 1 to 30\n");
+    return NULL;
+  }
+
+  if((this = calloc(1, sizeof(MacroT))) == NULL) {
+    fprintf(stderr, "macroNew: out of memory\n");
+    return NULL;
+  }
+
+  if((this->cache = calloc((size_t)1 << cache_bits, sizeof(MacroExitT)))
+     == NULL)
+  {
+    fprintf(stderr, "macroNew: out of memory\n");
+    free(this);
+    return NULL;
+  }
+
+  this->k            = k;
+  this->symbol_bits  = symbol_bits;
+  this->cache_bits   = cache_bits;
+  this->blocks       = NULL;
+  this->block_origin = 0;
+  this->block_alloc  = 0;
+  this->lookups      = 0;
+  this->hits         = 0;
+  this->miss_steps   = 0;
+
+  return this;
+}
+
+
+
+
+void
+macroDestroy(MacroT *this)
+{
+  if(this != NULL) {
+    free(this->cache);
+    free(this->blocks);
+    free(this);
+  }
+}
+
+
+
+
+void
+macroPrint(const MacroT *this)
+{
+  printf("macro: k=%i, %lli transitions, %lli hits (%.1f%%), "
+         "%lli shifts simulated\n",
+         this->k, (long long) this->lookups, (long long) this->hits,
+         this->lookups ? (100.0 * this->hits / this->lookups) : 0.0,
+         (long long) this->miss_steps);
+}
+
+
+
+
+/* NAME
+//   macroReserve: make sure the macro tape holds block b
+//
+//
+// DESCRIPTION
+//   The macro tape grows like the Turing Machine tape: independently
+//   to the left and right, by at least its current length each time.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails, in
+//   which case the macro tape is unchanged.
+//
+//
+// SEE ALSO
+//   tmTapeReserve()
+*/
+static int
+macroReserve(MacroT *this, int64_t b)
+{
+  int64_t bi;
+
+  if(NULL == this->blocks) {
+    if((this->blocks = calloc(64, sizeof(uint64_t)))==NULL) {
+      return -1;
+    }
+    this->block_alloc  = 64;
+    this->block_origin = 32 - b;
+  }
+
+  bi = b + this->block_origin;
+
+  if(bi < 0) {
+    const int64_t  grow = MAX(this->block_alloc, -bi);
+    uint64_t      *blocks;
+
+    if((blocks = malloc(sizeof(uint64_t) * (this->block_alloc + grow)))
+       ==NULL)
+    {
+      return -1;
+    }
+    memset(blocks, 0, sizeof(uint64_t) * grow);
+    memcpy(&blocks[grow], this->blocks, sizeof(uint64_t) * this->block_alloc);
+    free(this->blocks);
+
+    this->blocks        = blocks;
+    this->block_alloc  += grow;
+    this->block_origin += grow;
+
+  } else if(bi >= this->block_alloc) {
+    const int64_t  grow = MAX(this->block_alloc, bi - this->block_alloc + 1);
+    uint64_t      *blocks;
+
+    if((blocks = realloc(this->blocks,
+                         sizeof(uint64_t) * (this->block_alloc + grow)))
+       ==NULL)
+    {
+      return -1;
+    }
+    memset(&blocks[this->block_alloc], 0, sizeof(uint64_t) * grow);
+
+    this->blocks       = blocks;
+    this->block_alloc += grow;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   macroLoad: copy the Turing Machine tape onto the macro tape
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+macroLoad(MacroT *this, const TuringMachineT *tm)
+{
+  const int k = this->k;
+  int64_t   pos;
+
+  if(this->blocks != NULL) {
+    memset(this->blocks, 0, sizeof(uint64_t) * this->block_alloc);
+  }
+  if(macroReserve(this, BLOCK_OF(tm->here, k)) < 0) {
+    return -1;
+  }
+
+  for(pos = tm->left_end; (tm->tape_len > 0) && (pos <= tm->right_end); pos++)
+  {
+    const uint64_t symbol = (unsigned char) tmTapeFrameAt(tm, pos);
+
+    if(symbol) {
+      const int64_t b = BLOCK_OF(pos, k);
+
+      if(macroReserve(this, b) < 0) {
+        return -1;
+      }
+      this->blocks[b + this->block_origin]
+        |= symbol << ((pos - b * k) * this->symbol_bits);
+    }
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   macroUnload: copy the macro tape back onto the Turing Machine tape
+//
+//
+// DESCRIPTION
+//   The extent of the tape (left_end, right_end) must already be up to
+//   date.  Every frame within that extent is written.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+macroUnload(const MacroT *this, TuringMachineT *tm)
+{
+  const int      k           = this->k;
+  const uint64_t symbol_mask = ((uint64_t)1 << this->symbol_bits) - 1;
+  const int64_t  here        = tm->here;
+  int64_t        pos;
+
+  if(tmTapeReserve(tm, tm->left_end, tm->right_end) < 0) {
+    return -1;
+  }
+
+  for(pos = tm->left_end; pos <= tm->right_end; pos++) {
+    const int64_t b  = BLOCK_OF(pos, k);
+    const int64_t bi = b + this->block_origin;
+    uint64_t      symbol = 0;
+
+    if((bi >= 0) && (bi < this->block_alloc)) {
+      symbol =   (this->blocks[bi] >> ((pos - b * k) * this->symbol_bits))
+               & symbol_mask;
+    }
+    tm->here = pos;
+    if(tmTapeFrameSet(tm, (Char) symbol) < 0) {
+      tm->here = here;
+      return -1;
+    }
+  }
+  tm->here = here;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   macroExit: find the macro transition for (state, offset, block)
+//
+//
+// DESCRIPTION
+//   Look up the transition in the cache.  If it is not there, simulate
+//   the base machine on the block alone until the head leaves the
+//   block, the machine stops, or MACRO_STEPS_MAX shifts pass, and store
+//   the result in the cache.
+//
+//   The table must be compiled.
+*/
+static const MacroExitT *
+macroExit(MacroT *this, const TuringMachineT *tm, State state, int offset,
+          uint64_t block)
+{
+  const int64_t  line_length = tm->charset_max + 1;
+  const uint64_t key   = (uint64_t)state * 128 + offset;
+  const uint64_t hash  =   ((block ^ (key * 0x9e3779b97f4a7c15ULL))
+                            * 0xbf58476d1ce4e5b9ULL)
+                         >> (64 - this->cache_bits);
+  MacroExitT    *entry = &this->cache[hash];
+
+  this->lookups ++;
+
+  if(   entry->steps && (entry->block == block)
+     && (entry->state == state) && (entry->offset == offset))
+  {
+    this->hits ++;
+    return entry;
+  }
+
+  /* Simulate the base machine on this block alone */
+  {
+    const int      sb    = this->symbol_bits;
+    const uint64_t mask  = ((uint64_t)1 << sb) - 1;
+    const Op      *rowp  = tm->program + state * line_length;
+    int64_t        steps = 0;
+    int            here  = offset;
+    int            lo    = offset;
+    int            hi    = offset;
+    int            stop  = 0;
+    uint64_t       bits  = block;
+
+    do {
+      const int      shift = here * sb;
+      const Op       op    = rowp[(bits >> shift) & mask];
+      const int32_t  delta = OP_DELTA(op);
+
+      bits  =   (bits & ~(mask << shift))
+              | ((uint64_t)(unsigned char) OP_WRITE(op) << shift);
+      rowp  = tm->program + OP_ROW(op);
+      steps ++;
+
+      if(0 == delta) {
+        stop = 1;
+        break;
+      }
+      here += delta;
+      lo = MIN(lo, here);
+      hi = MAX(hi, here);
+    } while((here >= 0) && (here < this->k) && (steps < MACRO_STEPS_MAX));
+
+    this->miss_steps += steps;
+
+    entry->block  = block;
+    entry->state  = state;
+    entry->offset = offset;
+    entry->result = bits;
+    entry->steps  = steps;
+    entry->next   = (rowp - tm->program) / line_length;
+    entry->exit   = here;
+    entry->lo     = lo;
+    entry->hi     = hi;
+    entry->stop   = stop;
+  }
+
+  return entry;
+}
+
+
+
+
+/* NAME
+//   macroRun: run the macro machine on the macro tape
+//
+//
+// DESCRIPTION
+//   Takes macro transitions until the machine stops, or until the next
+//   transition would take *iters past max_iters or the tape to
+//   tape_len_max.  The state, head position and tape extent of the
+//   Turing Machine are kept up to date, but its tape is not; see
+//   macroUnload.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine stopped.
+//   Returns -1 if the memory allocation fails, in which case the
+//   machine is left before the macro transition that needed it.
+//   Returns 0 otherwise.
+*/
+static int
+macroRun(MacroT *this, TuringMachineT *tm, int64_t *iters, int64_t max_iters,
+         int64_t tape_len_max)
+{
+  const int k         = this->k;
+  int64_t   b         = BLOCK_OF(tm->here, k);
+  int       offset    = tm->here - b * k;
+  State     state     = tm->state;
+  int64_t   left_end  = tm->left_end;
+  int64_t   right_end = tm->right_end;
+  int       stop      = 0;
+
+  if(macroReserve(this, b) < 0) {
+    return -1;
+  }
+
+  while(*iters < max_iters) {
+    const MacroExitT *exit  = macroExit(this, tm, state, offset,
+                                        this->blocks[b + this->block_origin]);
+    const int64_t     left  = MIN(left_end,  b * k + exit->lo);
+    const int64_t     right = MAX(right_end, b * k + exit->hi);
+
+    if(   (*iters + exit->steps > max_iters)
+       || (right - left + 1 >= tape_len_max))
+    {
+      /* The machine reaches a limit within this block */
+      break;
+    }
+
+    if((! exit->stop) && ((exit->exit < 0) || (exit->exit >= k))
+       && (macroReserve(this, (exit->exit < 0) ? b - 1 : b + 1) < 0))
+    {
+      /* No memory for the next block */
+      stop = -1;
+      break;
+    }
+
+    this->blocks[b + this->block_origin] = exit->result;
+    state      = exit->next;
+    *iters    += exit->steps;
+    left_end   = left;
+    right_end  = right;
+
+    if(exit->stop) {
+      offset = exit->exit;
+      stop   = 1;
+      break;
+    } else if(exit->exit < 0) {
+      b --;
+      offset = k - 1;
+    } else if(exit->exit >= k) {
+      b ++;
+      offset = 0;
+    } else {
+      offset = exit->exit;
+    }
+  }
+
+  tm->here      = b * k + offset;
+  tm->state     = state;
+  tm->left_end  = left_end;
+  tm->right_end = right_end;
+  tm->tape_len  = right_end - left_end + 1;
+
+  return stop;
+}
+
+
+
+
+/* NAME
+//   macroAutoK: pick a block length for a Turing Machine
+//
+//
+// DESCRIPTION
+//   Run the machine for a while as a macro machine with each of several
+//   block lengths, and pick the block length that took the least work
+//   per shift.  Work is counted as MACRO_LOOKUP_COST per macro
+//   transition plus every shift simulated to fill the cache.
+//
+//   The Turing Machine is left as it was.
+//
+//
+// RETURN VALUE
+//   Returns the block length.
+*/
+int
+macroAutoK(TuringMachineT *tm, int cache_bits)
+{
+  static const int candidates[] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+
+  const State   state     = tm->state;
+  const int64_t here      = tm->here;
+  const int64_t left_end  = tm->left_end;
+  const int64_t right_end = tm->right_end;
+  const int64_t tape_len  = tm->tape_len;
+  const int     k_max     = 64 / macroSymbolBits(tm);
+  int           k_best    = 1;
+  double        cost_best = 0.0;
+  unsigned      ci;
+
+  if((tm->charset_max > OP_CHARSET_MAX) || (tmTableCompile(tm) < 0)) {
+    return k_best;
+  }
+
+  for(ci = 0; ci < sizeof(candidates) / sizeof(candidates[0]); ci++) {
+    const int  k     = MIN(candidates[ci], k_max);
+    MacroT    *macro = macroNew(tm, k, cache_bits);
+    int64_t    iters = 0;
+    double     cost;
+
+    if(NULL == macro) break;
+
+    if(macroLoad(macro, tm) < 0) {
+      macroDestroy(macro);
+      break;
+    }
+    macroRun(macro, tm, &iters, MACRO_TRIAL_STEPS, INT64_MAX);
+
+    cost =   (double)(macro->lookups * MACRO_LOOKUP_COST + macro->miss_steps)
+           / (double) MAX(iters, 1);
+    if((ci == 0) || (cost < cost_best)) {
+      cost_best = cost;
+      k_best    = k;
+    }
+
+    macroDestroy(macro);
+
+    tm->state     = state;
+    tm->here      = here;
+    tm->left_end  = left_end;
+    tm->right_end = right_end;
+    tm->tape_len  = tape_len;
+
+    if(k == k_max) break;
+  }
+
+  return k_best;
+}
+
+
+
+
+/* NAME
+//   tmMacroSimulate: perform a Turing Machine simulation as a macro machine
+//
+//
+// DESCRIPTION
+//   The tape is grouped into blocks of k frames, each block packed into
+//   one 64-bit word of a separate macro tape.  The head always sits at
+//   one end of a block, having entered it from the left or the right.
+//   A macro transition (state, entry side, block) -> (new block, new
+//   state, exit side, shifts taken) is computed on demand by
+//   simulating the base machine on the block alone, and cached (see
+//   macroExit).  Long stretches of the simulation then cost one cache
+//   lookup per block crossed.
+//
+//   Shift counts are exact.  When a macro transition would run past
+//   max_iters or tape_len_max, the macro tape is copied back onto the
+//   Turing Machine tape and the rest of the simulation is done one
+//   shift at a time, so that shift counts, final tapes and return
+//   values are identical to those of tmSimulate().
+//
+//   The macro transitions depend on the state transition table, so
+//   'macro' must not be reused after the table changes.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), macroExit(), macroAutoK()
+*/
+int64_t
+tmMacroSimulate(TuringMachineT *this, MacroT *macro, int64_t max_iters,
+                int64_t tape_len_max)
+{
+  int64_t iters  = 0;
+  int     status = 0;
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  if((0 == status) && (iters < max_iters) && (this->tape_len < tape_len_max))
+  {
+    if(macroLoad(macro, this) < 0) {
+      return -4;
+    }
+    status = macroRun(macro, this, &iters, max_iters, tape_len_max);
+    if((macroUnload(macro, this) < 0) || (status < 0)) {
+      return -4;
+    }
+
+    if(0 == status) {
+      /* Finish the last few shifts near a limit one at a time */
+      status = tmSimulateSteps(this, &iters, max_iters, max_iters,
+                               tape_len_max, 0);
+    }
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
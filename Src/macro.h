@@ -0,0 +1,77 @@
+/* macro.h: Turing Machine simulation as a block-symbol macro machine
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _MACRO_H__INCLUDED_
+#define _MACRO_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* MacroExitT: macro transition
+//
+// The key is (state, offset, block).  The head enters a block at
+// offset 0 (from the left) or at offset k-1 (from the right), or
+// anywhere when the simulation starts.  The rest describes the machine
+// at the moment its head leaves the block, or stops inside it.
+*/
+typedef struct {
+  uint64_t block;   /* key: block contents, frame i at bits i*symbol_bits */
+  uint64_t result;  /* block contents when the head leaves */
+  int64_t  steps;   /* shifts taken.  Zero means this slot is empty. */
+  State    state;   /* key: state on entry */
+  State    next;    /* state when the head leaves, or after stopping */
+  int8_t   offset;  /* key: head offset within the block on entry */
+  int8_t   exit;    /* head offset when the head leaves (-1 or k), or
+                    // where the machine stopped.
+                    */
+  int8_t   lo;      /* leftmost head offset visited */
+  int8_t   hi;      /* rightmost head offset visited */
+  int8_t   stop;    /* flag: machine stopped inside the block */
+} MacroExitT;
+
+
+
+
+typedef struct {
+  int          k;            /* block length, in tape frames */
+  int          symbol_bits;  /* bits per tape frame within a block */
+  int          cache_bits;   /* log2 of the number of cache slots */
+  MacroExitT  *cache;        /* direct-mapped table of macro transitions */
+
+  uint64_t    *blocks;       /* macro tape: block b holds head positions
+                             // b*k to b*k+k-1, stored at
+                             // blocks[b + block_origin]
+                             */
+  int64_t      block_origin; /* index into blocks[] of block 0 */
+  int64_t      block_alloc;  /* number of elements allocated for blocks[] */
+
+  int64_t      lookups;      /* number of macro transitions taken */
+  int64_t      hits;         /* number of lookups found in the cache */
+  int64_t      miss_steps;   /* shifts simulated to fill the cache */
+} MacroT;
+
+
+
+
+/* MACRO_K_AUTO: value of k which asks tmMacroSimulate to pick k itself */
+#define MACRO_K_AUTO 0
+
+
+
+
+MacroT * macroNew(const TuringMachineT *tm, int k, int cache_bits);
+void     macroDestroy(MacroT *this);
+void     macroPrint(const MacroT *this);
+int      macroAutoK(TuringMachineT *tm, int cache_bits);
+int64_t  tmMacroSimulate(TuringMachineT *this, MacroT *macro,
+                         int64_t max_iters, int64_t tape_len_max);
+
+
+
+#endif
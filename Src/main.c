@@ -0,0 +1,794 @@
+/* main.c: Turing Machine simulator command line program
+//
+// Written and Copyright (C) 1997 by Michael J. Gourlay
+//
+// Provided as is.  No warrentees, express or implied.
+//
+// The simulator itself is the library libtm.a, which keeps everything
+// in the TuringMachineT it is given.  This program reads the command
+// line, runs one machine or a search with the library, and prints what
+// happened.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifndef sun
+#include <getopt.h>
+#endif
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "tm.h"
+#include "window.h"
+#include "macro.h"
+#include "rle.h"
+#include "hash.h"
+#include "rule.h"
+#include "jit.h"
+#include "cycle.h"
+#include "page.h"
+#include "map.h"
+#include "multi.h"
+#include "emit.h"
+#include "snap.h"
+#include "search.h"
+#include "tnf.h"
+
+
+
+
+/* SNAPSHOT_EVERY: default seconds between snapshots of a simulation */
+#define SNAPSHOT_EVERY 600
+
+/* SNAPSHOT_CHUNK: fewest shifts run between looks at the clock and at
+// signals, when taking snapshots
+*/
+#define SNAPSHOT_CHUNK ((int64_t)1 << 20)
+
+
+
+
+/* EngineT: the simulation engine chosen on the command line, and what
+// it keeps from one run of the machine to the next
+*/
+typedef struct {
+  const char *name;
+  WindowT    *window;
+  MacroT     *macro;
+  RleT       *rle;
+  HashT      *hash;
+  RulesT     *rules;
+  JitT       *jit;
+} EngineT;
+
+
+
+
+/* turing_machine: global reference to current Turing machine
+//   intended for use in interrupt handler.  The library keeps no such
+//   reference; only this program, which searches one machine, does.
+*/
+static TuringMachineT *turing_machine;
+
+/* interrupted: flag set by handle_term, for simulateSnapshots */
+static volatile sig_atomic_t interrupted;
+
+
+
+
+/* NAME
+//   handle_int: signal handler for busy beaver search
+//
+//
+// DESCRIPTION
+//   Searching for busy beavers takes a long time.  In order to be able
+//   to continue the search where it left off, it is useful to trap
+//   signals which would interrupt the process.  handle_int catches
+//   some signals and outputs enough information to continue the search
+//   for busy beavers where the search left off.
+*/
+static void
+handle_int(int signum)
+{
+  printf("\n");
+  tmTablePrint(turing_machine);
+  tmTableWrite(turing_machine, "interrupt.tm");
+  exit(1);
+}
+
+
+
+
+/* NAME
+//   handle_term: signal handler for a simulation that takes snapshots
+//
+//
+// DESCRIPTION
+//   The machine is in the middle of a shift when the signal arrives, so
+//   handle_term only notes it, and simulateSnapshots() takes a snapshot
+//   and stops at the end of the shifts it is running.
+*/
+static void
+handle_term(int signum)
+{
+  interrupted = 1;
+}
+
+
+
+
+/* NAME
+//   engineNew: set up the simulation engine named on the command line
+//
+//
+// RETURN VALUE
+//   Returns -1 if the engine could not be set up, 0 otherwise.
+*/
+static int
+engineNew(EngineT *this, TuringMachineT *tm, const char *name,
+          int window_width, int macro_k)
+{
+  memset(this, 0, sizeof(*this));
+  this->name = name;
+
+  if(tm->multi != NULL) {
+    /* A multi-tape machine has an engine of its own */
+    return 0;
+  }
+
+  if(!strcmp(name, "window")) {
+    if(NULL == (this->window = windowNew(window_width, 20))) return -1;
+  } else if(!strcmp(name, "macro")) {
+    if(MACRO_K_AUTO == macro_k) {
+      macro_k = macroAutoK(tm, 16);
+    }
+    if(NULL == (this->macro = macroNew(tm, macro_k, 20))) return -1;
+  } else if(!strcmp(name, "rle")) {
+    if(NULL == (this->rle = rleNew())) return -1;
+  } else if(!strcmp(name, "hash")) {
+    if(NULL == (this->hash = hashNew(HASH_LEVEL, 20))) return -1;
+  } else if(!strcmp(name, "rule")) {
+    if(NULL == (this->rules = rulesNew(16))) return -1;
+  } else if(!strcmp(name, "jit")) {
+    if(NULL == (this->jit = jitNew())) return -1;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   engineRun: run the machine with the simulation engine
+//
+//
+// DESCRIPTION
+//   Each engine keeps what it learned about the machine, so running it
+//   again carries on where it left off.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+*/
+static int64_t
+engineRun(EngineT *this, TuringMachineT *tm, int64_t max_iters,
+          int64_t tape_len_max)
+{
+  if(tm->multi != NULL) {
+    /* Execute a multi-tape Turing Machine, whatever the engine */
+    return multiSimulate(tm, max_iters, tape_len_max);
+
+  } else if(this->window != NULL) {
+    /* Execute Turing Machine using window-exit tables */
+    return tmWindowSimulate(tm, this->window, max_iters, tape_len_max);
+
+  } else if(this->macro != NULL) {
+    /* Execute Turing Machine as a macro machine on blocks of frames */
+    return tmMacroSimulate(tm, this->macro, max_iters, tape_len_max);
+
+  } else if(this->rle != NULL) {
+    /* Execute Turing Machine on a run-length encoded tape */
+    return tmRleSimulate(tm, this->rle, max_iters, tape_len_max);
+
+  } else if(this->hash != NULL) {
+    /* Execute Turing Machine using memoized tape trees */
+    return tmHashSimulate(tm, this->hash, max_iters, tape_len_max);
+
+  } else if(this->rules != NULL) {
+    /* Execute Turing Machine with proven rules on a run-length tape */
+    return tmRuleSimulate(tm, this->rules, max_iters, tape_len_max);
+
+  } else if(this->jit != NULL) {
+    /* Execute Turing Machine as native code compiled at run time */
+    return tmJitSimulate(tm, this->jit, max_iters, tape_len_max);
+  }
+
+  /* Execute Turing Machine without "visual mode" display */
+  return tmSimulate(tm, max_iters, tape_len_max);
+}
+
+
+
+
+/* NAME
+//   enginePrint: print what the simulation engine did
+*/
+static void
+enginePrint(const EngineT *this)
+{
+  if(this->window != NULL) windowPrint(this->window);
+  if(this->macro  != NULL) macroPrint(this->macro);
+  if(this->rle    != NULL) rlePrint(this->rle);
+  if(this->hash   != NULL) hashPrint(this->hash);
+  if(this->rules  != NULL) rulesPrint(this->rules);
+  if(this->jit    != NULL) jitPrint(this->jit);
+}
+
+
+
+
+/* NAME
+//   engineDestroy: free the simulation engine
+*/
+static void
+engineDestroy(EngineT *this)
+{
+  if(this->window != NULL) windowDestroy(this->window);
+  if(this->macro  != NULL) macroDestroy(this->macro);
+  if(this->rle    != NULL) rleDestroy(this->rle);
+  if(this->hash   != NULL) hashDestroy(this->hash);
+  if(this->rules  != NULL) rulesDestroy(this->rules);
+  if(this->jit    != NULL) jitDestroy(this->jit);
+}
+
+
+
+
+/* NAME
+//   simulateSnapshots: run the machine, taking snapshots as it goes
+//
+//
+// ARGUMENTS
+//   engine (in/out): simulation engine
+//   tm (in/out): Turing Machine
+//   max_iters (in): maximum number of shifts, counting those in 'iters'
+//   tape_len_max (in): maximum tape length before quitting
+//   snap_file (in): name of the snapshot file
+//   snap_every (in): seconds between snapshots
+//   iters (in): shifts the machine had executed before, when carrying on
+//     from a snapshot
+//   seconds (in): processor time the simulation had taken before
+//
+//
+// DESCRIPTION
+//   The machine is run with the engine a number of shifts at a time,
+//   doubled until a run takes about half a second, so that looking at
+//   the clock costs next to nothing.  Between runs, a snapshot of the
+//   machine is written to snap_file (see snapWrite) when snap_every
+//   seconds have gone by since the last one, or when the process was
+//   sent SIGINT, SIGHUP or SIGTERM, in which case the simulation then
+//   stops.
+//
+//   The cycle detector (see cycle) starts over with each run, so it
+//   only finds cycles shorter than a run.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate(), with the shifts counted from the start of the
+//   machine, or -6 if the simulation was interrupted.
+*/
+static int64_t
+simulateSnapshots(EngineT *engine, TuringMachineT *tm, int64_t max_iters,
+                  int64_t tape_len_max, const char *snap_file, int snap_every,
+                  int64_t iters, double seconds)
+{
+  const clock_t start = clock();
+  time_t        last  = time(NULL);
+  int64_t       chunk = SNAPSHOT_CHUNK;
+
+  while(iters < max_iters) {
+    const int64_t budget      = MIN(chunk, max_iters - iters);
+    const clock_t chunk_start = clock();
+    int64_t       result;
+
+    result = engineRun(engine, tm, budget, tape_len_max);
+    if(result >= 0) {
+      return iters + result;
+    }
+    if(result != -1) {
+      /* The shifts of an unfinished run are not known, so the last
+      // snapshot is left as it is
+      */
+      return result;
+    }
+    iters += budget;
+
+    /* The blank test only looks at the first shifts of the machine */
+    if(iters >= tmIterTest(tm)) tm->blank_test = 0;
+
+    if(clock() - chunk_start < CLOCKS_PER_SEC / 2) {
+      chunk *= 2;
+    }
+
+    if(interrupted || (time(NULL) - last >= snap_every)) {
+      const double taken = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+      if(snapWrite(tm, snap_file, iters, seconds + taken) < 0) {
+        fprintf(stderr, "simulateSnapshots: snapshot not written\n");
+      }
+      last = time(NULL);
+      if(interrupted) {
+        printf("interrupted after %lli shifts, snapshot in %s\n",
+               (long long) iters, snap_file);
+        return -6;
+      }
+    }
+  }
+  return -1;
+}
+
+
+
+
+int
+main(int argc, char **argv)
+{
+  int debug             = 0; /* flag: debug mode (i.e. single step mode) */
+  int visual            = 0; /* flag: visual mode. */
+  int verbose           = 0; /* flag: verbose mode */
+  int search            = 0; /* flag: search mode */
+  int jobs              = 1; /* number of threads to search on */
+  char *start_index     = NULL; /* lexical index of table to search from */
+  char *end_index       = NULL; /* lexical index of table to stop before */
+  TableIndex search_end = TABLE_INDEX_MAX;
+  int tnf               = 0; /* flag: search in Tree Normal Form */
+
+  int64_t iters = 0;   /* number of shifts the Turing Machine has executed */
+  clock_t start;       /* processor time when the simulation started */
+  double  seconds;     /* processor time the simulation took */
+
+  // max_iters: maximum number of iterations before the machine is stopped.
+  int64_t max_iters         = INT64_MAX ;
+
+  // tape_len_max: maximum tape length before the machine is stopped.
+  int64_t tape_len_max      = 409750;
+
+  TuringMachine tm              = tmNew();
+
+  char *engine         = "table"; /* simulation engine */
+  int window_width     = WINDOW_WIDTH_MAX; /* window engine: frames per window */
+  int macro_k          = MACRO_K_AUTO; /* macro engine: frames per block */
+
+
+  /* Command line argument parsing variables.  See getopt() */
+  int oc;
+  int err_flag                  = 0;
+  extern char *optarg;
+  extern int optind, opterr, optopt;
+  char *machine_file            = NULL;
+  char *tape_file               = NULL;
+  char *map_file                = NULL; /* file to memory-map the tape from */
+  int resumed                   = 0; /* flag: machine came from map_file */
+  int emit_c                    = 0; /* flag: write machine as C program */
+  char *snap_file               = NULL; /* file to write snapshots to */
+  char *resume_file             = NULL; /* snapshot to carry on from */
+  int snap_every                = SNAPSHOT_EVERY; /* seconds between them */
+  int64_t iters_before          = 0; /* shifts before the snapshot */
+  double  seconds_before        = 0.0; /* processor time before it */
+  EngineT simulator;
+  static struct option long_options[] = {
+    { "emit-c",         required_argument, NULL, 'C' },
+    { "snapshot",       required_argument, NULL, 'S' },
+    { "snapshot-every", required_argument, NULL, 'I' },
+    { "resume",         required_argument, NULL, 'R' },
+    { "start-index",    required_argument, NULL, 'a' },
+    { "end-index",      required_argument, NULL, 'z' },
+    { "tnf",            no_argument,       NULL, 'N' },
+    { NULL,             0,                 NULL, 0   }
+  };
+
+
+  /* Parse command line arguments */
+  while ((oc = getopt_long(argc, argv, "m:t:e:w:k:l:i:M:j:dsvVBcp", long_options, NULL))
+         != -1)
+  {
+    switch (oc) {
+      case 'm':
+        machine_file = optarg;
+      break;
+
+      case 'C':
+        machine_file = optarg;
+        emit_c = 1;
+      break;
+
+      case 't':
+        tape_file = optarg;
+      break;
+
+      case 'S':
+        snap_file = optarg;
+      break;
+
+      case 'I':
+        snap_every = atoi(optarg);
+      break;
+
+      case 'R':
+        resume_file = optarg;
+      break;
+
+      case 'e':
+        engine = optarg;
+        if(   strcmp(engine, "table") && strcmp(engine, "window")
+           && strcmp(engine, "macro") && strcmp(engine, "rle")
+           && strcmp(engine, "hash") && strcmp(engine, "rule")
+           && strcmp(engine, "jit"))
+        {
+          fprintf(stderr, "%s: unknown engine '%s'\n", argv[0], engine);
+          err_flag++;
+        }
+      break;
+
+      case 'w':
+        window_width = atoi(optarg);
+      break;
+
+      case 'k':
+        engine = "macro";
+        macro_k = atoi(optarg);
+      break;
+
+      case 'l':
+        tape_len_max = atoll(optarg);
+      break;
+
+      case 'i':
+        max_iters = atoll(optarg);
+      break;
+
+      case 'p':
+        tm->tape_paged = 1;
+      break;
+
+      case 'M':
+        map_file = optarg;
+      break;
+
+      case 'd':
+        debug = 1;
+        visual = 1;
+      break;
+
+      case 's':
+        search = 1;
+      break;
+
+      case 'a':
+        start_index = optarg;
+      break;
+
+      case 'z':
+        end_index = optarg;
+      break;
+
+      case 'N':
+        tnf = 1;
+      break;
+
+      case 'j':
+        jobs = atoi(optarg);
+        if((jobs < 1) || (jobs > SEARCH_THREADS_MAX)) {
+          fprintf(stderr, "%s: jobs must be from 1 to %i\n", argv[0],
+                  SEARCH_THREADS_MAX);
+          err_flag++;
+        }
+      break;
+
+      case 'v':
+        visual = 1;
+      break;
+
+      case 'V':
+        verbose = 1;
+      break;
+
+      case 'B':
+        tm->blank_test = 0;
+      break;
+
+      case 'c':
+        if(NULL == tm->cycle) {
+          if(NULL == (tm->cycle = cycleNew())) exit(1);
+        }
+      break;
+
+      case '?':
+        err_flag++;
+    }
+  }
+
+  if (err_flag) {
+    fprintf(stderr, "usage: %s -m machine_file -t tape_file [-d] [-v] [-V] [-B] [-c] [-p]"
+                    " [-e table|window|macro|rle|hash|rule|jit] [-w width] [-k block]"
+                    " [-l length] [-i shifts] [-M tape_map] [-s [-j jobs] [--start-index index]"
+                    " [--end-index index] [--tnf]] [--snapshot snap_file]"
+                    " [--snapshot-every seconds] [--resume snap_file]\n",
+            argv[0]);
+    fprintf(stderr, "       %s --emit-c machine_file > simulator.c\n",
+            argv[0]);
+    exit(2);
+  }
+
+  if(emit_c) {
+    /* Write a C program that simulates the machine, and do nothing else.
+    // tmTableRead() echoes the comments in the machine file on standard
+    // output, so it reads with standard output sent to a temporary
+    // file.  The comments are copied into a C comment only once the
+    // machine is known to be one that can be written, so that nothing
+    // is written for a machine that cannot.
+    */
+    FILE *comments = tmpfile();
+    int   out      = dup(fileno(stdout));
+    int   status;
+    int   c;
+
+    fflush(stdout);
+    if(   (NULL == comments) || (out < 0)
+       || (dup2(fileno(comments), fileno(stdout)) < 0))
+    {
+      fprintf(stderr, "%s: --emit-c: no temporary file\n", argv[0]);
+      exit(1);
+    }
+    status = tmTableRead(tm, machine_file);
+    fflush(stdout);
+    dup2(out, fileno(stdout));
+    close(out);
+
+    if(status < 0) exit(1);
+    if(tm->multi != NULL) {
+      fprintf(stderr, "%s: --emit-c takes only machines with one tape\n",
+              argv[0]);
+      exit(1);
+    }
+
+    printf("/* Comments in %s:\n", machine_file);
+    rewind(comments);
+    while((c = getc(comments)) != EOF) {
+      putchar(c);
+    }
+    fclose(comments);
+    printf("*/\n\n");
+    if(tmTableEmitC(tm, stdout, machine_file, tape_len_max) < 0) exit(1);
+    return 0;
+  }
+
+  if(machine_file == NULL) {
+    fprintf(stderr, "%s: must specify machine_file\n", argv[0]);
+    exit(3);
+  }
+
+  /* Carrying on from a snapshot takes more snapshots in the same file */
+  if((resume_file != NULL) && (NULL == snap_file)) {
+    snap_file = resume_file;
+  }
+
+  if((snap_file != NULL) && (search || visual || (map_file != NULL))) {
+    fprintf(stderr, "%s: snapshots cannot be taken with -s, -v, -d or -M\n",
+            argv[0]);
+    exit(2);
+  }
+
+  if(   ((jobs > 1) || (start_index != NULL) || (end_index != NULL) || tnf)
+     && !search)
+  {
+    fprintf(stderr, "%s: -j, --start-index, --end-index and --tnf need -s\n",
+            argv[0]);
+    exit(2);
+  }
+
+  if(   tnf
+     && (   (jobs > 1) || (start_index != NULL) || (end_index != NULL)
+         || visual || (map_file != NULL)))
+  {
+    fprintf(stderr, "%s: --tnf cannot be used with -j, --start-index,"
+            " --end-index, -v, -d or -M\n", argv[0]);
+    exit(2);
+  }
+
+  if(((jobs > 1) || (end_index != NULL)) && (visual || (map_file != NULL))) {
+    fprintf(stderr, "%s: -j and --end-index cannot be used with -v, -d or"
+            " -M\n", argv[0]);
+    exit(2);
+  }
+
+  if((tape_file == NULL) && (NULL == resume_file)) {
+    fprintf(stderr, "%s: tape_file not specified.  Assuming blank.\n", argv[0]);
+  }
+
+
+  if(verbose) {
+    /* max_iters is printed partly for information and partly to see
+    // whether a number as large as max_iters is properly being stored
+    // in the integer variable.
+    */
+    printf("maximum iterations = %lli\n", (long long) max_iters);
+  }
+
+  /* Read the Turing Machine state transition table */
+  if(tmTableRead(tm, machine_file) < 0) exit(1);
+
+  if(   (tm->multi != NULL)
+     && (search || visual || (tm->cycle != NULL) || (snap_file != NULL)))
+  {
+    fprintf(stderr, "%s: a machine with more than one tape cannot be"
+            " searched, shown in visual mode, checked for cycles, or"
+            " snapshot\n",
+            argv[0]);
+    exit(2);
+  }
+
+  /* Only the table engine runs the machine through the cycle check */
+  if((tm->cycle != NULL) && strcmp(engine, "table")) {
+    fprintf(stderr, "%s: -c cannot be used with the %s engine\n", argv[0],
+            engine);
+    exit(2);
+  }
+
+  /* Shard the search: start from, and stop before, the tables with
+  // these lexical indices instead of the machine_file's table and the
+  // last table
+  */
+  if(start_index != NULL) {
+    TableIndex ti;
+
+    if((tmTableIndexParse(start_index, &ti) < 0) || (tmTableUnrank(tm, ti) < 0))
+    {
+      fprintf(stderr, "%s: no table of this shape has index %s\n", argv[0],
+              start_index);
+      exit(2);
+    }
+  }
+  if(end_index != NULL) {
+    if(tmTableIndexParse(end_index, &search_end) < 0) {
+      fprintf(stderr, "%s: '%s' is not a table index\n", argv[0], end_index);
+      exit(2);
+    }
+  }
+
+  /* Keep the tape in a memory-mapped file, which may hold a snapshot of
+  // an earlier run to carry on from.  Make room for the longest tape
+  // allowed, grown from either end.
+  */
+  if(map_file != NULL) {
+    if((resumed = mapOpen(tm, map_file, 2 * tape_len_max)) < 0) exit(2);
+  }
+
+  /* Read the Turing Machine tape */
+  if(resumed) {
+    printf("%s: carrying on from state %i at head position %lli\n",
+           map_file, tm->state, (long long) tm->here);
+  } else if(resume_file != NULL) {
+    if(snapRead(tm, resume_file, &iters_before, &seconds_before) < 0) {
+      exit(2);
+    }
+    printf("%s: carrying on from state %i at head position %lli"
+           " after %lli shifts\n",
+           resume_file, tm->state, (long long) tm->here,
+           (long long) iters_before);
+  } else if(tape_file != NULL) {
+    if(tmTapeRead(tm, tape_file) < 0) exit(2);
+  } else if(tmTapeBlank(tm) < 0) {
+    exit(2);
+  }
+
+  if(verbose && !visual) {
+    if(tm->multi != NULL) {
+      multiTablePrint(tm);
+      tmTapePrint(tm);
+    } else {
+      TableIndex ti;
+      char       index[TABLE_INDEX_CHARS];
+
+      tmTablePrint(tm);
+      tmTapePrint(tm);
+      if(tmTableRank(tm, &ti) == 0) {
+        printf("table is lexically %s\n", tmTableIndexFormat(ti, index));
+      }
+    }
+  }
+
+  start = clock();
+
+  if(search) {
+    turing_machine = tm;
+    signal(SIGINT, handle_int);
+    signal(SIGHUP, handle_int);
+
+    if(tnf) {
+      iters = tmBusyBeaverSearchTNF(tm, max_iters, tape_len_max);
+    } else if((jobs > 1) || (end_index != NULL)) {
+      iters = tmBusyBeaverSearchJobs(tm, max_iters, tape_len_max, jobs,
+                                     search_end);
+    } else {
+      iters = tmBusyBeaverSearch(tm, max_iters, tape_len_max, visual, debug);
+    }
+
+  } else if(visual) {
+    iters = tmVisualSimulate(tm, max_iters, tape_len_max, debug);
+
+  } else {
+    if(engineNew(&simulator, tm, engine, window_width, macro_k) < 0) {
+      exit(1);
+    }
+
+    if(snap_file != NULL) {
+      interrupted = 0;
+      signal(SIGINT, handle_term);
+      signal(SIGHUP, handle_term);
+      signal(SIGTERM, handle_term);
+
+      iters = simulateSnapshots(&simulator, tm, max_iters, tape_len_max,
+                                snap_file, snap_every, iters_before,
+                                seconds_before);
+    } else {
+      iters = engineRun(&simulator, tm, max_iters, tape_len_max);
+    }
+
+    if(verbose) enginePrint(&simulator);
+    engineDestroy(&simulator);
+  }
+
+  seconds = (double) (clock() - start) / CLOCKS_PER_SEC + seconds_before;
+
+  if(verbose) {
+    /* Print some information about the how the simulation went */
+
+    tmTapeWrite(tm, "out.tape");
+    printf("tape was %lli frames long\n", (long long) tm->tape_len);
+    printf("head visited frames %lli to %lli\n",
+           (long long) tm->left_end, (long long) tm->right_end);
+    if(tm->tape_paged) pagePrint(tm);
+    if(tm->tape_map != NULL) mapPrint(tm);
+    if(tm->multi != NULL) multiPrint(tm);
+
+    if(iters >= 0) {
+      int64_t count = tmTapeOneCount(tm);
+
+      tmTapePrint(tm);
+      printf("The machine executed %lli shifts\n", (long long) iters);
+      printf("tape had %lli 1's\n", (long long) count);
+      if(seconds > 0.0) {
+        printf("simulation took %.3f seconds, %.0f shifts per second\n",
+               seconds, iters / seconds);
+      }
+    } else if(-1 == iters) {
+      printf("too many iterations\n");
+    } else if(-2 == iters) {
+      printf("tape too long\n");
+    } else if(-4 == iters) {
+      printf("out of memory\n");
+    } else if(-5 == iters) {
+      printf("machine cycles\n");
+    } else if(-6 == iters) {
+      printf("interrupted\n");
+    }
+    if(tm->cycle != NULL) cyclePrint(tm->cycle);
+  }
+
+  /* Leave a snapshot of the tape in the tape file */
+  if(tm->tape_map != NULL) {
+    tm->tape_map->stopped = (iters >= 0);
+    mapClose(tm);
+  }
+
+  tmDestroy(tm);
+
+  return (-6 == iters) ? 1 : 0;
+}
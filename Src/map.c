@@ -0,0 +1,522 @@
+/* map.c: Turing Machine tape stored in a memory-mapped file
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+
+#include "tm.h"
+#include "map.h"
+
+
+
+
+/* MAP_FRAMES_MIN: number of tape frames in a new tape file
+//
+// This must be a multiple of 64, so that a bit-packed tape grows by
+// whole words.
+*/
+#define MAP_FRAMES_MIN 1024
+
+/* MAP_FIRST_BYTES_MAX: most bytes of tape in a new tape file
+//
+// The file is sparse, so a large file costs nothing until it is
+// written, but the mapping still takes address space.
+*/
+#define MAP_FIRST_BYTES_MAX ((int64_t)1 << 32)
+
+
+
+
+/* mapBytes: number of bytes of tape file used to store 'frames' frames */
+#define mapBytes(tm, frames) \
+  ((frames) * (tm)->tape_width / 8)
+
+
+
+
+/* NAME
+//   mapResize: set the length of the tape file and map all of it
+//
+//
+// DESCRIPTION
+//   Bytes added to the end of the file read as 0, and take no disk
+//   space until they are written.  The mapping is MAP_NORESERVE, so the
+//   system does not set aside swap for it: pages of the tape are read
+//   from and written back to the file as the kernel sees fit.
+//
+//   The tape pointer of the machine is left for the caller to set.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the file cannot be grown or mapped,
+//   in which case the old mapping is kept.  The file is never shrunk,
+//   so the old mapping stays valid.
+*/
+static int
+mapResize(MapT *this, int64_t bytes)
+{
+  char *base;
+
+  if(ftruncate(this->fd, bytes) < 0) {
+    fprintf(stderr, "mapResize: %s: %s\n", this->filename, strerror(errno));
+    return -1;
+  }
+
+  base = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_NORESERVE, this->fd, 0);
+  if(MAP_FAILED == base) {
+    fprintf(stderr, "mapResize: %s: %s\n", this->filename, strerror(errno));
+    return -1;
+  }
+  if(this->base != NULL) {
+    munmap(this->base, this->bytes);
+  }
+  this->base  = base;
+  this->bytes = bytes;
+
+  /* Simulations sweep the tape, so let the kernel read ahead */
+  madvise(this->base + MAP_HEADER_BYTES, bytes - MAP_HEADER_BYTES,
+          MADV_SEQUENTIAL);
+  return 0;
+}
+
+
+
+
+/* NAME
+//   mapTapeSet: point the tape of the machine at the mapped tape memory
+*/
+static void
+mapTapeSet(TuringMachineT *this)
+{
+  char *mem = this->tape_map->base + MAP_HEADER_BYTES;
+
+  if(1 == this->tape_width) {
+    this->tape_words = (uint64_t *) mem;
+  } else if(8 == this->tape_width) {
+    this->tape = (int8_t *) mem;
+  } else {
+    this->tape_wide = (Char *) mem;
+  }
+}
+
+
+
+
+/* NAME
+//   mapHeaderSet: write the clean flag to the header of the tape file
+//
+//
+// DESCRIPTION
+//   The header is synced to the file before mapHeaderSet() returns, so
+//   that a tape file which is not clean on disk is never mistaken for a
+//   snapshot, whatever happens to the process or the system after.
+*/
+static void
+mapHeaderSet(MapT *this, int clean)
+{
+  MapHeaderT *header = (MapHeaderT *) this->base;
+
+  header->clean = clean;
+  msync(this->base, MAP_HEADER_BYTES, MS_SYNC);
+}
+
+
+
+
+/* NAME
+//   mapAdopt: take the tape of the machine from a tape file snapshot
+//
+//
+// RETURN VALUE
+//   Returns 1 if the file holds a clean snapshot of a machine which had
+//   not stopped, with a tape of the width the machine uses, 0 if it
+//   does not, in which case the machine and the file are not changed,
+//   or -1 if the snapshot cannot be mapped or holds a symbol the
+//   machine does not have.
+*/
+static int
+mapAdopt(TuringMachineT *this, MapT *map, int64_t file_bytes)
+{
+  MapHeaderT header;
+  int64_t    hi;
+  int64_t    pos;
+
+  if(file_bytes < MAP_HEADER_BYTES) return 0;
+
+  if(pread(map->fd, &header, sizeof(header), 0) != sizeof(header)) return 0;
+
+  if(   memcmp(header.magic, MAP_MAGIC, sizeof(header.magic))
+     || (! header.clean) || header.stopped
+     || (header.tape_width != this->tape_width)
+     || (header.state < 0) || (header.state >= this->num_states)
+     || (header.tape_alloc <= 0) || (header.tape_alloc % 64)
+     || (MAP_HEADER_BYTES + mapBytes(this, header.tape_alloc) > file_bytes))
+  {
+    return 0;
+  }
+  if(header.tape_len) {
+    if(   (header.tape_len != header.right_end - header.left_end + 1)
+       || (header.left_end + header.tape_origin < 0)
+       || (header.right_end + header.tape_origin >= header.tape_alloc)
+       || (header.here < header.left_end)
+       || (header.here > header.right_end))
+    {
+      return 0;
+    }
+  }
+
+  if(mapResize(map, file_bytes) < 0) return -1;
+  this->tape_map = map;
+
+  this->tape_alloc  = header.tape_alloc;
+  this->tape_origin = header.tape_origin;
+  this->tape_len    = header.tape_len;
+  this->left_end    = header.left_end;
+  this->right_end   = header.right_end;
+  this->here        = header.here;
+  this->state       = header.state;
+  mapTapeSet(this);
+
+  /* Count the symbols on the tape, which the file does not record */
+  memset(this->symbol_count, 0, sizeof(int64_t) * (this->charset_max + 1));
+  hi = this->tape_len ? this->right_end : this->left_end - 1;
+  for(pos = this->left_end; pos <= hi; pos++) {
+    const Char c = tmTapeFrameAt(this, pos);
+
+    if((c < 0) || (c > this->charset_max)) {
+      fprintf(stderr, "mapOpen: %s: symbol %i at %lli is out of range\n",
+              map->filename, c, (long long) pos);
+      return -1;
+    }
+    this->symbol_count[c] ++;
+  }
+  this->symbol_count[0] = 0;
+
+  return 1;
+}
+
+
+
+
+/* NAME
+//   mapOpen: keep the tape of a machine in a memory-mapped file
+//
+//
+// ARGUMENTS
+//   this (in/out): Turing Machine
+//   filename (in): name of the tape file
+//   frames (in): number of frames to make room for when the tape is
+//     first reserved
+//
+//
+// DESCRIPTION
+//   From then on, tmTapeReserve() passes the tape memory to
+//   mapReserve(), which grows the file instead of allocating memory, so
+//   a tape is only limited by disk space.  mapOpen() must be called
+//   after tmTableRead(), which sets tape_width, and before the tape is
+//   first allocated.
+//
+//   If the file holds a clean snapshot of a tape (see mapSync()), the
+//   tape, head position and state of the machine are taken from it, and
+//   the simulation carries on from where it was synced.  Any other file,
+//   including the snapshot of a machine that stopped, is overwritten.
+//   While the simulation runs, the file is marked as not clean, so that
+//   a run that dies leaves no snapshot behind.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine was taken from a snapshot in the file, in
+//   which case the tape must not be read or blanked, 0 if the tape is
+//   new, or -1 if the file could not be used.
+//
+//
+// SEE ALSO
+//   mapReserve(), mapSync(), mapClose(), tmTapeReserve()
+*/
+int
+mapOpen(TuringMachineT *this, const char *filename, int64_t frames)
+{
+  MapT        *map;
+  struct stat  st;
+
+  if(this->tape_paged) {
+    fprintf(stderr, "mapOpen: a paged tape cannot be mapped\n");
+    return -1;
+  }
+  if((this->tape != NULL) || (this->tape_wide != NULL)
+     || (this->tape_words != NULL) || (this->tape_map != NULL))
+  {
+    fprintf(stderr, "mapOpen: the tape already has memory\n");
+    return -1;
+  }
+
+  if((map = calloc(1, sizeof(MapT))) == NULL) {
+    fprintf(stderr, "mapOpen: out of memory\n");
+    return -1;
+  }
+  if((map->filename = strdup(filename)) == NULL) {
+    fprintf(stderr, "mapOpen: out of memory\n");
+    free(map);
+    return -1;
+  }
+
+  if((map->fd = open(filename, O_RDWR | O_CREAT, 0644)) < 0) {
+    fprintf(stderr, "mapOpen: %s: %s\n", filename, strerror(errno));
+    free(map->filename);
+    free(map);
+    return -1;
+  }
+  if(fstat(map->fd, &st) < 0) {
+    fprintf(stderr, "mapOpen: %s: %s\n", filename, strerror(errno));
+    close(map->fd);
+    free(map->filename);
+    free(map);
+    return -1;
+  }
+
+  frames = MIN(frames, MAP_FIRST_BYTES_MAX * 8 / this->tape_width);
+  map->frames = (MAX(frames, MAP_FRAMES_MIN) + 63) & ~(int64_t)63;
+
+  switch(mapAdopt(this, map, st.st_size)) {
+  case 1:
+    mapHeaderSet(map, 0);
+    return 1;
+  case -1:
+    if(map->base != NULL) {
+      munmap(map->base, map->bytes);
+    }
+    close(map->fd);
+    free(map->filename);
+    free(map);
+    this->tape_map   = NULL;
+    this->tape       = NULL;
+    this->tape_wide  = NULL;
+    this->tape_words = NULL;
+    return -1;
+  }
+
+  /* Not a snapshot: start over, mapping the file when it is reserved */
+  if(ftruncate(map->fd, 0) < 0) {
+    fprintf(stderr, "mapOpen: %s: %s\n", filename, strerror(errno));
+    close(map->fd);
+    free(map->filename);
+    free(map);
+    return -1;
+  }
+  this->tape_map = map;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   mapReserve: make sure the tape file spans a range of head positions
+//
+//
+// DESCRIPTION
+//   mapReserve() is tmTapeReserve() for a tape in a memory-mapped file,
+//   and grows the file in the same way as tmTapeReserve() grows tape
+//   memory.  Growing to the right only lengthens the file.  Growing to
+//   the left moves the tape along the file, which rewrites all of it,
+//   but the file is made large enough at first that this is rare.
+//
+//   For a bit-packed tape, 'right' must already include the extra
+//   word which tmTapeReserve() keeps beyond the head.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the file cannot be grown, in which
+//   case the tape is unchanged.
+//
+//
+// SEE ALSO
+//   tmTapeReserve(), mapOpen()
+*/
+int
+mapReserve(TuringMachineT *this, int64_t left, int64_t right)
+{
+  MapT    *map = this->tape_map;
+  char    *mem;
+  int64_t  ti;
+
+  if(NULL == map->base) {
+    /* Map a new tape, centered on the head */
+    if(mapResize(map, MAP_HEADER_BYTES + mapBytes(this, map->frames)) < 0) {
+      return -1;
+    }
+    memcpy(map->base, MAP_MAGIC, sizeof(((MapHeaderT *) 0)->magic));
+    mapHeaderSet(map, 0);
+    this->tape_alloc  = map->frames;
+    this->tape_origin = map->frames / 2 - this->here;
+  }
+
+  ti = left + this->tape_origin;
+
+  if(ti < 0) {
+    /* Grow the tape to the left */
+    const int64_t grow = (MAX(this->tape_alloc, -ti) + 63) & ~(int64_t)63;
+
+    if(mapResize(map, MAP_HEADER_BYTES
+                      + mapBytes(this, this->tape_alloc + grow)) < 0)
+    {
+      mapTapeSet(this);
+      return -1;
+    }
+    mem = map->base + MAP_HEADER_BYTES;
+    memmove(&mem[mapBytes(this, grow)], mem,
+            mapBytes(this, this->tape_alloc));
+    memset(mem, 0, mapBytes(this, MIN(grow, this->tape_alloc)));
+
+    this->tape_alloc  += grow;
+    this->tape_origin += grow;
+  }
+
+  ti = right + this->tape_origin;
+
+  if(ti >= this->tape_alloc) {
+    /* Grow the tape to the right */
+    const int64_t grow = (MAX(this->tape_alloc, ti - this->tape_alloc + 1)
+                          + 63) & ~(int64_t)63;
+
+    if(mapResize(map, MAP_HEADER_BYTES
+                      + mapBytes(this, this->tape_alloc + grow)) < 0)
+    {
+      mapTapeSet(this);
+      return -1;
+    }
+    this->tape_alloc += grow;
+  }
+
+  mapTapeSet(this);
+  return 0;
+}
+
+
+
+
+/* NAME
+//   mapSync: make the tape file a snapshot of the machine
+//
+//
+// DESCRIPTION
+//   Records the head, state and tape extent of the machine in the header
+//   of the tape file, writes the tape back to the file, and only then
+//   marks the file as clean.  A later mapOpen() of the file carries on
+//   from there.
+//
+//   The tape must not change after mapSync() until the machine is done
+//   with, since the file would no longer match its header.
+//
+//
+// RETURN VALUE
+//   Returns 0 if the snapshot was written, -1 otherwise.
+*/
+int
+mapSync(TuringMachineT *this)
+{
+  MapT       *map = this->tape_map;
+  MapHeaderT *header;
+
+  if((NULL == map) || (NULL == map->base)) return -1;
+
+  header = (MapHeaderT *) map->base;
+  header->tape_width  = this->tape_width;
+  header->tape_alloc  = this->tape_alloc;
+  header->tape_origin = this->tape_origin;
+  header->tape_len    = this->tape_len;
+  header->left_end    = this->left_end;
+  header->right_end   = this->right_end;
+  header->here        = this->here;
+  header->state       = this->state;
+  header->stopped     = map->stopped;
+
+  if(msync(map->base, map->bytes, MS_SYNC) < 0) {
+    fprintf(stderr, "mapSync: %s: %s\n", map->filename, strerror(errno));
+    return -1;
+  }
+  mapHeaderSet(map, 1);
+  return 0;
+}
+
+
+
+
+/* NAME
+//   mapClose: sync the tape file, and take the tape out of it
+//
+//
+// DESCRIPTION
+//   The machine is left with no tape memory, as after tmTapeFree().
+*/
+void
+mapClose(TuringMachineT *this)
+{
+  MapT *map = this->tape_map;
+
+  if(NULL == map) return;
+
+  if(map->base != NULL) {
+    mapSync(this);
+    munmap(map->base, map->bytes);
+  }
+  close(map->fd);
+  free(map->filename);
+  free(map);
+
+  this->tape_map   = NULL;
+  this->tape       = NULL;
+  this->tape_wide  = NULL;
+  this->tape_words = NULL;
+}
+
+
+
+
+/* NAME
+//   mapPrint: print how much of the tape file is in memory and on disk
+*/
+void
+mapPrint(const TuringMachineT *this)
+{
+  const MapT    *map       = this->tape_map;
+  const int64_t  page      = sysconf(_SC_PAGESIZE);
+  int64_t        resident  = 0;
+  struct stat    st;
+
+  if((NULL == map) || (NULL == map->base)) return;
+
+  {
+    const int64_t  pages = (map->bytes + page - 1) / page;
+    unsigned char *vec   = malloc(pages);
+    int64_t        pi;
+
+    if((vec != NULL) && (0 == mincore(map->base, map->bytes, vec))) {
+      for(pi = 0; pi < pages; pi++) {
+        resident += vec[pi] & 1;
+      }
+    }
+    free(vec);
+  }
+
+  if(fstat(map->fd, &st) < 0) {
+    st.st_blocks = 0;
+  }
+  printf("tape file %s: %lli bytes, %lli bytes on disk,"
+         " %lli bytes in memory\n",
+         map->filename, (long long) map->bytes,
+         (long long) st.st_blocks * 512, (long long) (resident * page));
+}
@@ -0,0 +1,76 @@
+/* map.h: Turing Machine tape stored in a memory-mapped file
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _MAP_H__INCLUDED_
+#define _MAP_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* MAP_HEADER_BYTES: bytes at the start of the file before the tape */
+#define MAP_HEADER_BYTES 4096
+
+/* MAP_MAGIC: first bytes of a tape file, with its format version */
+#define MAP_MAGIC "tmtape1"
+
+
+
+
+/* MapHeaderT: what a tape file says about the tape after it
+//
+// The tape memory starts MAP_HEADER_BYTES into the file, and is laid
+// out exactly as tape, tape_wide or tape_words is in memory.
+*/
+typedef struct {
+  char    magic[8];    /* MAP_MAGIC */
+  int32_t tape_width;  /* bits per frame */
+  int32_t clean;       /* flag: the tape is a consistent snapshot */
+  int64_t tape_alloc;  /* frames stored in the file */
+  int64_t tape_origin; /* frame of head position 0 */
+  int64_t tape_len;    /* the machine's tape extent and head */
+  int64_t left_end;
+  int64_t right_end;
+  int64_t here;
+  int32_t state;       /* state of the machine when it was synced */
+  int32_t stopped;     /* flag: the machine had stopped */
+} MapHeaderT;
+
+
+
+
+/* MapT: memory-mapped tape file
+//
+// The whole file is mapped shared, so the kernel pages the tape in and
+// out of the file as the head moves, and the process only needs memory
+// for the parts of the tape in use.
+*/
+struct MapS {
+  char    *filename;
+  int      fd;         /* file descriptor of the open file */
+  char    *base;       /* mapping of the whole file, or NULL */
+  int64_t  bytes;      /* length of the mapping */
+  int64_t  frames;     /* frames to map when the tape is first reserved */
+  int      stopped;    /* flag: the machine has stopped, so the snapshot
+                       // has nothing to carry on from.  Set by the
+                       // caller before mapSync().
+                       */
+};
+
+
+
+
+int      mapOpen(TuringMachineT *this, const char *filename, int64_t frames);
+int      mapReserve(TuringMachineT *this, int64_t left, int64_t right);
+int      mapSync(TuringMachineT *this);
+void     mapClose(TuringMachineT *this);
+void     mapPrint(const TuringMachineT *this);
+
+
+
+#endif
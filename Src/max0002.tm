@@ -0,0 +1,15 @@
+# max0002.tm: table 00000000027589 written from tm.c version Oct 17 2026
+
+charset_max 1
+
+state 0
+input 0 write 1 move L next 1
+input 1 write 1 move L next 1
+
+state 1
+input 0 write 1 move R next 0
+input 1 write 1 move S next 2
+
+state 2
+input 0 write 0 move L next 0
+input 1 write 0 move L next 0
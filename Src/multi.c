@@ -0,0 +1,638 @@
+/* multi.c: Turing Machine simulation with several tapes
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "multi.h"
+
+
+
+
+/* MULTI_TAPE_ALLOC_MIN: number of frames allocated for a new tape */
+#define MULTI_TAPE_ALLOC_MIN 1024
+
+
+
+
+/* NAME
+//   multiNew: allocate the table and tapes of a multi-tape machine
+//
+//
+// ARGUMENTS
+//   tapes (in): number of tapes, from 2 to MULTI_TAPES_MAX
+//   charset_max (in): largest symbol on any tape
+//
+//
+// DESCRIPTION
+//   The table starts with no states; see multiTableGrow().
+//
+//
+// RETURN VALUE
+//   Returns NULL if there are too many input tuples, or if memory could
+//   not be allocated.
+*/
+MultiT *
+multiNew(int tapes, int charset_max)
+{
+  MultiT *this;
+  int64_t rows = 1;
+  int     ti;
+
+  if((tapes < 2) || (tapes > MULTI_TAPES_MAX)) {
+    fprintf(stderr, "multiNew: bad number of tapes: %i\n", tapes);
+    return NULL;
+  }
+
+  if((this = calloc(1, sizeof(MultiT))) == NULL) {
+    fprintf(stderr, "multiNew: out of memory\n");
+    return NULL;
+  }
+
+  for(ti = 0; ti < tapes; ti++) {
+    this->stride[ti] = rows;
+    rows *= charset_max + 1;
+    if(rows > MULTI_ROWS_MAX) {
+      fprintf(stderr, "multiNew: %i tapes of charset_max %i make more than"
+              " %i input tuples\n", tapes, charset_max, MULTI_ROWS_MAX);
+      free(this);
+      return NULL;
+    }
+  }
+  this->tapes = tapes;
+  this->rows  = rows;
+
+  return this;
+}
+
+
+
+
+/* NAME
+//   multiDestroy: free a multi-tape machine
+*/
+void
+multiDestroy(MultiT *this)
+{
+  int ti;
+
+  if(NULL == this) return;
+  for(ti = 0; ti < this->tapes; ti++) {
+    free(this->tape[ti].frames);
+  }
+  free(this->entry);
+  free(this->write);
+  free(this->delta);
+  free(this);
+}
+
+
+
+
+/* NAME
+//   multiTableGrow: make room in the table for num_states states
+//
+//
+// DESCRIPTION
+//   The transitions of the new states are left undefined (next is -1)
+//   until multiTableLine() sets them.
+//
+//
+// RETURN VALUE
+//   Returns -4 if memory could not be allocated, 0 otherwise.
+*/
+int
+multiTableGrow(MultiT *this, int32_t num_states)
+{
+  const int64_t  entries = this->rows * num_states;
+  MultiEntryT   *entry;
+  Char          *write;
+  int8_t        *delta;
+  int64_t        ei;
+
+  if((entry = realloc(this->entry, sizeof(MultiEntryT) * entries)) == NULL) {
+    fprintf(stderr, "multiTableGrow: out of memory\n");
+    return -4;
+  }
+  this->entry = entry;
+  if((write = realloc(this->write, sizeof(Char) * entries * this->tapes))
+     == NULL)
+  {
+    fprintf(stderr, "multiTableGrow: out of memory\n");
+    return -4;
+  }
+  this->write = write;
+  if((delta = realloc(this->delta, sizeof(int8_t) * entries * this->tapes))
+     == NULL)
+  {
+    fprintf(stderr, "multiTableGrow: out of memory\n");
+    return -4;
+  }
+  this->delta = delta;
+
+  for(ei = this->rows * this->num_states; ei < entries; ei++) {
+    this->entry[ei].next = -1;
+    this->entry[ei].stop = 1;
+    memset(&this->write[ei * this->tapes], 0, sizeof(Char) * this->tapes);
+    memset(&this->delta[ei * this->tapes], 0, sizeof(int8_t) * this->tapes);
+  }
+  this->num_states = num_states;
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   multiScanInts: read 'count' integers following a keyword
+//
+//
+// RETURN VALUE
+//   Returns 0 and moves *linep past what was read if 'keyword' and then
+//   'count' integers follow, or -1 otherwise.
+*/
+static int
+multiScanInts(const char **linep, const char *keyword, int count,
+              int32_t *values)
+{
+  char word[16];
+  int  n = 0;
+  int  vi;
+
+  if((sscanf(*linep, " %15s%n", word, &n) != 1) || strcmp(word, keyword)) {
+    return -1;
+  }
+  *linep += n;
+  for(vi = 0; vi < count; vi++) {
+    if(sscanf(*linep, " %i%n", &values[vi], &n) != 1) return -1;
+    *linep += n;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   multiTableLine: read one transition of a multi-tape machine
+//
+//
+// ARGUMENTS
+//   state (in): state the transition belongs to
+//   line (in): line of the machine file, of the form
+//       input <k integers> write <k integers> move <k letters> next <integer>
+//     where each letter of move is L or R to move that head, N to leave
+//     it where it is, or S to leave it where it is and stop the machine
+//     after the transition.
+//   line_num (in): line number, for error messages
+//   next (out): next state of the transition
+//
+//
+// RETURN VALUE
+//   Returns 0 if the transition was read, or the negative value
+//   tmTableRead() returns for the same error in a one-tape machine.
+//
+//
+// SEE ALSO
+//   tmTableRead()
+*/
+int
+multiTableLine(MultiT *this, int32_t state, int charset_max,
+               const char *line, int32_t line_num, int32_t *next)
+{
+  const char *p = line;
+  int32_t     input[MULTI_TAPES_MAX];
+  int32_t     write[MULTI_TAPES_MAX];
+  char        move[MULTI_TAPES_MAX + 2];
+  char        word[16];
+  char        rest[2];
+  int64_t     row = 0;
+  int64_t     ei;
+  int         n = 0;
+  int         stop = 0;
+  int         ti;
+
+  if(   (multiScanInts(&p, "input", this->tapes, input) < 0)
+     || (multiScanInts(&p, "write", this->tapes, write) < 0)
+     || (sscanf(p, " %15s%n", word, &n) != 1) || strcmp(word, "move"))
+  {
+    fprintf(stderr, "multiTableLine: %i: invalid line for %i tapes: '%s'\n",
+            line_num, this->tapes, line);
+    return -11;
+  }
+  p += n;
+  if(   (sscanf(p, " %9s%n", move, &n) != 1)
+     || ((p += n), multiScanInts(&p, "next", 1, next) < 0)
+     || (sscanf(p, " %1s", rest) == 1))
+  {
+    fprintf(stderr, "multiTableLine: %i: invalid line for %i tapes: '%s'\n",
+            line_num, this->tapes, line);
+    return -11;
+  }
+
+  for(ti = 0; ti < this->tapes; ti++) {
+    if((input[ti] < 0) || (input[ti] > charset_max)) {
+      fprintf(stderr, "multiTableLine: %i: bad value for input: %i\n",
+              line_num, input[ti]);
+      return -6;
+    }
+    if((write[ti] < 0) || (write[ti] > charset_max)) {
+      fprintf(stderr, "multiTableLine: %i: bad value for write: %i\n",
+              line_num, write[ti]);
+      return -7;
+    }
+    row += input[ti] * this->stride[ti];
+  }
+
+  if(*next < 0) {
+    fprintf(stderr, "multiTableLine: %i: bad value for next: %i\n",
+            line_num, *next);
+    return -8;
+  }
+
+  if((int) strlen(move) != this->tapes) {
+    fprintf(stderr, "multiTableLine: %i: move needs %i letters: %s\n",
+            line_num, this->tapes, move);
+    return -9;
+  }
+
+  ei = state * this->rows + row;
+  for(ti = 0; ti < this->tapes; ti++) {
+    int8_t delta;
+
+    switch(move[ti]) {
+      case 'L': delta = -1; break;
+      case 'R': delta =  1; break;
+      case 'N': delta =  0; break;
+      case 'S': delta =  0; stop = 1; break;
+      default:
+        fprintf(stderr, "multiTableLine: %i: bad value for move: %c\n",
+                line_num, move[ti]);
+        return -9;
+    }
+    this->write[ei * this->tapes + ti] = write[ti];  /* type conversion */
+    this->delta[ei * this->tapes + ti] = delta;
+  }
+  this->entry[ei].next = *next;
+  this->entry[ei].stop = stop;
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   multiTablePrint: print the state transition table of a multi-tape
+//   machine
+//
+//
+// DESCRIPTION
+//   A table of a row per state and a column per input tuple would be
+//   too wide to read, so each defined transition is printed on a line
+//   of its own, in the form of the machine file.
+*/
+void
+multiTablePrint(const TuringMachineT *tm)
+{
+  const MultiT *this = tm->multi;
+  int32_t       si;
+  int64_t       row;
+  int           ti;
+
+  printf("tapes %i\n", this->tapes);
+  for(si = 0; si < this->num_states; si++) {
+    printf("state %i\n", si);
+    for(row = 0; row < this->rows; row++) {
+      const int64_t ei = si * this->rows + row;
+
+      if(this->entry[ei].next < 0) continue;
+
+      printf("  input");
+      for(ti = 0; ti < this->tapes; ti++) {
+        printf(" %lli",
+               (long long) ((row / this->stride[ti]) % (tm->charset_max + 1)));
+      }
+      printf(" write");
+      for(ti = 0; ti < this->tapes; ti++) {
+        printf(" %i", this->write[ei * this->tapes + ti]);
+      }
+      printf(" move ");
+      for(ti = 0; ti < this->tapes; ti++) {
+        const int8_t delta = this->delta[ei * this->tapes + ti];
+
+        printf("%c", (delta < 0) ? 'L' : (delta > 0) ? 'R'
+                     : this->entry[ei].stop ? 'S' : 'N');
+      }
+      printf(" next %i\n", this->entry[ei].next);
+    }
+  }
+}
+
+
+
+
+/* NAME
+//   multiTapeReserve: make sure tape memory exists at a head position
+//
+//
+// DESCRIPTION
+//   Grows the tape like tmTapeReserve() does, by at least the current
+//   allocated length on the end that has to grow.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails, in
+//   which case the tape is unchanged.
+*/
+static int
+multiTapeReserve(MultiTapeT *this, int64_t here)
+{
+  int64_t ti = here + this->origin;
+
+  if(NULL == this->frames) {
+    if((this->frames = calloc(MULTI_TAPE_ALLOC_MIN, sizeof(Char))) == NULL) {
+      return -1;
+    }
+    this->alloc  = MULTI_TAPE_ALLOC_MIN;
+    this->origin = MULTI_TAPE_ALLOC_MIN / 2 - here;
+    ti           = here + this->origin;
+  }
+
+  if(ti < 0) {
+    /* Grow the tape to the left */
+    const int64_t  grow   = MAX(this->alloc, -ti);
+    Char          *frames = calloc(this->alloc + grow, sizeof(Char));
+
+    if(NULL == frames) {
+      return -1;
+    }
+    memcpy(&frames[grow], this->frames, sizeof(Char) * this->alloc);
+    free(this->frames);
+    this->frames  = frames;
+    this->alloc  += grow;
+    this->origin += grow;
+
+  } else if(ti >= this->alloc) {
+    /* Grow the tape to the right */
+    const int64_t  grow   = MAX(this->alloc, ti - this->alloc + 1);
+    Char          *frames = realloc(this->frames,
+                                    sizeof(Char) * (this->alloc + grow));
+
+    if(NULL == frames) {
+      return -1;
+    }
+    memset(&frames[this->alloc], 0, sizeof(Char) * grow);
+    this->frames  = frames;
+    this->alloc  += grow;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   multiLoad: set up the tapes to start a multi-tape machine
+//
+//
+// DESCRIPTION
+//   Tape 0 is copied from the tape of the machine.  The others are
+//   blank, with their heads at 0.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+multiLoad(MultiT *this, const TuringMachineT *tm)
+{
+  MultiTapeT *tape = &this->tape[0];
+  int64_t     here;
+  int         ti;
+
+  for(ti = 0; ti < this->tapes; ti++) {
+    free(this->tape[ti].frames);
+    memset(&this->tape[ti], 0, sizeof(MultiTapeT));
+    if(multiTapeReserve(&this->tape[ti], 0) < 0) return -1;
+  }
+
+  if(tm->tape_len) {
+    if((multiTapeReserve(tape, tm->left_end) < 0)
+       || (multiTapeReserve(tape, tm->right_end) < 0))
+    {
+      return -1;
+    }
+    for(here = tm->left_end; here <= tm->right_end; here++) {
+      tape->frames[here + tape->origin] = tmTapeFrameAt(tm, here);
+    }
+    tape->left_end  = tm->left_end;
+    tape->right_end = tm->right_end;
+  }
+  if(multiTapeReserve(tape, tm->here) < 0) return -1;
+  tape->here = tm->here;
+  if(tape->here < tape->left_end)  tape->left_end  = tape->here;
+  if(tape->here > tape->right_end) tape->right_end = tape->here;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   multiUnload: copy tape 0 back to the tape of the machine
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+static int
+multiUnload(const MultiT *this, TuringMachineT *tm)
+{
+  const MultiTapeT *tape = &this->tape[0];
+  int64_t           here;
+
+  for(here = tape->left_end; here <= tape->right_end; here++) {
+    tm->here = here;
+    if((tmTapeAlloc(tm) < 0)
+       || (tmTapeFrameSet(tm, tape->frames[here + tape->origin]) < 0))
+    {
+      return -1;
+    }
+  }
+  tm->here = tape->here;
+  return tmTapeAlloc(tm);
+}
+
+
+
+
+/* NAME
+//   multiSimulate: run a multi-tape machine
+//
+//
+// DESCRIPTION
+//   Runs the machine until it stops, it has executed max_iters shifts,
+//   or one of its tapes reaches tape_len_max frames.  A shift is one
+//   transition, whatever the number of heads that move in it.  A
+//   transition the machine file did not give stops the machine without
+//   counting a shift.
+//
+//   The tapes are held in the MultiT, and tape 0 is copied back to the
+//   machine at the end, so everything that looks at the tape of a
+//   one-tape machine afterwards sees tape 0.  The busy beaver test and
+//   cycle detection of tmSimulate() do not apply.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), multiTableLine()
+*/
+int64_t
+multiSimulate(TuringMachineT *tm, int64_t max_iters, int64_t tape_len_max)
+{
+  MultiT        *this   = tm->multi;
+  const int      tapes  = this->tapes;
+  int64_t        iters  = 0;
+  int64_t        status = -1;
+  State          state  = tm->state;
+  int            ti;
+
+  if(multiLoad(this, tm) < 0) {
+    return -4;
+  }
+
+  while(iters < max_iters) {
+    int64_t            ei = state * this->rows;
+    const MultiEntryT *entry;
+    const Char        *write;
+    const int8_t      *delta;
+    int                edge = 0;
+
+    for(ti = 0; ti < tapes; ti++) {
+      const MultiTapeT *tape = &this->tape[ti];
+
+      ei += tape->frames[tape->here + tape->origin] * this->stride[ti];
+    }
+    entry = &this->entry[ei];
+
+    if(entry->next < 0) {
+      status = iters;
+      break;
+    }
+
+    write = &this->write[ei * tapes];
+    delta = &this->delta[ei * tapes];
+
+    /* Make room for the heads first, so that running out of memory
+    // leaves the machine as it was before the transition
+    */
+    for(ti = 0; ti < tapes; ti++) {
+      MultiTapeT    *tape = &this->tape[ti];
+      const int64_t  here = tape->here + delta[ti];
+
+      if(((here < tape->left_end) || (here > tape->right_end))
+         && (multiTapeReserve(tape, here) < 0))
+      {
+        break;
+      }
+    }
+    if(ti < tapes) {
+      status = -4;
+      break;
+    }
+
+    for(ti = 0; ti < tapes; ti++) {
+      MultiTapeT *tape = &this->tape[ti];
+
+      tape->frames[tape->here + tape->origin] = write[ti];
+      tape->here += delta[ti];
+
+      if(tape->here < tape->left_end) {
+        tape->left_end = tape->here;
+        edge = 1;
+      } else if(tape->here > tape->right_end) {
+        tape->right_end = tape->here;
+        edge = 1;
+      }
+    }
+    state = entry->next;
+    iters ++;
+
+    if(entry->stop) {
+      status = iters;
+      break;
+    }
+    if(edge) {
+      for(ti = 0; ti < tapes; ti++) {
+        const MultiTapeT *tape = &this->tape[ti];
+
+        if(tape->right_end - tape->left_end + 1 >= tape_len_max) break;
+      }
+      if(ti < tapes) {
+        status = -2;
+        break;
+      }
+    }
+  }
+
+  tm->state = state;
+  if(multiUnload(this, tm) < 0) {
+    return -4;
+  }
+
+  return status;
+}
+
+
+
+
+/* NAME
+//   multiPrint: print the tapes of a multi-tape machine after tape 0
+//
+//
+// DESCRIPTION
+//   Tape 0 is the tape of the machine, printed by tmTapePrint().  The
+//   others are printed in the same way.
+*/
+void
+multiPrint(const TuringMachineT *tm)
+{
+  const MultiT *this = tm->multi;
+  int           ti;
+  int64_t       here;
+
+  for(ti = 1; ti < this->tapes; ti++) {
+    const MultiTapeT *tape = &this->tape[ti];
+
+    if(NULL == tape->frames) continue;
+
+    printf("TAPE %i: %lli frames, head visited frames %lli to %lli\n", ti,
+           (long long) (tape->right_end - tape->left_end + 1),
+           (long long) tape->left_end, (long long) tape->right_end);
+    printf("-------\n");
+    for(here = tape->left_end; here <= tape->right_end; here++) {
+      if(here == 0) {
+        printf(" [0]>");
+      }
+      if(here == tape->here) {
+        printf(" [head@%lli]>", (long long) here);
+      }
+      printf(" %1i", tape->frames[here + tape->origin]);
+    }
+    printf("\n");
+  }
+}
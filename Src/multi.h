@@ -0,0 +1,105 @@
+/* multi.h: Turing Machine simulation with several tapes
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _MULTI_H__INCLUDED_
+#define _MULTI_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* MULTI_TAPES_MAX: most tapes a machine can have */
+#define MULTI_TAPES_MAX 8
+
+/* MULTI_ROWS_MAX: most input tuples of one state, (charset_max+1)^tapes */
+#define MULTI_ROWS_MAX (1 << 20)
+
+
+
+
+/* MultiTapeT: one tape of a multi-tape machine
+//
+// Stored one Char per frame, like tape_wide.  Every frame outside of
+// [left_end, right_end] is blank.
+*/
+typedef struct {
+  Char    *frames;      /* head position "here" is frames[here + origin] */
+  int64_t  origin;      /* index into frames[] of head position 0 */
+  int64_t  alloc;       /* number of elements allocated for frames[] */
+  int64_t  here;        /* head position */
+  int64_t  left_end;    /* leftmost head position accessed so far */
+  int64_t  right_end;   /* rightmost head position accessed so far */
+} MultiTapeT;
+
+
+
+
+/* MultiEntryT: how a transition moves on from an input tuple
+//
+// The symbols written and head moves are held apart, in write[] and
+// delta[] of MultiT, since their number depends on the machine.
+*/
+typedef struct {
+  State  next;   /* which state to enter next, or -1 if the machine file
+                 // gave no transition, in which case the machine stops
+                 // without writing or moving
+                 */
+  int8_t stop;   /* flag: the machine stops after this transition */
+} MultiEntryT;
+
+
+
+
+/* MultiT: state transition table and tapes of a multi-tape machine
+//
+// The machine reads the symbols under all of its heads at once, and
+// the tuple of symbols picks one of 'rows' transitions of the state:
+// the tuple (s0, s1, ..., s(k-1)) is row
+//
+//   s0 + s1 * (charset_max+1) + ... + s(k-1) * (charset_max+1)^(k-1)
+//
+// Each transition writes a symbol under each head, moves each head
+// left, right or not at all, and enters the next state.
+//
+// Tape 0 is the tape of the TuringMachineT, which is read from the
+// tape file and printed and written out as for any other machine.
+// The other tapes start blank.
+*/
+struct MultiS {
+  int          tapes;     /* number of tapes, k */
+  int64_t      rows;      /* number of input tuples, (charset_max+1)^k */
+  int64_t      stride[MULTI_TAPES_MAX]; /* (charset_max+1)^i */
+  int32_t      num_states;
+
+  MultiEntryT *entry;     /* entry[state * rows + row] */
+  Char        *write;     /* write[(state * rows + row) * tapes + i]: symbol
+                          // written under head i
+                          */
+  int8_t      *delta;     /* delta[(state * rows + row) * tapes + i]: -1, 0
+                          // or +1, how far head i moves
+                          */
+
+  MultiTapeT   tape[MULTI_TAPES_MAX];
+};
+
+
+
+
+MultiT * multiNew(int tapes, int charset_max);
+void     multiDestroy(MultiT *this);
+int      multiTableGrow(MultiT *this, int32_t num_states);
+int      multiTableLine(MultiT *this, int32_t state, int charset_max,
+                        const char *line, int32_t line_num, int32_t *next);
+void     multiTablePrint(const TuringMachineT *tm);
+void     multiPrint(const TuringMachineT *tm);
+int64_t  multiSimulate(TuringMachineT *tm, int64_t max_iters,
+                       int64_t tape_len_max);
+
+
+
+#endif
@@ -0,0 +1,524 @@
+/* page.c: Turing Machine tape stored in pages
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "page.h"
+
+
+
+
+/* PAGE_TABLE_MIN: number of pages spanned by a new page table */
+#define PAGE_TABLE_MIN 16
+
+
+
+
+/* page_zero: the page of every part of the tape never written
+//
+// Shared by every machine, and never written to: a page is given its
+// own memory the first time a non-blank symbol is written to it.
+*/
+static Char page_zero[PAGE_FRAMES];
+
+
+
+
+/* PageT: memory of a page of the tape
+//
+// The page table points to 'frames'.  A page is shared by the tapes of
+// a machine and the machines forked from it (see pageFork) until one
+// of them writes to it; 'refs' counts the page tables that point to
+// it.  page_zero is not a PageT, and is never counted.
+*/
+typedef struct {
+  int64_t refs;
+  Char    frames[PAGE_FRAMES];
+} PageT;
+
+/* PAGE_OF: the PageT whose frames a page table entry points to */
+#define PAGE_OF(page) ((PageT *)((char *)(page) - offsetof(PageT, frames)))
+
+
+
+
+/* PAGE_REFS, PAGE_REF, PAGE_UNREF: read, increment and decrement the
+// reference count of a page, returning the new count
+//
+// Forked machines may run on different threads, so the counts change
+// atomically.  A tape only ever writes to a page it alone holds, and
+// only its own thread can fork it, so a count of 1 stays 1 until the
+// tape that holds the page changes it.
+*/
+#ifdef __GNUC__
+#define PAGE_REFS(page) \
+  __atomic_load_n(&PAGE_OF(page)->refs, __ATOMIC_ACQUIRE)
+#define PAGE_REF(page) \
+  __atomic_add_fetch(&PAGE_OF(page)->refs, 1, __ATOMIC_RELAXED)
+#define PAGE_UNREF(page) \
+  __atomic_sub_fetch(&PAGE_OF(page)->refs, 1, __ATOMIC_ACQ_REL)
+#else
+#define PAGE_REFS(page)  (PAGE_OF(page)->refs)
+#define PAGE_REF(page)   (++ PAGE_OF(page)->refs)
+#define PAGE_UNREF(page) (-- PAGE_OF(page)->refs)
+#endif
+
+
+
+
+/* NAME
+//   pageNew: give a page of the tape its own memory
+//
+//
+// RETURN VALUE
+//   Return the new page, or NULL if the memory allocation fails, in
+//   which case the page table is unchanged.
+*/
+static Char *
+pageNew(TuringMachineT *this, int64_t pi)
+{
+  PageT *page;
+
+  if((page = calloc(1, sizeof(PageT)))==NULL) {
+    return NULL;
+  }
+  page->refs = 1;
+  this->tape_pages[pi] = page->frames;
+  this->tape_pages_resident ++;
+  return page->frames;
+}
+
+
+
+
+/* NAME
+//   pageRelease: drop a reference to a page, freeing it after the last
+*/
+static void
+pageRelease(Char *page)
+{
+  if(0 == PAGE_UNREF(page)) {
+    free(PAGE_OF(page));
+  }
+}
+
+
+
+
+/* NAME
+//   pageOwn: make sure a page of the tape may be written to
+//
+//
+// DESCRIPTION
+//   A page is written to only when this tape alone holds it.  A page
+//   that has never been written is given memory, and a page shared
+//   with a forked machine is copied, and the copy takes its place in
+//   the page table.
+//
+//
+// RETURN VALUE
+//   Return the page, or NULL if the memory allocation fails, in which
+//   case the page table is unchanged.
+*/
+static Char *
+pageOwn(TuringMachineT *this, int64_t pi)
+{
+  Char  *page = this->tape_pages[pi];
+  PageT *copy;
+
+  if(page_zero == page) {
+    return pageNew(this, pi);
+  }
+  if(1 == PAGE_REFS(page)) {
+    return page;
+  }
+
+  if((copy = malloc(sizeof(PageT)))==NULL) {
+    return NULL;
+  }
+  copy->refs = 1;
+  memcpy(copy->frames, page, sizeof(copy->frames));
+  pageRelease(page);
+  this->tape_pages[pi] = copy->frames;
+  return copy->frames;
+}
+
+
+
+
+/* NAME
+//   pageReserve: make sure the page table spans a range of head positions
+//
+//
+// DESCRIPTION
+//   pageReserve() is tmTapeReserve() for a paged tape.  The page table
+//   holds one pointer for every PAGE_FRAMES frames, and grows on either
+//   end in the same way as an unpaged tape does.  New entries point to
+//   page_zero, so growing the table allocates no pages.
+//
+//   tape_alloc is the number of frames the page table spans, and
+//   tape_origin only ever changes by a whole number of pages.
+//
+//
+// RETURN VALUE
+//   Return 0 on success, or -1 if the memory allocation fails.  The
+//   tape is unchanged either way, though the page table may have grown
+//   on one end before failing to grow on the other.
+//
+//
+// SEE ALSO
+//   tmTapeReserve()
+*/
+int
+pageReserve(TuringMachineT *this, int64_t left, int64_t right)
+{
+  int64_t pages = this->tape_alloc >> PAGE_BITS;
+  int64_t ti;
+  int64_t pi;
+
+  if(NULL == this->tape_pages) {
+    /* Allocate a new page table, centered on the head */
+    if((this->tape_pages = malloc(sizeof(Char *) * PAGE_TABLE_MIN))==NULL) {
+      return -1;
+    }
+    for(pi = 0; pi < PAGE_TABLE_MIN; pi++) {
+      this->tape_pages[pi] = page_zero;
+    }
+    pages = PAGE_TABLE_MIN;
+    this->tape_alloc  = pages * PAGE_FRAMES;
+    this->tape_origin = this->tape_alloc / 2 - this->here;
+  }
+
+  ti = left + this->tape_origin;
+
+  if(ti < 0) {
+    /* Grow the page table to the left */
+    const int64_t grow  = MAX(pages, (-ti + PAGE_MASK) >> PAGE_BITS);
+    Char        **table = malloc(sizeof(Char *) * (pages + grow));
+
+    if(NULL == table) {
+      return -1;
+    }
+    for(pi = 0; pi < grow; pi++) {
+      table[pi] = page_zero;
+    }
+    memcpy(&table[grow], this->tape_pages, sizeof(Char *) * pages);
+    free(this->tape_pages);
+
+    this->tape_pages   = table;
+    pages             += grow;
+    this->tape_alloc   = pages * PAGE_FRAMES;
+    this->tape_origin += grow * PAGE_FRAMES;
+  }
+
+  ti = right + this->tape_origin;
+
+  if(ti >= this->tape_alloc) {
+    /* Grow the page table to the right */
+    const int64_t grow  = MAX(pages, ((ti - this->tape_alloc) >> PAGE_BITS) + 1);
+    Char        **table = realloc(this->tape_pages,
+                                  sizeof(Char *) * (pages + grow));
+
+    if(NULL == table) {
+      return -1;
+    }
+    for(pi = pages; pi < pages + grow; pi++) {
+      table[pi] = page_zero;
+    }
+
+    this->tape_pages  = table;
+    pages            += grow;
+    this->tape_alloc  = pages * PAGE_FRAMES;
+  }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   pageFrameSet: set the value of the paged tape at tape index ti
+//
+//
+// DESCRIPTION
+//   The symbol counts are left to tmTapeFrameSet(), which is the only
+//   caller.  Writing a blank to a page that has never been written
+//   changes nothing, so it allocates nothing.  A page shared with a
+//   forked machine is copied first; see pageOwn().
+//
+//
+// RETURN VALUE
+//   Return 0 on success, or -1 if the page could not be given memory,
+//   in which case the tape is unchanged.
+*/
+int
+pageFrameSet(TuringMachineT *this, int64_t ti, Char value)
+{
+  Char *page = this->tape_pages[ti >> PAGE_BITS];
+
+  if((page_zero == page) && (0 == value)) return 0;
+  if((page = pageOwn(this, ti >> PAGE_BITS))==NULL) return -1;
+  page[ti & PAGE_MASK] = value;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   pageBlank: free every page of the tape, keeping the page table
+*/
+void
+pageBlank(TuringMachineT *this)
+{
+  const int64_t pages = this->tape_alloc >> PAGE_BITS;
+  int64_t       pi;
+
+  if(NULL == this->tape_pages) return;
+
+  for(pi = 0; pi < pages; pi++) {
+    if(this->tape_pages[pi] != page_zero) {
+      pageRelease(this->tape_pages[pi]);
+      this->tape_pages[pi] = page_zero;
+    }
+  }
+  this->tape_pages_resident = 0;
+}
+
+
+
+
+/* NAME
+//   pageFree: free every page of the tape, and the page table
+*/
+void
+pageFree(TuringMachineT *this)
+{
+  pageBlank(this);
+  free(this->tape_pages);
+  this->tape_pages = NULL;
+}
+
+
+
+
+/* NAME
+//   pageFork: share the pages of a tape with the tape of a forked machine
+//
+//
+// DESCRIPTION
+//   The page table of 'this' becomes a copy of that of 'parent', and
+//   every page with memory gains a reference, so forking costs one
+//   pointer per page spanned, whatever is written on the tape.  From
+//   then on, whichever machine writes to a shared page first gets a
+//   copy of its own (see pageOwn), so neither sees what the other
+//   writes.  The rest of the tape, such as tape_alloc and tape_origin,
+//   is left for the caller to copy.
+//
+//
+// RETURN VALUE
+//   Return 0 on success, or -1 if the memory allocation fails, in which
+//   case 'this' has no page table.
+//
+//
+// SEE ALSO
+//   tmFork(), pageOwn()
+*/
+int
+pageFork(TuringMachineT *this, const TuringMachineT *parent)
+{
+  const int64_t pages = parent->tape_alloc >> PAGE_BITS;
+  int64_t       pi;
+
+  this->tape_pages          = NULL;
+  this->tape_pages_resident = 0;
+  if(NULL == parent->tape_pages) return 0;
+
+  if((this->tape_pages = malloc(sizeof(Char *) * pages))==NULL) {
+    return -1;
+  }
+  memcpy(this->tape_pages, parent->tape_pages, sizeof(Char *) * pages);
+  for(pi = 0; pi < pages; pi++) {
+    if(this->tape_pages[pi] != page_zero) {
+      PAGE_REF(this->tape_pages[pi]);
+    }
+  }
+  this->tape_pages_resident = parent->tape_pages_resident;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   pagePrint: print how many pages of the tape have memory
+*/
+void
+pagePrint(const TuringMachineT *this)
+{
+  const int64_t pages   = this->tape_alloc >> PAGE_BITS;
+  int64_t       spanned = 0;
+  int64_t       shared  = 0;
+  int64_t       pi;
+
+  if(this->tape_len) {
+    spanned = ((this->right_end + this->tape_origin) >> PAGE_BITS)
+            - ((this->left_end  + this->tape_origin) >> PAGE_BITS) + 1;
+  }
+  if(this->tape_pages != NULL) {
+    for(pi = 0; pi < pages; pi++) {
+      if((this->tape_pages[pi] != page_zero)
+         && (PAGE_REFS(this->tape_pages[pi]) > 1))
+      {
+        shared ++;
+      }
+    }
+  }
+  printf("tape pages: %lli resident of %lli spanned by the tape,"
+         " %lli bytes of %lli frames each\n",
+         (long long) this->tape_pages_resident, (long long) spanned,
+         (long long) (this->tape_pages_resident * PAGE_FRAMES * sizeof(Char)),
+         (long long) PAGE_FRAMES);
+  if(shared) {
+    printf("tape pages: %lli shared with forked machines\n",
+           (long long) shared);
+  }
+}
+
+
+
+
+/* NAME
+//   pageRun: run the compiled program on a paged tape
+//
+//
+// DESCRIPTION
+//   pageRun is the part of tmRun() that runs machines whose tape is
+//   stored in pages (see tape_paged).  It runs the OpWide form of the
+//   table, which holds any charset_max.
+//
+//   The page under the head, and the part of it inside the tape
+//   accessed so far, are held in local variables, so that the page
+//   table is only looked at when the head moves onto another page.
+//   A frame is only stored when its value changes, so a machine that
+//   moves over blank tape without writing to it never gives a page
+//   its own memory, and a page shared with a forked machine is only
+//   copied when the machine changes a frame of it.
+//
+//   Arguments and return values are those of tmRun().
+//
+//
+// SEE ALSO
+//   tmRun(), tmTableCompileWide()
+*/
+int64_t
+pageRun(TuringMachineT *this, int64_t budget, Event *event)
+{
+  const int64_t   line_length = this->charset_max + 1;
+  const OpWide   *program     = this->program_wide;
+  int64_t        *count       = this->symbol_count;
+  const OpWide   *break_row   = NULL;
+  int64_t         shifts      = 0;
+  const OpWide   *rowp;    /* the current state's row in program */
+  int64_t         ti;      /* tape index of the head */
+
+  if(this->break_state >= 0) {
+    break_row = program + this->break_state * line_length;
+  }
+
+  /* Load the machine into local variables */
+  rowp = program + this->state * line_length;
+  ti   = this->here + this->tape_origin;
+
+  *event = EVENT_BUDGET;
+
+  while((EVENT_BUDGET == *event) && (shifts < budget)) {
+    /* Load the page under the head */
+    const int64_t page_ti = ti & ~PAGE_MASK; /* tape index of page[0] */
+    const int64_t lo = MAX(this->left_end + this->tape_origin, page_ti)
+                       - page_ti;
+    const int64_t hi = MIN(this->right_end + this->tape_origin,
+                           page_ti + PAGE_MASK) - page_ti;
+    Char         *page = this->tape_pages[ti >> PAGE_BITS];
+    int64_t       off  = ti - page_ti; /* head offset within page */
+    int           own  = (page != page_zero) && (1 == PAGE_REFS(page));
+                         /* flag: page may be written to */
+
+    while(shifts < budget) {
+      const Char    read  = page[off];
+      const OpWide  op    = rowp[read];
+      const Char    write = OPW_WRITE(op);
+      const int32_t delta = OPW_DELTA(op);
+
+      if(write != read) {
+        if(! own) {
+          Char *owned = pageOwn(this, page_ti >> PAGE_BITS);
+
+          if(NULL == owned) {
+            /* Leave the machine as it was before this shift */
+            *event = EVENT_ERROR;
+            break;
+          }
+          page = owned;
+          own  = 1;
+        }
+        count[read] --;
+        count[write] ++;
+        page[off] = write;
+      }
+      rowp = program + OPW_ROW(op);
+      shifts ++;
+
+      if(0 == delta) {
+        *event = EVENT_STOP;
+        break;
+      }
+      off += delta;
+
+      if((uint64_t)(off - lo) > (uint64_t)(hi - lo)) {
+        /* Head left the part of the page inside the tape extent */
+        if((page_ti + off < this->left_end + this->tape_origin)
+           || (page_ti + off > this->right_end + this->tape_origin))
+        {
+          this->here = page_ti + off - this->tape_origin;
+          if(tmTapeAlloc(this) < 0) {
+            off   -= delta;
+            *event = EVENT_ERROR;
+            break;
+          }
+          *event = EVENT_EDGE;
+        } else if(break_row == rowp) {
+          *event = EVENT_BREAK;
+        }
+        break;
+      }
+      if(break_row == rowp) {
+        *event = EVENT_BREAK;
+        break;
+      }
+    }
+
+    if(EVENT_EDGE == *event) {
+      ti = this->here + this->tape_origin;
+    } else {
+      ti = page_ti + off;
+    }
+  }
+
+  /* Store the local variables back into the machine */
+  this->here  = ti - this->tape_origin;
+  this->state = (rowp - program) / line_length;
+
+  return shifts;
+}
@@ -0,0 +1,41 @@
+/* page.h: Turing Machine tape stored in pages
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _PAGE_H__INCLUDED_
+#define _PAGE_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* PAGE_BITS: log2 of the number of tape frames in a page */
+#define PAGE_BITS   12
+#define PAGE_FRAMES ((int64_t)1 << PAGE_BITS)
+#define PAGE_MASK   (PAGE_FRAMES - 1)
+
+
+
+
+/* PAGE_AT: value of the paged tape at tape index ti */
+#define PAGE_AT(tm, ti) \
+  ((tm)->tape_pages[(ti) >> PAGE_BITS][(ti) & PAGE_MASK])
+
+
+
+
+int      pageReserve(TuringMachineT *this, int64_t left, int64_t right);
+int      pageFrameSet(TuringMachineT *this, int64_t ti, Char value);
+void     pageBlank(TuringMachineT *this);
+void     pageFree(TuringMachineT *this);
+int      pageFork(TuringMachineT *this, const TuringMachineT *parent);
+void     pagePrint(const TuringMachineT *this);
+int64_t  pageRun(TuringMachineT *this, int64_t budget, Event *event);
+
+
+
+#endif
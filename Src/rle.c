@@ -0,0 +1,429 @@
+/* rle.c: Turing Machine simulation on a run-length encoded tape
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "rle.h"
+
+
+
+
+/* NAME
+//   rleNew: allocate a new, blank, run-length encoded tape
+//
+//
+// RETURN VALUE
+//   Returns NULL if memory could not be allocated.
+*/
+RleT *
+rleNew(void)
+{
+  RleT *this;
+
+  if((this = calloc(1, sizeof(RleT))) == NULL) {
+    fprintf(stderr, "rleNew: out of memory\n");
+    return NULL;
+  }
+
+  this->facing = 1;
+
+  return this;
+}
+
+
+
+
+void
+rleDestroy(RleT *this)
+{
+  if(this != NULL) {
+    free(this->left.runs);
+    free(this->right.runs);
+    free(this);
+  }
+}
+
+
+
+
+void
+rlePrint(const RleT *this)
+{
+  printf("rle: %lli transitions, %lli crossed a run (%lli shifts), "
+         "at most %lli runs\n",
+         (long long) this->updates, (long long) this->chains,
+         (long long) this->chain_shifts, (long long) this->runs_max);
+}
+
+
+
+
+/* NAME
+//   rleReserve: make room for more runs on a stack of runs
+//
+//
+// RETURN VALUE
+//   Returns 0 if 'runs' more runs can be pushed onto 'stack' without
+//   allocating memory, or -1 if the memory allocation fails, in which
+//   case the stack is unchanged.
+*/
+static int
+rleReserve(RunStackT *stack, int64_t runs)
+{
+  if(stack->len + runs > stack->alloc) {
+    const int64_t alloc = MAX(64, MAX(2 * stack->alloc, stack->len + runs));
+    RunT         *mem   = realloc(stack->runs, sizeof(RunT) * alloc);
+
+    if(NULL == mem) {
+      return -1;
+    }
+    stack->runs  = mem;
+    stack->alloc = alloc;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   rlePush: push frames onto a stack of runs
+//
+//
+// DESCRIPTION
+//   Pushes 'count' frames holding 'symbol' onto the top of 'stack',
+//   merging them into the top run if it holds the same symbol.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails, in
+//   which case the stack is unchanged.
+*/
+static int
+rlePush(RunStackT *stack, Char symbol, int64_t count)
+{
+  if(stack->len > 0) {
+    RunT * const top = &stack->runs[stack->len - 1];
+
+    if(top->symbol == symbol) {
+      top->count    += count;
+      stack->frames += count;
+      return 0;
+    }
+  }
+
+  if(rleReserve(stack, 1) < 0) {
+    return -1;
+  }
+
+  stack->runs[stack->len].symbol = symbol;
+  stack->runs[stack->len].count  = count;
+  stack->len ++;
+  stack->frames += count;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   rlePop: remove frames from the top of a stack of runs
+//
+//
+// DESCRIPTION
+//   'count' must be no more than the length of the top run, except for
+//   a blank run at the bottom of the stack: the tape past the bottom
+//   of the stack is blank too, so any number of frames can be taken.
+*/
+static void
+rlePop(RunStackT *stack, int64_t count)
+{
+  RunT * const top = &stack->runs[stack->len - 1];
+
+  if(count >= top->count) {
+    stack->frames -= top->count;
+    stack->len --;
+  } else {
+    stack->frames -= count;
+    top->count    -= count;
+  }
+}
+
+
+
+
+/* NAME
+//   rleLoad: encode the Turing Machine tape into runs
+//
+//
+// DESCRIPTION
+//   Every frame from left_end to right_end goes into the runs, blank or
+//   not, so the runs always hold exactly the extent of the tape.  The
+//   head ends up facing right, just left of the frame under the Turing
+//   Machine tape head.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+int
+rleLoad(RleT *this, const TuringMachineT *tm)
+{
+  int64_t pos;
+
+  this->left.len     = 0;
+  this->left.frames  = 0;
+  this->right.len    = 0;
+  this->right.frames = 0;
+  this->facing       = 1;
+
+  for(pos = tm->left_end; pos < tm->here; pos++) {
+    if(rlePush(&this->left, tmTapeFrameAt(tm, pos), 1) < 0) return -1;
+  }
+  for(pos = tm->right_end; pos >= tm->here; pos--) {
+    if(rlePush(&this->right, tmTapeFrameAt(tm, pos), 1) < 0) return -1;
+  }
+
+  this->runs_max = MAX(this->runs_max, this->left.len + this->right.len);
+  return 0;
+}
+
+
+
+
+/* NAME
+//   rleUnload: decode the runs onto the Turing Machine tape
+//
+//
+// DESCRIPTION
+//   The head position and the extent of the tape (left_end, right_end)
+//   must already be up to date.  Every frame within that extent is
+//   written.
+//
+//
+// RETURN VALUE
+//   Returns 0 on success, or -1 if the memory allocation fails.
+*/
+int
+rleUnload(const RleT *this, TuringMachineT *tm)
+{
+  const int64_t here = tm->here;
+  int64_t       pos;
+  int64_t       ri;
+  int64_t       count;
+
+  if(tmTapeReserve(tm, tm->left_end, tm->right_end) < 0) {
+    return -1;
+  }
+
+  /* The frame under the head is the first frame on the side it faces */
+  pos = (this->facing > 0) ? here - 1 : here;
+  for(ri = this->left.len - 1; ri >= 0; ri--) {
+    for(count = this->left.runs[ri].count; count > 0; count--, pos--) {
+      tm->here = pos;
+      if(tmTapeFrameSet(tm, this->left.runs[ri].symbol) < 0) {
+        tm->here = here;
+        return -1;
+      }
+    }
+  }
+
+  pos = (this->facing > 0) ? here : here + 1;
+  for(ri = this->right.len - 1; ri >= 0; ri--) {
+    for(count = this->right.runs[ri].count; count > 0; count--, pos++) {
+      tm->here = pos;
+      if(tmTapeFrameSet(tm, this->right.runs[ri].symbol) < 0) {
+        tm->here = here;
+        return -1;
+      }
+    }
+  }
+
+  tm->here = here;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   rleStep: take one transition on the run-length encoded tape
+//
+//
+// DESCRIPTION
+//   The transition reads the frame under the head, at the top of the
+//   runs the head faces.  The written frame goes onto the runs behind
+//   the head if the head keeps going the same way, or back onto the
+//   runs ahead of it if the head turns around.
+//
+//   A transition that keeps the same state and direction would carry
+//   the head across the whole run it reads, rewriting every frame the
+//   same way.  rleStep takes such a transition once for the whole run,
+//   moving the run from one side of the head to the other.  The blank
+//   run at the bottom of a stack goes on forever past the end of the
+//   tape, so crossing it is cut short where the tape reaches
+//   tape_len_max.  Likewise no crossing goes past max_iters, so shift
+//   counts and the tape extent agree exactly with tmSimulate().
+//
+//   The frame under the head is always in the runs: when the head
+//   moves off the end of the tape a blank run of 1 is pushed for it.
+//
+//   The state, head position and tape extent of the Turing Machine are
+//   kept up to date, but its tape is not; see rleUnload.  *iters must
+//   be less than max_iters, and the tape shorter than tape_len_max.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine stopped.
+//   Returns -1 if the memory allocation fails, in which case the
+//   transition is not taken.
+//   Returns 0 otherwise.
+*/
+int
+rleStep(RleT *this, TuringMachineT *tm, int64_t *iters, int64_t max_iters,
+        int64_t tape_len_max)
+{
+  const int64_t     line_length = tm->charset_max + 1;
+  const int64_t     row    = tm->state * line_length;
+  RunStackT * const ahead  = (this->facing > 0) ? &this->right : &this->left;
+  RunStackT * const behind = (this->facing > 0) ? &this->left  : &this->right;
+  const RunT * const top   = &ahead->runs[ahead->len - 1];
+  const Op          op     = tm->program[row + top->symbol];
+  const int32_t     delta  = OP_DELTA(op);
+  int64_t           count  = 1;
+
+  /* A transition pushes at most two runs, so make room for them first */
+  if((rleReserve(&this->left, 2) < 0) || (rleReserve(&this->right, 2) < 0)) {
+    return -1;
+  }
+
+  if((delta == this->facing) && (OP_ROW(op) == row)) {
+    /* Cross the whole run, stopping short of the limits */
+    const int64_t room = tape_len_max - tm->tape_len;
+
+    count = max_iters - *iters;
+    if((ahead->len > 1) || (top->symbol != 0)) {
+      count = MIN(count, top->count);
+    }
+    if(delta > 0) {
+      count = MIN(count, tm->right_end - tm->here + room);
+    } else {
+      count = MIN(count, tm->here - tm->left_end + room);
+    }
+
+    this->chains ++;
+    this->chain_shifts += count;
+  }
+
+  this->updates ++;
+  rlePop(ahead, count);
+
+  tm->state  = OP_ROW(op) / line_length;
+  tm->here  += delta * count;
+  *iters    += count;
+
+  if(0 == delta) {
+    rlePush(ahead, OP_WRITE(op), 1);
+    return 1;
+  }
+
+  if(delta == this->facing) {
+    rlePush(behind, OP_WRITE(op), count);
+  } else {
+    rlePush(ahead, OP_WRITE(op), 1);
+    this->facing = delta;
+  }
+
+  this->runs_max = MAX(this->runs_max, this->left.len + this->right.len);
+
+  if(tm->here < tm->left_end) {
+    tm->left_end = tm->here;
+    rlePush(&this->left, 0, 1);
+  } else if(tm->here > tm->right_end) {
+    tm->right_end = tm->here;
+    rlePush(&this->right, 0, 1);
+  } else {
+    return 0;
+  }
+  tm->tape_len = tm->right_end - tm->left_end + 1;
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmRleSimulate: perform a Turing Machine simulation on a run-length
+//   encoded tape
+//
+//
+// DESCRIPTION
+//   Busy beavers build long runs of identical frames and then sweep
+//   across them.  On a run-length encoded tape (see RleT), a sweep
+//   across a run costs one transition however long the run is, and the
+//   memory used grows with the number of runs rather than with the
+//   length of the tape.  See rleStep.
+//
+//   The Turing Machine tape is encoded into runs at the start and
+//   decoded again at the end, so the final tape, shift count and return
+//   value are identical to those of tmSimulate().
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), rleStep()
+*/
+int64_t
+tmRleSimulate(TuringMachineT *this, RleT *rle, int64_t max_iters,
+              int64_t tape_len_max)
+{
+  int64_t iters  = 0;
+  int     status = 0;
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  if((0 == status) && (iters < max_iters) && (this->tape_len < tape_len_max))
+  {
+    if(rleLoad(rle, this) < 0) {
+      return -4;
+    }
+    while((iters < max_iters) && (this->tape_len < tape_len_max)) {
+      const int stop = rleStep(rle, this, &iters, max_iters, tape_len_max);
+
+      if(stop) {
+        status = (stop < 0) ? -4 : 1;
+        break;
+      }
+    }
+    if(rleUnload(rle, this) < 0) {
+      status = -4;
+    }
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
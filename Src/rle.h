@@ -0,0 +1,76 @@
+/* rle.h: Turing Machine simulation on a run-length encoded tape
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _RLE_H__INCLUDED_
+#define _RLE_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* RunT: 'count' consecutive tape frames holding 'symbol' */
+typedef struct {
+  Char    symbol;
+  int64_t count;
+} RunT;
+
+
+
+
+/* RunStackT: the runs on one side of the tape head
+//
+// runs[len-1] is the run next to the head, and runs[0] reaches the end
+// of the tape extent.  Past runs[0] the tape is blank out to infinity.
+*/
+typedef struct {
+  RunT    *runs;
+  int64_t  len;    /* number of runs */
+  int64_t  alloc;  /* number of elements allocated for runs[] */
+  int64_t  frames; /* number of frames in all of the runs */
+} RunStackT;
+
+
+
+
+/* RleT: run-length encoded tape
+//
+// The head sits on the boundary between the 'left' runs and the
+// 'right' runs, facing one of them.  The frame under the head is the
+// frame next to the boundary on the side the head faces, so the runs
+// the head faces are never empty.  Between them the runs hold exactly
+// the frames from left_end to right_end.
+*/
+typedef struct {
+  RunStackT  left;
+  RunStackT  right;
+  int        facing;      /* +1: head reads the top of 'right'
+                          // -1: head reads the top of 'left'
+                          */
+
+  int64_t    runs_max;    /* most runs on the tape at once */
+  int64_t    updates;     /* number of transitions taken */
+  int64_t    chains;      /* number of transitions that crossed a run */
+  int64_t    chain_shifts;/* shifts taken by those transitions */
+} RleT;
+
+
+
+
+RleT *   rleNew(void);
+void     rleDestroy(RleT *this);
+void     rlePrint(const RleT *this);
+int      rleLoad(RleT *this, const TuringMachineT *tm);
+int      rleUnload(const RleT *this, TuringMachineT *tm);
+int      rleStep(RleT *this, TuringMachineT *tm, int64_t *iters,
+                 int64_t max_iters, int64_t tape_len_max);
+int64_t  tmRleSimulate(TuringMachineT *this, RleT *rle, int64_t max_iters,
+                       int64_t tape_len_max);
+
+
+
+#endif
@@ -0,0 +1,760 @@
+/* rule.c: Turing Machine simulation with proven rules on a run-length tape
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "rle.h"
+#include "rule.h"
+
+
+
+
+/* RULE_TRANSITIONS_MAX: most run-length transitions in a rule
+//
+// Proving a rule takes about as long as the run-length transitions it
+// covers, so longer rules are not tried.
+*/
+#define RULE_TRANSITIONS_MAX 4096
+
+
+
+
+/* RULE_BACKOFF_MAX: log2 of most visits skipped after a failed proof
+//
+// Each failed proof in a configuration doubles the number of visits to
+// it before the next try, up to 2^RULE_BACKOFF_MAX.
+*/
+#define RULE_BACKOFF_MAX 12
+
+
+
+
+/* RuleWide: integer wide enough for shift counts of many iterations */
+#ifdef __SIZEOF_INT128__
+typedef __int128 RuleWide;
+#else
+typedef int64_t RuleWide;
+#endif
+
+
+
+
+/* SymRunT, SymStackT: runs of symbolic length, for proving rules */
+typedef struct {
+  Char    symbol;
+  AffineT count;
+} SymRunT;
+
+typedef struct {
+  SymRunT *runs;
+  int      len;
+  int      anchored;
+} SymStackT;
+
+
+
+
+/* NAME
+//   rulesNew: allocate tables of configurations and rules
+//
+//
+// ARGUMENTS
+//   bits (in): log2 of the number of configurations and rules kept
+//
+//
+// RETURN VALUE
+//   Returns NULL if the arguments are bad or memory could not be
+//   allocated.
+*/
+RulesT *
+rulesNew(int bits)
+{
+  RulesT *this;
+
+  if((bits < 1) || (bits > 24)) {
+    fprintf(stderr, "rulesNew: bits must be from 1 to 24\n");
+    return NULL;
+  }
+
+  if((this = calloc(1, sizeof(RulesT))) == NULL) {
+    fprintf(stderr, "rulesNew: out of memory\n");
+    return NULL;
+  }
+
+  this->bits    = bits;
+  this->rle     = rleNew();
+  this->history = calloc((size_t)1 << bits, sizeof(RuleHistoryT));
+  this->rules   = calloc((size_t)1 << bits, sizeof(RuleT));
+
+  if((NULL == this->rle) || (NULL == this->history) || (NULL == this->rules))
+  {
+    fprintf(stderr, "rulesNew: out of memory\n");
+    rulesDestroy(this);
+    return NULL;
+  }
+
+  return this;
+}
+
+
+
+
+void
+rulesDestroy(RulesT *this)
+{
+  if(this != NULL) {
+    rleDestroy(this->rle);
+    free(this->history);
+    free(this->rules);
+    free(this);
+  }
+}
+
+
+
+
+void
+rulesPrint(const RulesT *this)
+{
+  rlePrint(this->rle);
+  printf("rule: %lli tried, %lli proven, %lli applied "
+         "(%lli iterations, %lli shifts)\n",
+         (long long) this->proofs, (long long) this->proven,
+         (long long) this->applied, (long long) this->iterations,
+         (long long) this->rule_shifts);
+}
+
+
+
+
+/* NAME
+//   ruleConfig: find the configuration of the runs nearest the head
+//
+//
+// ARGUMENTS
+//   config (out): the configuration
+//
+//   count (out): lengths of the runs in the configuration
+//
+//
+// RETURN VALUE
+//   Returns a hash of the configuration.
+*/
+static uint64_t
+ruleConfig(const RleT *rle, const TuringMachineT *tm, RuleConfigT *config,
+           int64_t count[2][RULE_WINDOW])
+{
+  uint64_t hash;
+  int      side;
+  int      ri;
+
+  memset(config, 0, sizeof(RuleConfigT));
+  config->state  = tm->state;
+  config->facing = rle->facing;
+  hash = (uint64_t)tm->state * 2 + (rle->facing > 0);
+
+  for(side = 0; side < 2; side++) {
+    const RunStackT * const stack = side ? &rle->right : &rle->left;
+    const int               len   = MIN(stack->len, RULE_WINDOW);
+
+    config->len[side]      = len;
+    config->anchored[side] = (stack->len <= RULE_WINDOW);
+    hash = (hash * 0x9e3779b97f4a7c15ULL) ^ (len * 2 + (stack->len <= RULE_WINDOW));
+
+    for(ri = 0; ri < len; ri++) {
+      const RunT * const run = &stack->runs[stack->len - 1 - ri];
+
+      config->symbol[side][ri] = run->symbol;
+      count[side][ri]          = run->count;
+      hash = (hash * 0x9e3779b97f4a7c15ULL) ^ (unsigned char) run->symbol;
+    }
+  }
+
+  return hash * 0xbf58476d1ce4e5b9ULL;
+}
+
+
+
+
+/* affineEval: value of 'e' for unknowns 'x' */
+static RuleWide
+affineEval(const AffineT *e, const int64_t *x, int vars)
+{
+  RuleWide value = e->c;
+  int      v;
+
+  for(v = 0; v < vars; v++) {
+    value += (RuleWide) e->a[v] * x[v];
+  }
+  return value;
+}
+
+
+
+
+/* affineAdd: e += f */
+static void
+affineAdd(AffineT *e, const AffineT *f)
+{
+  int v;
+
+  e->c += f->c;
+  for(v = 0; v < RULE_VARS; v++) {
+    e->a[v] += f->a[v];
+  }
+}
+
+
+
+
+/* affineConstant: flag: 'e' has no unknowns */
+static int
+affineConstant(const AffineT *e)
+{
+  int v;
+
+  for(v = 0; v < RULE_VARS; v++) {
+    if(e->a[v]) return 0;
+  }
+  return 1;
+}
+
+
+
+
+/* NAME
+//   symPush: push frames of symbolic length onto a stack of runs
+//
+//
+// RETURN VALUE
+//   Returns 0 if the frames might merge with runs outside of the window,
+//   1 otherwise.
+*/
+static int
+symPush(SymStackT *stack, Char symbol, const AffineT *count)
+{
+  if((stack->len > 0) && (stack->runs[stack->len - 1].symbol == symbol)) {
+    affineAdd(&stack->runs[stack->len - 1].count, count);
+    return 1;
+  }
+
+  if((0 == stack->len) && !stack->anchored) {
+    return 0;
+  }
+
+  stack->runs[stack->len].symbol = symbol;
+  stack->runs[stack->len].count  = *count;
+  stack->len ++;
+  return 1;
+}
+
+
+
+
+/* NAME
+//   ruleProveSteps: try to prove a rule from two visits to a configuration
+//
+//
+// ARGUMENTS
+//   history (in): the earlier visit
+//
+//   config, count (in): the configuration now, and its run lengths
+//
+//   transitions (in): run-length transitions taken between the visits
+//
+//   stacks (in/out): room for the symbolic runs on each side of the head
+//
+//   rule (out): the rule, if one was proven
+//
+//
+// DESCRIPTION
+//   Every run length that changed between the two visits becomes an
+//   unknown, x[v].  Starting from the configuration with those unknown
+//   lengths, ruleProveSteps takes the same number of run-length transitions
+//   the machine took between the visits, symbolically, the way
+//   rleStep() does.  Crossing a run adds its symbolic length to the
+//   shift count.  Taking a single frame from a run of unknown length
+//   assumes the run does not run out, which becomes a constraint on the
+//   unknowns.  If the machine ends up in the same configuration with
+//   each unknown length x[v] grown by the same amount it grew between
+//   the visits, and every other length unchanged, the rule holds for
+//   every x[] meeting the constraints.
+//
+//   The proof fails if the machine would stop, would run off forever
+//   into blank tape, or would reach past the runs in the window.
+//
+//
+// RETURN VALUE
+//   Returns 1 if a rule was proven, 0 otherwise.
+*/
+static int
+ruleProveSteps(const TuringMachineT *tm, const RuleHistoryT *history,
+               const RuleConfigT *config, int64_t count[2][RULE_WINDOW],
+               int64_t transitions, SymStackT stacks[2], RuleT *rule)
+{
+  const int64_t line_length = tm->charset_max + 1;
+  State         state       = config->state;
+  int           facing      = config->facing;
+  AffineT       one;
+  int           side;
+  int           ri;
+  int64_t       ti;
+
+  memset(rule, 0, sizeof(RuleT));
+  memset(&one, 0, sizeof(one));
+  one.c = 1;
+
+  rule->config      = *config;
+  rule->transitions = transitions;
+
+  /* Each run length that changed is an unknown, at least 1 */
+  for(side = 0; side < 2; side++) {
+    SymStackT * const stack = &stacks[side];
+
+    stack->len      = 0;
+    stack->anchored = config->anchored[side];
+
+    for(ri = config->len[side] - 1; ri >= 0; ri--) {
+      SymRunT * const run = &stack->runs[stack->len++];
+
+      memset(&run->count, 0, sizeof(AffineT));
+      run->symbol = config->symbol[side][ri];
+      rule->count[side][ri] = count[side][ri];
+
+      if(count[side][ri] != history->count[side][ri]) {
+        const int v = rule->vars ++;
+
+        rule->var_side[v] = side;
+        rule->var_run[v]  = ri;
+        rule->delta[v]    = count[side][ri] - history->count[side][ri];
+        run->count.a[v]   = 1;
+
+        rule->constraint[rule->constraints] = run->count;
+        rule->constraint[rule->constraints].c = -1;
+        rule->constraints ++;
+      } else {
+        run->count.c = count[side][ri];
+      }
+    }
+  }
+
+  for(ti = 0; ti < transitions; ti++) {
+    SymStackT * const ahead  = &stacks[facing > 0];
+    SymStackT * const behind = &stacks[facing < 0];
+    SymRunT   *       top;
+    Op                op;
+    int32_t           delta;
+    AffineT           crossed = one;
+
+    if(0 == ahead->len) {
+      /* The frame under the head is outside of the window */
+      return 0;
+    }
+    top   = &ahead->runs[ahead->len - 1];
+    op    = tm->program[state * line_length + top->symbol];
+    delta = OP_DELTA(op);
+
+    if(0 == delta) {
+      return 0;
+    }
+
+    if((delta == facing) && (OP_ROW(op) / line_length == state)) {
+      if(ahead->anchored && (1 == ahead->len) && (0 == top->symbol)) {
+        /* The machine would run off into blank tape forever */
+        return 0;
+      }
+      crossed = top->count;
+      ahead->len --;
+
+    } else if(affineConstant(&top->count)) {
+      if(0 == --top->count.c) {
+        ahead->len --;
+      }
+
+    } else {
+      /* Assume the run does not run out: count - 2 >= 0 */
+      if(rule->constraints == RULE_CONSTRAINTS_MAX) {
+        return 0;
+      }
+      rule->constraint[rule->constraints] = top->count;
+      rule->constraint[rule->constraints].c -= 2;
+      rule->constraints ++;
+      top->count.c --;
+    }
+
+    state = OP_ROW(op) / line_length;
+    affineAdd(&rule->steps, &crossed);
+    if(delta > 0) {
+      affineAdd(&rule->move, &crossed);
+    } else {
+      int v;
+
+      rule->move.c -= crossed.c;
+      for(v = 0; v < RULE_VARS; v++) rule->move.a[v] -= crossed.a[v];
+    }
+
+    if(delta == facing) {
+      if(!symPush(behind, OP_WRITE(op), &crossed)) return 0;
+    } else {
+      if(!symPush(ahead, OP_WRITE(op), &one)) return 0;
+      facing = delta;
+    }
+
+    /* The head moved off the end of the tape */
+    if(0 == stacks[facing > 0].len) {
+      if(!stacks[facing > 0].anchored) return 0;
+      symPush(&stacks[facing > 0], 0, &one);
+    }
+  }
+
+  /* The machine must be back in the configuration, x[v] grown by delta[v] */
+  if((state != config->state) || (facing != config->facing)) {
+    return 0;
+  }
+
+  for(side = 0; side < 2; side++) {
+    const SymStackT * const stack = &stacks[side];
+
+    if(stack->len != config->len[side]) {
+      return 0;
+    }
+
+    for(ri = 0; ri < config->len[side]; ri++) {
+      const SymRunT * const run = &stack->runs[stack->len - 1 - ri];
+      AffineT               expect;
+      int                   v;
+
+      if(run->symbol != config->symbol[side][ri]) {
+        return 0;
+      }
+
+      memset(&expect, 0, sizeof(expect));
+      expect.c = count[side][ri];
+      for(v = 0; v < rule->vars; v++) {
+        if((rule->var_side[v] == side) && (rule->var_run[v] == ri)) {
+          expect.c    = rule->delta[v];
+          expect.a[v] = 1;
+        }
+      }
+
+      if(memcmp(&expect, &run->count, sizeof(AffineT))) {
+        return 0;
+      }
+    }
+  }
+
+  rule->valid = 1;
+  return 1;
+}
+
+
+
+
+/* NAME
+//   ruleProve: try to prove a rule from two visits to a configuration
+//
+//
+// DESCRIPTION
+//   Makes room for the symbolic runs and calls ruleProveSteps.  'rule'
+//   is only written if a rule was proven.  If there is no memory for
+//   the runs, no rule is proven, and the machine goes on without it.
+*/
+static int
+ruleProve(RulesT *this, const TuringMachineT *tm, const RuleHistoryT *history,
+          const RuleConfigT *config, int64_t count[2][RULE_WINDOW],
+          int64_t updates, RuleT *rule)
+{
+  const int64_t transitions = updates - history->updates;
+  SymStackT     stacks[2];
+  RuleT         proof;
+  int           proven;
+
+  if((transitions < 1) || (transitions > RULE_TRANSITIONS_MAX)) {
+    return 0;
+  }
+
+  stacks[0].runs = malloc(sizeof(SymRunT) * (RULE_WINDOW + transitions + 2));
+  stacks[1].runs = malloc(sizeof(SymRunT) * (RULE_WINDOW + transitions + 2));
+  if((NULL == stacks[0].runs) || (NULL == stacks[1].runs)) {
+    free(stacks[0].runs);
+    free(stacks[1].runs);
+    return 0;
+  }
+
+  this->proofs ++;
+  proven = ruleProveSteps(tm, history, config, count, transitions, stacks,
+                          &proof);
+  if(proven) {
+    this->proven ++;
+    *rule = proof;
+  }
+
+  free(stacks[0].runs);
+  free(stacks[1].runs);
+
+  return proven;
+}
+
+
+
+
+/* NAME
+//   ruleApply: apply a proven rule as many times as allowed
+//
+//
+// DESCRIPTION
+//   After j iterations the unknowns are x[v] + j*delta[v], so every
+//   constraint, and the shifts and head movement of iteration j, are
+//   linear in j.  The number of iterations is the largest for which
+//   every constraint holds for every iteration, the tape stays shorter
+//   than tape_len_max and *iters does not go past max_iters.  Shift
+//   count and head movement after m iterations are sums of arithmetic
+//   series.
+//
+//
+// RETURN VALUE
+//   Returns the number of iterations applied.
+*/
+static int64_t
+ruleApply(RulesT *this, const RuleT *rule, TuringMachineT *tm,
+          int64_t count[2][RULE_WINDOW], int64_t *iters, int64_t max_iters,
+          int64_t tape_len_max)
+{
+  RleT * const rle    = this->rle;
+  const int64_t budget = max_iters - *iters;
+  int64_t      x[RULE_VARS];
+  int64_t      grow   = 0;
+  int64_t      m      = budget;
+  int64_t      lo;
+  RuleWide     s0;
+  RuleWide     sd     = 0;
+  RuleWide     h0;
+  RuleWide     hd     = 0;
+  RuleWide     shifts;
+  RuleWide     pairs;
+  int          side;
+  int          ri;
+  int          v;
+  int          ci;
+
+  /* Run lengths that are not unknowns must be the ones proven with */
+  for(side = 0; side < 2; side++) {
+    for(ri = 0; ri < rule->config.len[side]; ri++) {
+      int known = 1;
+
+      for(v = 0; v < rule->vars; v++) {
+        if((rule->var_side[v] == side) && (rule->var_run[v] == ri)) known = 0;
+      }
+      if(known && (count[side][ri] != rule->count[side][ri])) {
+        return 0;
+      }
+    }
+  }
+
+  for(v = 0; v < rule->vars; v++) {
+    x[v]  = count[rule->var_side[v]][rule->var_run[v]];
+    grow += rule->delta[v];
+    sd   += (RuleWide) rule->steps.a[v] * rule->delta[v];
+    hd   += (RuleWide) rule->move.a[v]  * rule->delta[v];
+  }
+
+  for(ci = 0; ci < rule->constraints; ci++) {
+    const RuleWide e0 = affineEval(&rule->constraint[ci], x, rule->vars);
+    RuleWide       de = 0;
+
+    for(v = 0; v < rule->vars; v++) {
+      de += (RuleWide) rule->constraint[ci].a[v] * rule->delta[v];
+    }
+    if(e0 < 0) {
+      return 0;
+    }
+    if((de < 0) && (e0 / -de + 1 < m)) {
+      m = (int64_t)(e0 / -de + 1);
+    }
+  }
+
+  if(grow > 0) {
+    m = MIN(m, (tape_len_max - 1 - tm->tape_len) / grow);
+  }
+
+  /* Largest m whose shifts fit the budget; each iteration shifts at least once */
+  s0 = affineEval(&rule->steps, x, rule->vars);
+  lo = 0;
+  while(lo < m) {
+    const int64_t mid = lo + (m - lo + 1) / 2;
+
+    pairs  = (RuleWide) mid * (mid - 1) / 2;
+    shifts = (RuleWide) mid * s0;
+    if((sd > 0) && (pairs > (RuleWide) budget / sd)) {
+      m = mid - 1;
+      continue;
+    }
+    shifts += sd * pairs;
+    if(shifts <= budget) {
+      lo = mid;
+    } else {
+      m = mid - 1;
+    }
+  }
+  m = lo;
+
+  if(0 == m) {
+    return 0;
+  }
+
+  pairs  = (RuleWide) m * (m - 1) / 2;
+  shifts = (RuleWide) m * s0 + sd * pairs;
+  h0     = affineEval(&rule->move, x, rule->vars);
+
+  for(v = 0; v < rule->vars; v++) {
+    RunStackT * const stack = rule->var_side[v] ? &rle->right : &rle->left;
+
+    stack->runs[stack->len - 1 - rule->var_run[v]].count += m * rule->delta[v];
+    stack->frames                                        += m * rule->delta[v];
+  }
+
+  /* The runs hold exactly the tape extent */
+  tm->here += (int64_t)((RuleWide) m * h0 + hd * pairs);
+  if(rle->facing > 0) {
+    tm->left_end  = tm->here - rle->left.frames;
+    tm->right_end = tm->here + rle->right.frames - 1;
+  } else {
+    tm->left_end  = tm->here - rle->left.frames + 1;
+    tm->right_end = tm->here + rle->right.frames;
+  }
+  tm->tape_len = tm->right_end - tm->left_end + 1;
+
+  *iters += (int64_t) shifts;
+
+  this->applied ++;
+  this->iterations  += m;
+  this->rule_shifts += (int64_t) shifts;
+
+  return m;
+}
+
+
+
+
+/* NAME
+//   tmRuleSimulate: perform a Turing Machine simulation with proven rules
+//
+//
+// DESCRIPTION
+//   Many long running machines behave like counters: the same
+//   configuration of runs near the head comes back again and again,
+//   with some run lengths grown or shrunk by the same amounts each
+//   time.  tmRuleSimulate runs the machine on a run-length encoded tape
+//   (see rleStep), remembering the last time it was in each
+//   configuration.  When a configuration comes back, ruleProve tries to
+//   prove that it always will, for any run lengths, and how many shifts
+//   it takes as a function of the run lengths.  From then on, whenever
+//   the machine is in that configuration, ruleApply jumps as many
+//   iterations ahead as the constraints of the rule, max_iters and
+//   tape_len_max allow, in one go.
+//
+//   Shift counts, final tapes and return values are identical to those
+//   of tmSimulate().
+//
+//   Proven rules depend on the state transition table, so 'rules' must
+//   not be reused after the table changes.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), tmRleSimulate(), ruleProve(), ruleApply()
+*/
+int64_t
+tmRuleSimulate(TuringMachineT *this, RulesT *rules, int64_t max_iters,
+               int64_t tape_len_max)
+{
+  const uint64_t mask   = ((uint64_t)1 << rules->bits) - 1;
+  int64_t        iters  = 0;
+  int            status = 0;
+  int            stop;
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  if((0 == status) && (iters < max_iters) && (this->tape_len < tape_len_max))
+  {
+    if(rleLoad(rules->rle, this) < 0) {
+      return -4;
+    }
+
+    while((iters < max_iters) && (this->tape_len < tape_len_max)) {
+      RuleConfigT    config;
+      int64_t        count[2][RULE_WINDOW];
+      const uint64_t hash = ruleConfig(rules->rle, this, &config, count);
+      RuleT * const  rule = &rules->rules[hash & mask];
+
+      if(rule->valid && !memcmp(&rule->config, &config, sizeof(config))) {
+        if(ruleApply(rules, rule, this, count, &iters, max_iters,
+                     tape_len_max))
+        {
+          continue;
+        }
+      } else {
+        RuleHistoryT * const history = &rules->history[hash & mask];
+
+        if(history->valid && !memcmp(&history->config, &config, sizeof(config)))
+        {
+          if(history->skip > 0) {
+            history->skip --;
+          } else if(ruleProve(rules, this, history, &config, count,
+                              rules->rle->updates, rule))
+          {
+            continue;
+          } else {
+            /* Try less and less often in configurations that fail */
+            history->failures ++;
+            history->skip = (1 << MIN(history->failures, RULE_BACKOFF_MAX)) - 1;
+          }
+        } else {
+          history->config   = config;
+          history->failures = 0;
+          history->skip     = 0;
+          history->valid    = 1;
+        }
+
+        history->updates = rules->rle->updates;
+        memcpy(history->count, count, sizeof(history->count));
+      }
+
+      stop = rleStep(rules->rle, this, &iters, max_iters, tape_len_max);
+      if(stop) {
+        status = (stop < 0) ? -4 : 1;
+        break;
+      }
+    }
+
+    if(rleUnload(rules->rle, this) < 0) {
+      status = -4;
+    }
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
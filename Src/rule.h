@@ -0,0 +1,126 @@
+/* rule.h: Turing Machine simulation with proven rules on a run-length tape
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _RULE_H__INCLUDED_
+#define _RULE_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+#include "rle.h"
+
+
+
+
+/* RULE_WINDOW: most runs on each side of the head that a rule covers */
+#define RULE_WINDOW 6
+
+
+
+
+/* RULE_VARS: most run lengths a rule can treat as unknowns */
+#define RULE_VARS (2 * RULE_WINDOW)
+
+
+
+
+/* RULE_CONSTRAINTS_MAX: most conditions a rule can put on its unknowns */
+#define RULE_CONSTRAINTS_MAX 32
+
+
+
+
+/* AffineT: c + a[0]*x[0] + a[1]*x[1] + ..., x[] being run lengths */
+typedef struct {
+  int64_t c;
+  int64_t a[RULE_VARS];
+} AffineT;
+
+
+
+
+/* RuleConfigT: the runs nearest the head, without their lengths
+//
+// Side 0 is the left of the head, side 1 the right.  symbol[side][0]
+// is the run next to the head.  A window is 'anchored' if it reaches
+// the end of the tape extent on that side.
+*/
+typedef struct {
+  State   state;
+  int8_t  facing;
+  int8_t  len[2];
+  int8_t  anchored[2];
+  Char    symbol[2][RULE_WINDOW];
+} RuleConfigT;
+
+
+
+
+/* RuleHistoryT: the last time the machine was in a configuration */
+typedef struct {
+  RuleConfigT config;                 /* key */
+  int64_t     count[2][RULE_WINDOW];  /* run lengths */
+  int64_t     updates;                /* run-length transitions so far */
+  int         valid;                  /* flag: slot in use */
+  int         failures;               /* number of failed proofs */
+  int         skip;                   /* visits left before trying again */
+} RuleHistoryT;
+
+
+
+
+/* RuleT: a proven rule
+//
+// A machine in 'config', with the length of run (var_side[v],
+// var_run[v]) being x[v], is back in 'config' after 'transitions'
+// run-length transitions taking 'steps' shifts, with run lengths
+// x[v] + delta[v] and all other run lengths as they were, as long as
+// every one of the 'constraint's is at least zero.  The head moves by
+// 'move'.  Run lengths that are not unknowns are the ones the rule was
+// proven with.
+*/
+typedef struct {
+  RuleConfigT config;                        /* key */
+  int64_t     count[2][RULE_WINDOW];         /* run lengths */
+  int         valid;                         /* flag: slot in use */
+  int         vars;                          /* number of unknowns */
+  int8_t      var_side[RULE_VARS];
+  int8_t      var_run[RULE_VARS];
+  int64_t     delta[RULE_VARS];
+  int64_t     transitions;
+  AffineT     steps;
+  AffineT     move;
+  int         constraints;
+  AffineT     constraint[RULE_CONSTRAINTS_MAX];
+} RuleT;
+
+
+
+
+typedef struct {
+  RleT         *rle;          /* the run-length encoded tape */
+  int           bits;         /* log2 of number of history and rule slots */
+  RuleHistoryT *history;      /* direct-mapped table of configurations */
+  RuleT        *rules;        /* direct-mapped table of proven rules */
+
+  int64_t       proofs;       /* number of rules tried */
+  int64_t       proven;       /* number of rules proven */
+  int64_t       applied;      /* number of times a rule was applied */
+  int64_t       iterations;   /* number of rule iterations applied */
+  int64_t       rule_shifts;  /* shifts taken by rule iterations */
+} RulesT;
+
+
+
+
+RulesT * rulesNew(int bits);
+void     rulesDestroy(RulesT *this);
+void     rulesPrint(const RulesT *this);
+int64_t  tmRuleSimulate(TuringMachineT *this, RulesT *rules,
+                        int64_t max_iters, int64_t tape_len_max);
+
+
+
+#endif
@@ -0,0 +1,465 @@
+/* search.c: busy beaver search on many threads
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+
+
+
+#include "tm.h"
+#include "cycle.h"
+#include "search.h"
+
+
+
+
+/* SEARCH_PERIOD: how often to write a table to restart the search from,
+// as in tmBusyBeaverSearch()
+*/
+#define SEARCH_PERIOD (21*21*21*21+1)
+
+
+
+
+/* SEARCH_LOAD, SEARCH_STORE, SEARCH_ADD: read, write and add to an
+// int64_t that other threads look at without taking a lock
+*/
+#ifdef __GNUC__
+#define SEARCH_LOAD(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define SEARCH_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define SEARCH_ADD(p, v)   __atomic_add_fetch(p, v, __ATOMIC_RELAXED)
+#else
+#define SEARCH_LOAD(p)     (*(p))
+#define SEARCH_STORE(p, v) (*(p) = (v))
+#define SEARCH_ADD(p, v)   (*(p) += (v))
+#endif
+
+
+
+
+/* NAME
+//   searchOnesMax: raise the most 1's found so far to 'count'
+//
+//
+// RETURN VALUE
+//   Returns the most 1's found before.
+*/
+static int64_t
+searchOnesMax(SearchT *this, int64_t count)
+{
+#ifdef __GNUC__
+  int64_t best = __atomic_load_n(&this->ones_max, __ATOMIC_RELAXED);
+  int64_t before;
+
+  do {
+    before = best;
+  } while((count > best)
+          && !__atomic_compare_exchange_n(&this->ones_max, &best, count, 0,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+  return before;
+#else
+  int64_t before;
+
+  pthread_mutex_lock(&this->lock);
+  before = this->ones_max;
+  if(count > this->ones_max) this->ones_max = count;
+  pthread_mutex_unlock(&this->lock);
+  return before;
+#endif
+}
+
+
+
+
+/* NAME
+//   searchResult: report how the simulation of a table went
+//
+//
+// DESCRIPTION
+//   Reports what tmBusyBeaverSearch() does: a machine that stopped with
+//   about as many 1's as the best so far is printed and written to
+//   files, and any other machine gets one character of output.
+*/
+static void
+searchResult(SearchWorkerT *this, int64_t index, int64_t iters)
+{
+  SearchT        *search = this->search;
+  TuringMachineT *tm     = this->tm;
+  char            table[TABLE_INDEX_CHARS];
+
+  if(iters >= 0) {
+    const int64_t count = tmTapeOneCount(tm);
+
+    if(count >= SEARCH_LOAD(&search->ones_max) - 1) {
+      const int64_t ones_max = searchOnesMax(search, count);
+      char          filename[128];
+
+      /* Keep other threads' output out of the middle of this */
+      tmTableIndexFormat(search->base + index, table);
+      flockfile(stdout);
+      printf("\ntable %s ties, with %lli\n", table, (long long) ones_max);
+      printf("\n");
+      tmTablePrint(tm);
+
+      sprintf(filename, "max%04lli.tm", (long long) count);
+      tmTableWrite(tm, filename);
+
+      sprintf(filename, "max%04lli.tape", (long long) count);
+      tmTapeWrite(tm, filename);
+
+      printf("table %s\n", table);
+      printf("The machine executed %lli shifts\n", (long long) iters);
+      printf("tape had %lli 1's\n", (long long) count);
+      printf("tape was %lli frames long\n", (long long) tm->tape_len);
+      fflush(stdout);
+      funlockfile(stdout);
+    }
+  } else if(-1 == iters) {
+    putchar('i');
+  } else if(-2 == iters) {
+    putchar('t');
+  } else if(-3 == iters) {
+    putchar('L');
+  } else if(-5 == iters) {
+    putchar('c');
+  }
+}
+
+
+
+
+/* NAME
+//   searchRestart: write the table to restart the search from
+//
+//
+// DESCRIPTION
+//   Every table before the lowest one some worker has not finished has
+//   been searched, so the search can be restarted from there.  The
+//   table is written to "periodic.tm", and becomes the table of the
+//   machine given to tmBusyBeaverSearchJobs(), which is what a signal
+//   handler should write out to restart from.
+*/
+static void
+searchRestart(SearchT *this)
+{
+  int64_t low       = INT64_MAX;
+  int64_t simulated = 0;
+  int64_t symmetric = 0;
+  char    table[TABLE_INDEX_CHARS];
+  int     wi;
+
+  pthread_mutex_lock(&this->lock);
+  for(wi = 0; wi < this->jobs; wi++) {
+    low        = MIN(low, SEARCH_LOAD(&this->worker[wi].low));
+    simulated += SEARCH_LOAD(&this->worker[wi].simulated);
+    symmetric += SEARCH_LOAD(&this->worker[wi].symmetric);
+  }
+  if(low < INT64_MAX) {
+    tmTableUnrank(this->tm, this->base + low);
+    tmTableWrite(this->tm, "periodic.tm");
+    flockfile(stdout);
+    printf("\ntable %s, %lli simulated, %lli symmetric\n",
+           tmTableIndexFormat(this->base + low, table),
+           (long long) simulated, (long long) symmetric);
+    tmTablePrint(this->tm);
+    fflush(stdout);
+    funlockfile(stdout);
+  }
+  pthread_mutex_unlock(&this->lock);
+}
+
+
+
+
+/* NAME
+//   searchTake: take the next batch of tables for a worker to search
+//
+//
+// DESCRIPTION
+//   The batch comes from the front of the worker's own range.  When the
+//   range is used up, the worker steals the back half of the largest
+//   range any worker has left, so no thread sits idle while another
+//   has tables to search, however long one machine takes to simulate.
+//
+//   A worker only ever holds one lock at a time.
+//
+//
+// RETURN VALUE
+//   Returns 1 with the batch in [*lo, *hi), or 0 if no tables are left.
+*/
+static int
+searchTake(SearchWorkerT *this, int64_t *lo, int64_t *hi)
+{
+  SearchT *search = this->search;
+
+  for(;;) {
+    SearchWorkerT *victim = NULL;
+    int64_t        most   = 0;
+    int            wi;
+
+    pthread_mutex_lock(&this->lock);
+    if(this->next < this->end) {
+      *lo = this->next;
+      *hi = MIN(this->next + SEARCH_BATCH, this->end);
+      SEARCH_STORE(&this->low, *lo);
+      SEARCH_STORE(&this->next, *hi);
+      pthread_mutex_unlock(&this->lock);
+      return 1;
+    }
+    pthread_mutex_unlock(&this->lock);
+
+    /* Out of tables: find the largest range left */
+    for(wi = 0; wi < search->jobs; wi++) {
+      SearchWorkerT *worker = &search->worker[wi];
+      const int64_t  left   =   SEARCH_LOAD(&worker->end)
+                              - SEARCH_LOAD(&worker->next);
+
+      if(left > most) {
+        most   = left;
+        victim = worker;
+      }
+    }
+    if(NULL == victim) {
+      SEARCH_STORE(&this->low, INT64_MAX);
+      return 0;
+    }
+
+    /* Steal the back half of it */
+    pthread_mutex_lock(&victim->lock);
+    if(victim->next < victim->end) {
+      const int64_t mid = victim->next + (victim->end - victim->next) / 2;
+      const int64_t end = victim->end;
+
+      /* Lower this worker's mark before the tables leave the victim,
+      // so that searchRestart() never passes over them
+      */
+      SEARCH_STORE(&this->low, mid);
+      SEARCH_STORE(&victim->end, mid);
+      pthread_mutex_unlock(&victim->lock);
+
+      pthread_mutex_lock(&this->lock);
+      SEARCH_STORE(&this->next, mid);
+      SEARCH_STORE(&this->end, end);
+      pthread_mutex_unlock(&this->lock);
+    } else {
+      pthread_mutex_unlock(&victim->lock);
+    }
+  }
+}
+
+
+
+
+/* NAME
+//   searchWorker: thread that searches tables until none are left
+//
+//
+// DESCRIPTION
+//   Each table is weeded and simulated as by tmBusyBeaverSearch(), on
+//   the worker's own fork of the machine.
+*/
+static void *
+searchWorker(void *arg)
+{
+  SearchWorkerT  *this   = arg;
+  SearchT        *search = this->search;
+  TuringMachineT *tm     = this->tm;
+  int64_t         lo, hi;
+
+  while(searchTake(this, &lo, &hi)) {
+    int64_t index;
+    int64_t tables;
+
+    tmTableUnrank(tm, search->base + lo);
+    for(index = lo; index < hi; index++) {
+      const int weed = tmTableWeed(tm);
+
+      if(weed > 5) {
+        printf("%i", weed);
+      } else if(weed) {
+        /* Weeded out quietly, as tmBusyBeaverSearch() does */
+      } else if(! tmTableCanonical(tm)) {
+        SEARCH_ADD(&this->symmetric, 1);
+      } else {
+        SEARCH_ADD(&this->simulated, 1);
+        searchResult(this, index,
+                     tmSimulate(tm, search->max_iters, search->tape_len_max));
+
+        /* Reset the Turing machine */
+        tm->state = 0;
+        if(tmTapeBlank(tm) < 0) {
+          /* Leave 'low' where it is, so a restart searches this batch */
+          this->error = 1;
+          return NULL;
+        }
+      }
+      tmTableNext(tm);
+    }
+
+    tables = SEARCH_ADD(&search->tables, hi - lo);
+    if((tables / SEARCH_PERIOD) != ((tables - (hi - lo)) / SEARCH_PERIOD)) {
+      searchRestart(search);
+    }
+  }
+  return NULL;
+}
+
+
+
+
+/* NAME
+//   tmBusyBeaverSearchJobs: search for a busy beaver on several threads
+//
+//
+// ARGUMENTS
+//   this (in/out): Turing machine, with the table to start from
+//
+//   max_iters (in): maximum number of iterations for each machine
+//
+//   tape_len_max (in): maximum tape length for each machine
+//
+//   jobs (in): number of threads to search on
+//
+//   end (in): lexical index of the table to stop before, or
+//   TABLE_INDEX_MAX to search to the last table
+//
+//
+// DESCRIPTION
+//   Searches the same tables as tmBusyBeaverSearch(), skipping the same
+//   symmetric ones (see tmTableCanonical), from the table of 'this' up
+//   to 'end', and reports them the same way.  The range of lexical
+//   indices is split evenly between 'jobs' workers, each with its own
+//   fork of the machine (see tmFork) and cycle detector, and workers
+//   that finish their range steal from the others (see searchTake).
+//   Machines are reported as they are found, so their order depends on
+//   how the threads run.  A worker whose thread cannot be started runs
+//   on the calling thread.
+//
+//   The table of 'this' is set from time to time to one the search can
+//   be restarted from, and written to "periodic.tm".
+//
+//   Workers count tables from the first one in an int64_t, so one
+//   search covers at most INT64_MAX tables.  A larger space is searched
+//   in shards, each given its own start table and 'end'.
+//
+//
+// RETURN VALUE
+//   Returns -1 if the range is too large, or memory could not be had,
+//   in which case the search may have searched some tables.  Returns 0
+//   otherwise.
+//
+//
+// SEE ALSO
+//   tmBusyBeaverSearch(), tmTableRank(), tmTableNext(), tmTableWeed()
+*/
+int64_t
+tmBusyBeaverSearchJobs(TuringMachineT *this, int64_t max_iters,
+                       int64_t tape_len_max, int jobs, TableIndex end)
+{
+  SearchT    search;
+  TableIndex start;
+  TableIndex tables;
+  int64_t    span;
+  int        status  = 0;
+  int        wi;
+
+  if(tmTableRank(this, &start) < 0) {
+    fprintf(stderr, "tmBusyBeaverSearchJobs: too many tables to number\n");
+    return -1;
+  }
+  if((tmTableSpace(this, &tables) == 0) && (end > tables)) {
+    end = tables;
+  }
+  if(end <= start) {
+    return 0;
+  }
+  if(end - start > INT64_MAX) {
+    fprintf(stderr, "tmBusyBeaverSearchJobs: too many tables for one"
+            " search; give an end index\n");
+    return -1;
+  }
+  span = end - start;
+
+  jobs = MIN(MAX(jobs, 1), SEARCH_THREADS_MAX);
+  memset(&search, 0, sizeof(search));
+  search.tm           = this;
+  search.base         = start;
+  search.max_iters    = max_iters;
+  search.tape_len_max = tape_len_max;
+  search.jobs         = jobs;
+  pthread_mutex_init(&search.lock, NULL);
+
+  if((search.worker = calloc(jobs, sizeof(SearchWorkerT)))==NULL) {
+    fprintf(stderr, "tmBusyBeaverSearchJobs: out of memory\n");
+    pthread_mutex_destroy(&search.lock);
+    return -1;
+  }
+
+  /* Split the tables evenly between the workers */
+  for(wi = 0; wi < jobs; wi++) {
+    SearchWorkerT *worker = &search.worker[wi];
+
+    worker->search = &search;
+    worker->next   = (span / jobs) * wi + MIN(wi, span % jobs);
+    worker->end    = (span / jobs) * (wi + 1) + MIN(wi + 1, span % jobs);
+    worker->low    = worker->next;
+    pthread_mutex_init(&worker->lock, NULL);
+
+    if((worker->tm = tmFork(this))==NULL) {
+      status = -1;
+    } else if(this->cycle != NULL) {
+      if((worker->tm->cycle = cycleNew())==NULL) status = -1;
+    }
+  }
+
+  if(0 == status) {
+    for(wi = 0; wi < jobs; wi++) {
+      SearchWorkerT *worker = &search.worker[wi];
+
+      worker->started = !pthread_create(&worker->thread, NULL, searchWorker,
+                                        worker);
+    }
+    for(wi = 0; wi < jobs; wi++) {
+      if(! search.worker[wi].started) searchWorker(&search.worker[wi]);
+    }
+    for(wi = 0; wi < jobs; wi++) {
+      if(search.worker[wi].started) pthread_join(search.worker[wi].thread, NULL);
+    }
+    for(wi = 0; wi < jobs; wi++) {
+      if(search.worker[wi].error) status = -1;
+    }
+  }
+
+  if(0 == status) {
+    int64_t simulated = 0;
+    int64_t symmetric = 0;
+
+    for(wi = 0; wi < jobs; wi++) {
+      simulated += search.worker[wi].simulated;
+      symmetric += search.worker[wi].symmetric;
+    }
+    printf("\n%lli tables simulated, %lli skipped as symmetric\n",
+           (long long) simulated, (long long) symmetric);
+  }
+
+  for(wi = 0; wi < jobs; wi++) {
+    SearchWorkerT *worker = &search.worker[wi];
+
+    if(worker->tm != NULL) {
+      cycleDestroy(worker->tm->cycle);
+      tmDestroy(worker->tm);
+    }
+    pthread_mutex_destroy(&worker->lock);
+  }
+  free(search.worker);
+  pthread_mutex_destroy(&search.lock);
+  fflush(stdout);
+
+  return status;
+}
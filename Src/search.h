@@ -0,0 +1,87 @@
+/* search.h: busy beaver search on many threads
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _SEARCH_H__INCLUDED_
+#define _SEARCH_H__INCLUDED_
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "tm.h"
+
+
+
+
+/* SEARCH_THREADS_MAX: most threads a search can run on */
+#define SEARCH_THREADS_MAX 1024
+
+/* SEARCH_BATCH: number of tables a thread takes from its range at a
+// time.  A thread is only ever stuck on the rest of one batch while it
+// simulates a long-running machine; everything after it can be stolen.
+*/
+#define SEARCH_BATCH 64
+
+
+
+
+/* SearchWorkerT: one thread of a search, and the range of tables it owns
+//
+// The worker searches the tables numbered [next, end), counted from the
+// first table of the search (see SearchT base), a batch at a time from
+// the front.  Another worker that has run out of tables steals the back
+// half of the range.  'lock' guards next and end.
+*/
+typedef struct SearchWorkerS {
+  struct SearchS  *search;   /* the search this worker belongs to */
+  TuringMachineT  *tm;       /* machine the worker simulates */
+  pthread_t        thread;
+  pthread_mutex_t  lock;
+
+  int64_t          next;     /* first table of the range not yet taken */
+  int64_t          end;      /* end of the range */
+  int64_t          low;      /* lowest table this worker has not finished,
+                             // or INT64_MAX when it is out of work
+                             */
+  int64_t          simulated; /* number of tables simulated */
+  int64_t          symmetric; /* number of tables skipped as symmetric */
+  int              started;  /* flag: the worker has a thread of its own */
+  int              error;    /* flag: the worker ran out of memory */
+} SearchWorkerT;
+
+
+
+
+/* SearchT: a busy beaver search shared by several threads
+//
+// The most 1's found so far, ones_max, changes with atomic
+// compare-and-swap, so finding a machine that is no better costs no
+// lock.  'lock' only guards the table of tm, which is set to the table
+// the search can restart from.  Output holds the lock on stdout (see
+// flockfile) to keep the report of one machine together.
+*/
+typedef struct SearchS {
+  TuringMachineT  *tm;        /* machine given to tmBusyBeaverSearchJobs,
+                              // set to the table to restart from
+                              */
+  TableIndex       base;      /* lexical index of table number 0 */
+  int64_t          max_iters;
+  int64_t          tape_len_max;
+  int64_t          ones_max;  /* most 1's left by a machine so far */
+  int64_t          tables;    /* tables looked at by all workers */
+  pthread_mutex_t  lock;      /* guards the table of tm */
+  int              jobs;      /* number of workers */
+  SearchWorkerT   *worker;    /* worker[jobs] */
+} SearchT;
+
+
+
+
+int64_t  tmBusyBeaverSearchJobs(TuringMachineT *this, int64_t max_iters,
+                                int64_t tape_len_max, int jobs,
+                                TableIndex end);
+
+
+
+#endif
@@ -0,0 +1,493 @@
+/* snap.c: binary snapshots of a running Turing Machine simulation
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+
+
+
+
+#include "tm.h"
+#include "snap.h"
+
+
+
+
+/* SNAP_BUFFER: number of frames, or words of frames, copied at a time
+// to and from a paged tape
+*/
+#define SNAP_BUFFER 4096
+
+/* SNAP_FNV_BASIS, SNAP_FNV_PRIME: 64-bit FNV-1a hash parameters */
+#define SNAP_FNV_BASIS UINT64_C(0xcbf29ce484222325)
+#define SNAP_FNV_PRIME UINT64_C(0x100000001b3)
+
+
+
+
+/* NAME
+//   snapHashMix: mix the 8 bytes of a value into an FNV-1a hash
+*/
+static uint64_t
+snapHashMix(uint64_t hash, int64_t value)
+{
+  int bi;
+
+  for(bi = 0; bi < 8; bi++) {
+    hash ^= (uint64_t)(value >> (8 * bi)) & 0xff;
+    hash *= SNAP_FNV_PRIME;
+  }
+  return hash;
+}
+
+
+
+
+/* NAME
+//   snapTableHash: hash of the state transition table of a machine
+//
+//
+// DESCRIPTION
+//   A snapshot records the hash of the table of the machine it was
+//   taken from, so that it is not carried on with a different machine.
+//   Every field of every entry goes into the hash, along with the shape
+//   of the table.
+*/
+uint64_t
+snapTableHash(const TuringMachineT *this)
+{
+  uint64_t hash = SNAP_FNV_BASIS;
+  State    si;
+  int      ci;
+
+  hash = snapHashMix(hash, this->charset_max);
+  hash = snapHashMix(hash, this->num_states);
+  for(si = 0; si < this->num_states; si++) {
+    for(ci = 0; ci <= this->charset_max; ci++) {
+      const Entry *entry = &this->table[si][ci];
+
+      hash = snapHashMix(hash, entry->write);
+      hash = snapHashMix(hash, entry->move);
+      hash = snapHashMix(hash, entry->next);
+    }
+  }
+  return hash;
+}
+
+
+
+
+/* NAME
+//   snapFramesWrite: write the frames of the tape accessed so far
+//
+//
+// DESCRIPTION
+//   A tape in one block of memory is written straight from it, apart
+//   from a bit-packed tape, whose words are shifted so that left_end is
+//   bit 0.  A paged tape is copied out a buffer at a time.
+//
+//
+// RETURN VALUE
+//   Returns -1 if the frames could not all be written, 0 otherwise.
+*/
+static int
+snapFramesWrite(const TuringMachineT *this, FILE *stream)
+{
+  const int64_t ti0 = this->left_end + this->tape_origin;
+  int64_t       pos;
+
+  if(1 == this->tape_width) {
+    const int64_t words = (this->tape_len + 63) / 64;
+    const int     shift = ti0 & 63;
+    uint64_t      buffer[SNAP_BUFFER];
+    int64_t       wi;
+    int           n     = 0;
+
+    for(wi = 0; wi < words; wi++) {
+      uint64_t word = 0;
+
+      if(this->tape_paged) {
+        int bit;
+
+        for(bit = 0; bit < 64; bit++) {
+          if(tmTapeFrameAt(this, this->left_end + 64 * wi + bit)) {
+            word |= (uint64_t)1 << bit;
+          }
+        }
+      } else {
+        /* tmTapeReserve() keeps a whole word beyond right_end */
+        const uint64_t *src = &this->tape_words[(ti0 >> 6) + wi];
+
+        word = src[0] >> shift;
+        if(shift) word |= src[1] << (64 - shift);
+        if((wi == words - 1) && (this->tape_len & 63)) {
+          word &= ((uint64_t)1 << (this->tape_len & 63)) - 1;
+        }
+      }
+
+      buffer[n++] = word;
+      if((SNAP_BUFFER == n) || (wi == words - 1)) {
+        if(fwrite(buffer, sizeof(uint64_t), n, stream) != n) return -1;
+        n = 0;
+      }
+    }
+    return 0;
+  }
+
+  if(! this->tape_paged) {
+    if(8 == this->tape_width) {
+      if(fwrite(&this->tape[ti0], 1, this->tape_len, stream)
+         != this->tape_len)
+      {
+        return -1;
+      }
+    } else {
+      if(fwrite(&this->tape_wide[ti0], sizeof(Char), this->tape_len, stream)
+         != this->tape_len)
+      {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  for(pos = this->left_end; pos <= this->right_end; pos += SNAP_BUFFER) {
+    const int64_t n = MIN(SNAP_BUFFER, this->right_end - pos + 1);
+    Char          buffer[SNAP_BUFFER];
+    int8_t        bytes[SNAP_BUFFER];
+    int64_t       fi;
+
+    for(fi = 0; fi < n; fi++) {
+      buffer[fi] = tmTapeFrameAt(this, pos + fi);
+      bytes[fi]  = buffer[fi];  /* type conversion */
+    }
+    if(8 == this->tape_width) {
+      if(fwrite(bytes, 1, n, stream) != n) return -1;
+    } else {
+      if(fwrite(buffer, sizeof(Char), n, stream) != n) return -1;
+    }
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   snapWrite: write a snapshot of a running machine to a file
+//
+//
+// ARGUMENTS
+//   this (in): Turing Machine
+//   filename (in): name of the snapshot file
+//   iters (in): number of shifts the machine has executed
+//   seconds (in): processor time the simulation has taken
+//
+//
+// DESCRIPTION
+//   The snapshot holds everything needed to carry on with the machine
+//   later: the state, the head, and the tape accessed so far, packed
+//   as the tape is in memory, along with a hash of the table and how
+//   far the simulation got.  See SnapHeaderT.
+//
+//   The snapshot is written to filename with ".new" added, flushed to
+//   disk, and only then renamed to filename, so that a run which dies
+//   while writing a snapshot leaves the one before it in place.
+//
+//   A machine with more than one tape cannot be snapshot.
+//
+//
+// RETURN VALUE
+//   Returns 0 if the snapshot was written, -1 otherwise.
+//
+//
+// SEE ALSO
+//   snapRead(), tmTapeWrite(), mapSync()
+*/
+int
+snapWrite(const TuringMachineT *this, const char *filename, int64_t iters,
+          double seconds)
+{
+  SnapHeaderT  header;
+  FILE        *stream;
+  char        *temp;
+
+  if(this->multi != NULL) {
+    fprintf(stderr, "snapWrite: a machine with more than one tape cannot"
+            " be snapshot\n");
+    return -1;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAP_MAGIC, sizeof(header.magic));
+  header.table_hash  = snapTableHash(this);
+  header.charset_max = this->charset_max;
+  header.num_states  = this->num_states;
+  header.tape_width  = this->tape_width;
+  header.state       = this->state;
+  header.here        = this->here;
+  header.tape_len    = this->tape_len;
+  header.left_end    = this->left_end;
+  header.right_end   = this->right_end;
+  header.iters       = iters;
+  header.seconds     = seconds;
+
+  if((temp = malloc(strlen(filename) + 5)) == NULL) {
+    fprintf(stderr, "snapWrite: out of memory\n");
+    return -1;
+  }
+  sprintf(temp, "%s.new", filename);
+
+  if((stream = fopen(temp, "wb")) == NULL) {
+    fprintf(stderr, "snapWrite: %s: %s\n", temp, strerror(errno));
+    free(temp);
+    return -1;
+  }
+
+  if(   (fwrite(&header, sizeof(header), 1, stream) != 1)
+     || (snapFramesWrite(this, stream) < 0)
+     || (fflush(stream) != 0)
+     || (fsync(fileno(stream)) < 0))
+  {
+    fprintf(stderr, "snapWrite: %s: %s\n", temp, strerror(errno));
+    fclose(stream);
+    remove(temp);
+    free(temp);
+    return -1;
+  }
+
+  if((fclose(stream) != 0) || (rename(temp, filename) < 0)) {
+    fprintf(stderr, "snapWrite: %s: %s\n", filename, strerror(errno));
+    remove(temp);
+    free(temp);
+    return -1;
+  }
+
+  free(temp);
+  return 0;
+}
+
+
+
+
+/* NAME
+//   snapFramesRead: read the frames of the tape from a snapshot
+//
+//
+// DESCRIPTION
+//   The tape must be blank, with memory reserved from left_end to
+//   right_end.  Frames are read straight into a tape in one block of
+//   memory, apart from a bit-packed tape, whose words are shifted into
+//   place, and are set one at a time on a paged tape.  The symbol counts
+//   are brought up to date.
+//
+//
+// RETURN VALUE
+//   Returns -1 if the file is too short, holds a symbol the machine
+//   does not have, or a page of the tape could not be allocated.
+//   Returns 0 otherwise.
+*/
+static int
+snapFramesRead(TuringMachineT *this, FILE *stream, const char *filename)
+{
+  const int64_t ti0 = this->left_end + this->tape_origin;
+  int64_t       pos;
+
+  if(1 == this->tape_width) {
+    const int64_t words = (this->tape_len + 63) / 64;
+    const int     shift = ti0 & 63;
+    uint64_t      buffer[SNAP_BUFFER];
+    int64_t       wi;
+
+    for(wi = 0; wi < words; wi += SNAP_BUFFER) {
+      const int64_t n = MIN(SNAP_BUFFER, words - wi);
+      int64_t       bi;
+
+      if(fread(buffer, sizeof(uint64_t), n, stream) != n) {
+        fprintf(stderr, "snapRead: %s: file is too short\n", filename);
+        return -1;
+      }
+      if((wi + n == words) && (this->tape_len & 63)) {
+        buffer[n - 1] &= ((uint64_t)1 << (this->tape_len & 63)) - 1;
+      }
+
+      for(bi = 0; bi < n; bi++) {
+        const uint64_t word = buffer[bi];
+
+        if(this->tape_paged) {
+          int bit;
+
+          for(bit = 0; bit < 64; bit++) {
+            if((word >> bit) & 1) {
+              this->here = this->left_end + 64 * (wi + bi) + bit;
+              if(tmTapeFrameSet(this, 1) < 0) return -1;
+            }
+          }
+        } else {
+          uint64_t *dst = &this->tape_words[(ti0 >> 6) + wi + bi];
+
+          dst[0] |= word << shift;
+          if(shift) dst[1] |= word >> (64 - shift);
+          this->symbol_count[1] += POPCOUNT64(word);
+        }
+      }
+    }
+    return 0;
+  }
+
+  for(pos = this->left_end; pos <= this->right_end; pos += SNAP_BUFFER) {
+    const int64_t n = MIN(SNAP_BUFFER, this->right_end - pos + 1);
+    const int64_t ti = pos + this->tape_origin;
+    Char          buffer[SNAP_BUFFER];
+    int8_t        bytes[SNAP_BUFFER];
+    int64_t       fi;
+    int64_t       got;
+
+    if(8 == this->tape_width) {
+      got = fread(this->tape_paged ? bytes : &this->tape[ti], 1, n, stream);
+    } else {
+      got = fread(this->tape_paged ? buffer : &this->tape_wide[ti],
+                  sizeof(Char), n, stream);
+    }
+    if(got != n) {
+      fprintf(stderr, "snapRead: %s: file is too short\n", filename);
+      return -1;
+    }
+
+    for(fi = 0; fi < n; fi++) {
+      const Char c =   this->tape_paged
+                     ? ((8 == this->tape_width) ? bytes[fi] : buffer[fi])
+                     : tmTapeFrameAt(this, pos + fi);
+
+      if((c < 0) || (c > this->charset_max)) {
+        fprintf(stderr, "snapRead: %s: symbol %i at %lli is out of range\n",
+                filename, c, (long long) (pos + fi));
+        return -1;
+      }
+      if(this->tape_paged) {
+        if(c) {
+          this->here = pos + fi;
+          if(tmTapeFrameSet(this, c) < 0) return -1;
+        }
+      } else {
+        this->symbol_count[c] ++;
+      }
+    }
+  }
+  this->symbol_count[0] = 0;
+  return 0;
+}
+
+
+
+
+/* NAME
+//   snapRead: carry on with a machine from a snapshot file
+//
+//
+// ARGUMENTS
+//   this (in/out): Turing Machine
+//   filename (in): name of the snapshot file
+//   iters (out): number of shifts the machine had executed
+//   seconds (out): processor time the simulation had taken
+//
+//
+// DESCRIPTION
+//   The state, head and tape of the machine are taken from the
+//   snapshot, in place of reading or blanking the tape.  snapRead()
+//   must be called after tmTableRead(), with the table the snapshot was
+//   taken from, and may be called on a paged tape (see tape_paged)
+//   whatever the tape of the machine that wrote it was.  Any tape the
+//   machine had is freed.
+//
+//
+// RETURN VALUE
+//   Returns 0 if the machine was taken from the snapshot.
+//   Returns -1 if the file could not be read, is not a snapshot of this
+//   machine, or memory for the tape could not be allocated, in which
+//   case the machine must not be run.
+//
+//
+// SEE ALSO
+//   snapWrite(), tmTapeRead(), mapOpen()
+*/
+int
+snapRead(TuringMachineT *this, const char *filename, int64_t *iters,
+         double *seconds)
+{
+  SnapHeaderT  header;
+  FILE        *stream;
+
+  if(this->multi != NULL) {
+    fprintf(stderr, "snapRead: a machine with more than one tape cannot"
+            " be snapshot\n");
+    return -1;
+  }
+
+  if((stream = fopen(filename, "rb")) == NULL) {
+    fprintf(stderr, "snapRead: %s: %s\n", filename, strerror(errno));
+    return -1;
+  }
+
+  if(fread(&header, sizeof(header), 1, stream) != 1) {
+    fprintf(stderr, "snapRead: %s: file is too short\n", filename);
+    fclose(stream);
+    return -1;
+  }
+
+  if(memcmp(header.magic, SNAP_MAGIC, sizeof(header.magic))) {
+    fprintf(stderr, "snapRead: %s: not a snapshot\n", filename);
+    fclose(stream);
+    return -1;
+  }
+  if(   (header.table_hash  != snapTableHash(this))
+     || (header.charset_max != this->charset_max)
+     || (header.num_states  != this->num_states)
+     || (header.tape_width  != this->tape_width))
+  {
+    fprintf(stderr, "snapRead: %s: snapshot of a different machine\n",
+            filename);
+    fclose(stream);
+    return -1;
+  }
+  if(   (header.state < 0) || (header.state >= this->num_states)
+     || (header.tape_len < 1) || (header.iters < 0)
+     || (header.tape_len != header.right_end - header.left_end + 1)
+     || (header.here < header.left_end) || (header.here > header.right_end))
+  {
+    fprintf(stderr, "snapRead: %s: snapshot is corrupt\n", filename);
+    fclose(stream);
+    return -1;
+  }
+
+  /* Reserve the whole tape, then fill it in */
+  tmTapeFree(this);
+  this->here = header.left_end;
+  if(tmTapeAlloc(this) < 0) {
+    fclose(stream);
+    return -1;
+  }
+  this->here = header.right_end;
+  if(tmTapeAlloc(this) < 0) {
+    fclose(stream);
+    return -1;
+  }
+
+  if(snapFramesRead(this, stream, filename) < 0) {
+    fclose(stream);
+    return -1;
+  }
+  fclose(stream);
+
+  this->here  = header.here;
+  this->state = header.state;
+  *iters      = header.iters;
+  *seconds    = header.seconds;
+  return 0;
+}
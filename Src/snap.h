@@ -0,0 +1,61 @@
+/* snap.h: binary snapshots of a running Turing Machine simulation
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _SNAP_H__INCLUDED_
+#define _SNAP_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* SNAP_MAGIC: first bytes of a snapshot file, with its format version */
+#define SNAP_MAGIC "tmsnap1"
+
+
+
+
+/* SnapHeaderT: what a snapshot file says about the machine
+//
+// The header is followed by the frames from left_end to right_end, in
+// the width the machine's tape uses:
+//
+//    1: 64 frames to a uint64_t, frame left_end + i in bit i % 64 of
+//       word i / 64, with the bits beyond right_end clear
+//    8: one byte per frame
+//   16: one Char per frame
+//
+// Numbers are stored as the machine that wrote them stores them, so a
+// snapshot is only read back on the same kind of machine.
+*/
+typedef struct {
+  char     magic[8];    /* SNAP_MAGIC */
+  uint64_t table_hash;  /* snapTableHash() of the machine */
+  int32_t  charset_max;
+  int32_t  num_states;
+  int32_t  tape_width;  /* bits per frame */
+  int32_t  state;       /* current state */
+  int64_t  here;        /* head position */
+  int64_t  tape_len;    /* the machine's tape extent */
+  int64_t  left_end;
+  int64_t  right_end;
+  int64_t  iters;       /* shifts executed so far */
+  double   seconds;     /* processor time taken so far */
+} SnapHeaderT;
+
+
+
+
+uint64_t snapTableHash(const TuringMachineT *this);
+int      snapWrite(const TuringMachineT *this, const char *filename,
+                   int64_t iters, double seconds);
+int      snapRead(TuringMachineT *this, const char *filename,
+                  int64_t *iters, double *seconds);
+
+
+
+#endif
@@ -9,27 +9,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <signal.h>
-#include <alloca.h>
-
-#ifndef sun
-#include <getopt.h>
-#endif
 
 #include <curses.h>
 #include <limits.h>
-#include <signal.h>
-
-#include "fifo.h"
+#include <stdint.h>
 
 #include "tm.h"
+#include "cycle.h"
+#include "page.h"
+#include "map.h"
+#include "multi.h"
 
 
 
 
-/* MAX: return larger of the two input numbers */
-#define MAX(a,b) (((a)>(b))?(a):(b))
-
 #define ABS(a)   (((a)<0)?(-(a)):(a))
 
 
@@ -61,9 +54,29 @@ tmNew(void)
   tm->state       = 0;
   tm->table       = NULL;
   tm->num_states  = 0;
+  tm->program     = NULL;
   tm->here        = 0;
   tm->tape_len    = 0;
+  tm->left_end    = 0;
+  tm->right_end   = 0;
+  tm->tape_origin = 0;
+  tm->tape_alloc  = 0;
+  tm->program_wide = NULL;
+  tm->tape_width  = 8;
   tm->tape        = NULL;
+  tm->tape_wide   = NULL;
+  tm->tape_words  = NULL;
+  tm->tape_paged  = 0;
+  tm->tape_pages  = NULL;
+  tm->tape_pages_resident = 0;
+  tm->tape_map    = NULL;
+  tm->symbol_count = NULL;
+  tm->break_state = -1;
+  tm->blank_test  = 1;
+  tm->cycle       = NULL;
+  tm->multi       = NULL;
+  tm->reach_scratch = NULL;
+  tm->reach_words   = 0;
 
   return tm;
 }
@@ -71,18 +84,78 @@ tmNew(void)
 
 
 
+/* NAME
+//   tmDestroy: free a Turing Machine and everything it owns
+//
+//
+// DESCRIPTION
+//   Frees the table, the compiled program, the tape and scratch space.
+//   The cycle detector is left to whoever set it.  tmDestroy(NULL) does
+//   nothing.
+*/
+void
+tmDestroy(TuringMachineT *this)
+{
+  if(NULL == this) return;
+
+  tmTapeFree(this);
+  if(this->table != NULL) {
+    free(this->table[0]);
+    free(this->table);
+  }
+  free(this->program);
+  free(this->program_wide);
+  free(this->symbol_count);
+  free(this->reach_scratch);
+  multiDestroy(this->multi);
+  free(this);
+}
+
+
+
+
+/* NAME
+//   tmTapeCountClear: forget the symbol counts, for a blank tape
+*/
+static void
+tmTapeCountClear(TuringMachineT *this)
+{
+  if(this->symbol_count != NULL) {
+    memset(this->symbol_count, 0,
+           sizeof(int64_t) * (this->charset_max + 1));
+  }
+}
+
+
+
+
 /* NAME
 //   tmTapeFree: free memory of a Turing Machine tape
 */
 void
 tmTapeFree(TuringMachineT *this)
 {
+  mapClose(this);
   if(this->tape != NULL) {
     free(this->tape);
     this->tape = NULL;
   }
-  this->tape_len = 0;
-  this->here     = 0;
+  if(this->tape_wide != NULL) {
+    free(this->tape_wide);
+    this->tape_wide = NULL;
+  }
+  if(this->tape_words != NULL) {
+    free(this->tape_words);
+    this->tape_words = NULL;
+  }
+  pageFree(this);
+  this->tape_len    = 0;
+  this->left_end    = 0;
+  this->right_end   = 0;
+  this->tape_origin = 0;
+  this->tape_alloc  = 0;
+  this->here        = 0;
+  tmTapeCountClear(this);
 }
 
 
@@ -96,11 +169,17 @@ tmTapeFree(TuringMachineT *this)
 //   charset_max <integer>
 //     indicates the charset_max for this TM.
 //     'charset_max' must occur before any 'state' lines.
+//   tapes <integer>
+//     indicates the number of tapes, 1 if not given.
+//     'tapes' must occur before any 'state' lines.
 //   state
 //     indicates that table entries for a new state are to be read.
 //     'state' must occur before any 'input' lines.
 //   input <integer> write <integer> move <L|R|S> next <integer>
 //     indicates table entry for the current (state,input) tuple.
+//     A machine with more than one tape has an integer for each tape
+//     after 'input' and 'write', and a letter for each tape after
+//     'move'; see multiTableLine().
 //   #
 //     comment line
 //   blank line
@@ -117,6 +196,7 @@ int64_t
 tmTableRead(TuringMachineT *this, char *filename)
 {
   int32_t charset_max   = -1;
+  int32_t tapes         = 1;  /* number of tapes */
   int32_t state         = -1; /* current state being read */
   int32_t si;                 /* state index for loop */
   int32_t input;              /* input character for this table entry */
@@ -141,7 +221,12 @@ tmTableRead(TuringMachineT *this, char *filename)
     line_num++;
 
     if(sscanf(line, "charset_max %i", &charset_max)==1) {
-      if(this->charset_max >= 0) {
+      if((charset_max < 0) || (charset_max > CHARSET_MAX)) {
+        fprintf(stderr, "tmTableRead: %i: bad value for charset_max: %i\n",
+                line_num, charset_max);
+        fclose(stream);
+        return -2;
+      } else if(this->charset_max >= 0) {
         fprintf(stderr,
                 "tmTableRead: %i: encountered more than one 'charset_max'\n",
                 line_num);
@@ -154,6 +239,20 @@ tmTableRead(TuringMachineT *this, char *filename)
         this->charset_max = charset_max;  /* type conversion */
       }
 
+    } else if(sscanf(line, "tapes %i", &tapes)==1) {
+      if((tapes < 1) || (tapes > MULTI_TAPES_MAX)) {
+        fprintf(stderr, "tmTableRead: %i: bad value for tapes: %i\n",
+                line_num, tapes);
+        fclose(stream);
+        return -2;
+      } else if(state >= 0) {
+        fprintf(stderr,
+                "tmTableRead: %i: must have 'tapes' before 'state'\n",
+                line_num);
+        fclose(stream);
+        return -3;
+      }
+
     } else if(!strncmp(line, "state", 5)) {
       if(charset_max < 0) {
         fprintf(stderr,
@@ -166,6 +265,21 @@ tmTableRead(TuringMachineT *this, char *filename)
       state ++;
       this->num_states = state + 1;
 
+      if(tapes > 1) {
+        /* Transitions of a multi-tape machine live in a MultiT */
+        if(NULL == this->multi) {
+          if((this->multi = multiNew(tapes, charset_max))==NULL) {
+            fclose(stream);
+            return -4;
+          }
+        }
+        if(multiTableGrow(this->multi, this->num_states) < 0) {
+          fclose(stream);
+          return -4;
+        }
+        continue;
+      }
+
       /* Allocate a new state line for the TM */
       if((table = realloc(table,
                           sizeof(Entry) * (charset_max + 1) * this->num_states)
@@ -188,6 +302,16 @@ tmTableRead(TuringMachineT *this, char *filename)
 
       this->table = tablePP;
 
+    } else if((this->multi != NULL) && !strncmp(line, "input", 5)) {
+      int status = multiTableLine(this->multi, state, charset_max, line,
+                                  line_num, &next);
+
+      if(status < 0) {
+        fclose(stream);
+        return status;
+      }
+      max_refd_state = MAX(max_refd_state, next);
+
     } else if(sscanf(line, "input %i write %i move %c next %i",
               &input, &write, &move, &next) == 4)
     {
@@ -261,6 +385,24 @@ tmTableRead(TuringMachineT *this, char *filename)
     return -12;
   }
 
+  /* Store the tape in the narrowest frames that hold every symbol */
+  if(1 == this->charset_max) {
+    this->tape_width = 1;
+  } else if(this->charset_max <= INT8_MAX) {
+    this->tape_width = 8;
+  } else {
+    this->tape_width = 16;
+  }
+
+  /* The tape has to be blank, or read, after the table */
+  free(this->symbol_count);
+  if((this->symbol_count = calloc(this->charset_max + 1, sizeof(int64_t)))
+     ==NULL)
+  {
+    fprintf(stderr, "tmTableRead: out of memory\n");
+    return -4;
+  }
+
   return state;
 }
 
@@ -268,217 +410,636 @@ tmTableRead(TuringMachineT *this, char *filename)
 
 
 /* NAME
-//   tmTapeIndex: translates the signed value of "here" into an index for tape[]
+//   tmTableCompile: build the compiled execution form of a table
 //
 //
 // DESCRIPTION
-//   if here >= 0, tapeIndex(here) = here * 2
-//   if here < 0 , tapeIndex(here) = - (here * 2 + 1)
+//   The state transition table is stored as an array of rows, with
+//   each Entry holding an enum and an int.  That is convenient for
+//   reading, printing and searching, but it costs a row pointer
+//   dereference and several loads per step.  tmTableCompile flattens
+//   the table into this->program, one contiguous array of Op words
+//   indexed as program[state * (charset_max+1) + input].  Each Op packs
+//   the character to write, the head delta, and the row offset of the
+//   next state, so that one load drives a whole step.
 //
-//   The tape index has the property that negative values of here map to
-//   odd values of the index, and non-negative values of here map
-//   to even values of the index, such that no elements of tape[] are
-//   wasted.
+//   tmTableCompile must be called again whenever the table changes.
+//
+//   A paged tape (see tape_paged) is run from the OpWide form of the
+//   table whatever its charset_max, so for a paged tape tmTableCompile
+//   builds program_wide as well.
 //
 //
 // RETURN VALUE
-//   Returns a positive integer which is the index into this->tape[]
-//   which corresponds to the (possibly negative) signed this->here
-//   tape head position.
+//   Returns a negative value if there is an error.
+//   Returns 0 if the program was built without error.
+//
+//
+// SEE ALSO
+//   tmSimulate(), Op
 */
-#ifdef FUNCTION
-int64_t
-tmTapeIndex(const TuringMachineT *this)
+int
+tmTableCompile(TuringMachineT *this)
 {
-  if(this->here >= 0) {
-    return this->here * 2;
-  } else {
-    return - (this->here * 2 + 1);
+  const int64_t line_length = this->charset_max + 1;
+  const int64_t num_ops     = line_length * this->num_states;
+  int64_t       si;
+  int64_t       ii;
+
+  if((this->table == NULL) || (num_ops <= 0)) {
+    fprintf(stderr, "tmTableCompile: no table\n");
+    return -1;
+  }
+
+  if(num_ops - line_length > OP_ROW_MAX) {
+    fprintf(stderr, "tmTableCompile: table too large to compile\n");
+    return -2;
+  }
+
+  if(this->charset_max > OP_CHARSET_MAX) {
+    fprintf(stderr, "tmTableCompile: charset_max %i too large to compile\n",
+            this->charset_max);
+    return -2;
+  }
+
+  if((this->program = realloc(this->program, sizeof(Op) * num_ops))==NULL)
+  {
+    fprintf(stderr, "tmTableCompile: out of memory\n");
+    return -3;
   }
-}
-#else
-#define tmTapeIndex(this) \
-  (((this)->here >= 0) ? (((this)->here)*2) : (-(((this)->here)*2+1)))
-#endif
 
+  for(si=0; si < this->num_states; si++) {
+    for(ii=0; ii < line_length; ii++) {
+      const Entry * const entry = &this->table[si][ii];
+      int32_t             delta;
+
+      if(MOVE_LEFT == entry->move) {
+        delta = -1;
+      } else if(MOVE_RIGHT == entry->move) {
+        delta = 1;
+      } else {
+        delta = 0;
+      }
 
+      this->program[si * line_length + ii]
+        = OP_PACK(entry->write, delta, entry->next * line_length);
+    }
+  }
 
+  if(this->tape_paged) {
+    return tmTableCompileWide(this);
+  }
 
-#define tmTapeFrame(this) ((this)->tape[tmTapeIndex(this)])
+  return 0;
+}
 
 
 
 
 /* NAME
-//   tmTapeHead: return Turing Machine tape head location given tape index
+//   tmTableCompileWide: build the compiled execution form of a table
+//   with 16-bit symbols
 //
 //
 // DESCRIPTION
-//   tmTapeHead is the inverse of tmTapeIndex.
+//   Like tmTableCompile(), but builds this->program_wide, whose OpWide
+//   words have room for 16-bit symbols and for the row offsets of
+//   tables far larger than an Op can address.
 //
-//   If index is even, here is non-negative.
-//   If index is odd, here is negative.
-//   index == 0 corresponds to a this->here == 0.
+//
+// RETURN VALUE
+//   Same as tmTableCompile().
 //
 //
 // SEE ALSO
-//   tmTapeIndex
+//   tmTableCompile(), tmSimulateWide(), OpWide
 */
-int64_t
-tmTapeHead(const TuringMachineT *this, int64_t index)
+int
+tmTableCompileWide(TuringMachineT *this)
 {
-  if(index % 2 == 0) {
-    return index / 2;
-  } else {
-    return - (index+1) / 2;
+  const int64_t line_length = this->charset_max + 1;
+  const int64_t num_ops     = line_length * this->num_states;
+  int64_t       si;
+  int64_t       ii;
+
+  if((this->table == NULL) || (num_ops <= 0)) {
+    fprintf(stderr, "tmTableCompileWide: no table\n");
+    return -1;
+  }
+
+  if((this->program_wide = realloc(this->program_wide,
+                                   sizeof(OpWide) * num_ops))==NULL)
+  {
+    fprintf(stderr, "tmTableCompileWide: out of memory\n");
+    return -3;
   }
+
+  for(si=0; si < this->num_states; si++) {
+    for(ii=0; ii < line_length; ii++) {
+      const Entry * const entry = &this->table[si][ii];
+      int32_t             delta;
+
+      if(MOVE_LEFT == entry->move) {
+        delta = -1;
+      } else if(MOVE_RIGHT == entry->move) {
+        delta = 1;
+      } else {
+        delta = 0;
+      }
+
+      this->program_wide[si * line_length + ii]
+        = OPW_PACK(entry->write, delta, entry->next * line_length);
+    }
+  }
+
+  return 0;
 }
 
 
 
 
 /* NAME
-//   tmTableIndex: return lexical index of the Turing machine table
+//   tmTapeIndex: translates the signed value of "here" into an index for tape[]
 //
 //
 // DESCRIPTION
-//   When systematically generating all possible Turing machine state
-//   transition tables, it is useful to order those tables.
-//   tmTableIndex takes in a table and generates a unique index for
-//   that table.  It is possible to go back and forth between a table
-//   and its index.
+//   tapeIndex(here) = here + tape_origin
+//
+//   The tape is stored centered on tape_origin, so that neighboring
+//   tape frames are neighboring elements of tape[], and the tape can
+//   grow independently to the left and to the right.
+//
+//
+// RETURN VALUE
+//   Returns a non-negative integer which is the index into this->tape[]
+//   which corresponds to the (possibly negative) signed this->here
+//   tape head position.
 */
+#ifdef FUNCTION
 int64_t
-tmTableIndex(const TuringMachineT *this)
+tmTapeIndex(const TuringMachineT *this)
 {
-  int       di;       /* "digit" index */
-  int       si;       /* state index */
-  int       ii;       /* input index */
-  int       dv;       /* "digit" value */
-  int64_t ti  = 0;  /* table index */
-  int64_t p21 = 1;  /* power of 21 */
+  return this->here + this->tape_origin;
+}
+#else
+#define tmTapeIndex(this) (((this)->here) + ((this)->tape_origin))
+#endif
+
+
+
+
+/* tmTapeBit: value of the bit-packed tape at tape index ti */
+#define tmTapeBit(this, ti) \
+  ((Char)(((this)->tape_words[(ti) >> 6] >> ((ti) & 63)) & 1))
+
+
+
+
+/* tmTapeAt: value of the tape at tape index ti, whatever its width */
+#define tmTapeAt(this, ti) \
+  (  (this)->tape_paged        ? PAGE_AT(this, ti) \
+   : (1 == (this)->tape_width) ? tmTapeBit(this, ti) \
+   : (8 == (this)->tape_width) ? (Char) (this)->tape[ti] \
+   :                             (this)->tape_wide[ti])
 
-  for(si=0; si < this->num_states; si++) {
-    for(ii=0; ii <= this->charset_max; ii++) {
-      /* Find which digit we're at */
-      di = si * this->num_states + ii;
-
-      /* Compute lexical value of this table entry */
-      if(this->table[si][ii].move != STOP) {
-        dv =   this->table[si][ii].write
-             + this->table[si][ii].next * (this->charset_max + 1)
-             + this->table[si][ii].move * (this->charset_max + 1)
-               * this->num_states;
-      } else {
-        dv = 20;
-      }
-      /* Accumulate the table index */
-      ti += p21 * dv;
 
-      /* Compute next power of 21 */
-      p21 *= 21;
-    }
-  }
-  return ti;
-}
+
+
+/* tmTapeFrame: value of the tape frame under the tape head */
+#define tmTapeFrame(this) tmTapeAt(this, tmTapeIndex(this))
 
 
 
 
 /* NAME
-//   tmTableWrite: write a Turing machine table in a machine readable form
+//   tmTapeFrameSet: set the value of the tape frame under the tape head
 //
 //
 // DESCRIPTION
-//   tmTableWrite writes a Turing machine table in a way such that it
-//   can be read in by tmTableRead.
+//   tmTapeFrameSet() should be used as the only way to write to a
+//   tape frame, since the tape is stored as 1, 8 or 16 bits per frame
+//   (see tape_width) or in pages (see tape_paged), and the symbol
+//   counts follow every write.
+//
+//
+// RETURN VALUE
+//   Returns -1 if a page of a paged tape could not be allocated, in
+//   which case the frame is not changed.
+//   Returns 0 otherwise.
+//
+//
+// SEE ALSO
+//   tmTapeFrame(), tmTapeIndex(), tmTapeSymbolCount()
 */
 int
-tmTableWrite(const TuringMachineT * const this, const char * const filename)
+tmTapeFrameSet(TuringMachineT *this, Char value)
 {
-  FILE *stream;
-  int si;
-  int ii;
-  static char *move_chars = "LRS";
-  const int64_t ti = tmTableIndex(this);  /* table index */
+  const int64_t ti  = tmTapeIndex(this);
+  const Char    old = tmTapeAt(this, ti);
 
-  /* Open the tape file for writing */
-  if((stream=fopen(filename, "w"))==NULL) {
-    fprintf(stderr, "tmTableWrite: error opening '%s'\n", filename);
-    return -1;
+  if(this->tape_paged) {
+    if(pageFrameSet(this, ti, value) < 0) return -1;
+  } else if(1 == this->tape_width) {
+    const uint64_t bit = (uint64_t)1 << (ti & 63);
+
+    if(value) {
+      this->tape_words[ti >> 6] |= bit;
+    } else {
+      this->tape_words[ti >> 6] &= ~bit;
+    }
+  } else if(8 == this->tape_width) {
+    this->tape[ti] = value;  /* type conversion */
+  } else {
+    this->tape_wide[ti] = value;
   }
 
-  fprintf(stream, "# %s: table %014lli written from %s version %s\n",
-          filename, ti, __FILE__, __DATE__);
+  if(old > 0)   this->symbol_count[old] --;
+  if(value > 0) this->symbol_count[value] ++;
+  return 0;
+}
 
-  fprintf(stream, "\ncharset_max %i\n", this->charset_max);
 
-  for(si=0; si < this->num_states; si++) {
-    fprintf(stream, "\nstate %i\n", si);
-    for(ii=0; ii <= this->charset_max; ii++) {
-      fprintf(stream, "input %i write %i move %c next %i\n", ii,
-             this->table[si][ii].write,
-             move_chars[this->table[si][ii].move],
-             this->table[si][ii].next);
-    }
+
+
+/* NAME
+//   tmTapeFrameAt: return the value of the tape frame at a head position
+//
+//
+// DESCRIPTION
+//   Frames outside of the tape accessed so far are blank.
+//
+//
+// SEE ALSO
+//   tmTapeFrame(), tmTapeFrameSet()
+*/
+Char
+tmTapeFrameAt(const TuringMachineT *this, int64_t here)
+{
+  const int64_t ti = here + this->tape_origin;
+
+  if((0 == this->tape_len) || (here < this->left_end)
+     || (here > this->right_end))
+  {
+    return 0;
   }
-  fclose(stream);
-  return 1;
+  return tmTapeAt(this, ti);
 }
 
 
 
 
-/* tmTablePrint: print Turing Machine state transition table */
-#define tmTablePrint(this) tmTableCurse(this, -1, -1)
+/* NAME
+//   tmTapeHead: return Turing Machine tape head location given tape index
+//
+//
+// DESCRIPTION
+//   tmTapeHead is the inverse of tmTapeIndex.
+//
+//
+// SEE ALSO
+//   tmTapeIndex
+*/
+int64_t
+tmTapeHead(const TuringMachineT *this, int64_t index)
+{
+  return index - this->tape_origin;
+}
 
 
 
 
 /* NAME
-//   tmTableCurse: use curses to print Turing Machine state transition table
+//   tmTableRadix: number of values a table entry takes in lexical order
 //
 //
-// ARGUMENTS
-//   wy (in): row to print table, where row 0 is the top
-//     if wy is negative then print without using curses
+// DESCRIPTION
+//   An entry that moves left or right takes any character to write and
+//   any next state.  An entry that stops takes a single value, as the
+//   character and state after it do not matter.  The entry value is
 //
-//   wx (in): column to print table, where colunm 0 is the left
+//     write + next * (charset_max+1) + move * (charset_max+1) * num_states
+//
+//   or tmTableRadix() - 1 for an entry that stops.
+*/
+static TableIndex
+tmTableRadix(const TuringMachineT *this)
+{
+  return 2 * (TableIndex) (this->charset_max + 1) * this->num_states + 1;
+}
+
+
+
+
+/* NAME
+//   tmTableRank: lexical index of a Turing machine table
 //
 //
 // DESCRIPTION
-//   The left-most column of the state transition table indicates the
-//   state.  Each row of the state transition table indicates the
-//   instructions to perform for that given state.  Each of the columns
-//   to the right of the leftmost column are for a given input from the
-//   current tape frame.  The entries in the state transition table
-//   have 3 symbols.  The left symbol indicates the value to be written
-//   onto the current tape frame, the middle symbol indicates the
-//   direction that the tape head will move, and the right symbol
-//   indicates the next state to enter.  The entry that corresponds to
-//   the current state and tape input value is highlighted.
+//   When systematically generating all possible Turing machine state
+//   transition tables, it is useful to order those tables.  The table
+//   is a number in base tmTableRadix(), with one digit per entry: entry
+//   (si, ii) is digit si * (charset_max+1) + ii, the least significant
+//   first.  tmTableNext() adds one to this number, and tmTableUnrank()
+//   goes back from the number to the table.
 //
-//   If the terminal text window is too small to fit the table, a
-//   message is printed which indicates the minimum number of lines the
-//   window must have in order to display the table.
+//
+// RETURN VALUE
+//   Returns -1 if the index does not fit in a TableIndex, 0 otherwise.
 //
 //
 // SEE ALSO
-//   tmTablePrint(), tmTapeFrame(), curses library
+//   tmTableUnrank(), tmTableSpace(), tmTableNext()
 */
-void
-tmTableCurse(const TuringMachineT *this, const int wy, const int wx)
+int
+tmTableRank(const TuringMachineT *this, TableIndex *index)
 {
-  static char *move_chars = "LRS";
+  const TableIndex radix       = tmTableRadix(this);
+  const int64_t    line_length = this->charset_max + 1;
+  int64_t          di;  /* "digit" index */
+
+  *index = 0;
+  for(di = this->num_states * line_length - 1; di >= 0; di--) {
+    const Entry *entry = &this->table[di / line_length][di % line_length];
+    TableIndex   dv;    /* "digit" value */
+
+    if(entry->move != STOP) {
+      dv =   entry->write
+           + entry->next * line_length
+           + entry->move * line_length * this->num_states;
+    } else {
+      dv = radix - 1;
+    }
+    if(*index > (TABLE_INDEX_MAX - dv) / radix) return -1;
+    *index = *index * radix + dv;
+  }
+  return 0;
+}
 
-  int64_t   si;
-  int64_t   ii;
-  int    py = wy;
-  int  (*print)(const char *fmt,...);
 
-  if(wy > 0) {
-    print = printw;
-  } else {
+
+
+/* NAME
+//   tmTableUnrank: set a Turing machine table from its lexical index
+//
+//
+// DESCRIPTION
+//   tmTableUnrank is the inverse of tmTableRank.  An entry that stops
+//   is given write 1 and next num_states-1, as tmTableNext() does.
+//
+//
+// RETURN VALUE
+//   Returns -1, leaving the table as it was, if the index is not less
+//   than tmTableSpace().  Returns 0 otherwise.
+*/
+int
+tmTableUnrank(TuringMachineT *this, TableIndex index)
+{
+  const TableIndex radix       = tmTableRadix(this);
+  const int64_t    line_length = this->charset_max + 1;
+  TableIndex       tables;
+  int64_t          di;
+
+  if((tmTableSpace(this, &tables) == 0) && (index >= tables)) {
+    return -1;
+  }
+
+  for(di = 0; di < this->num_states * line_length; di++) {
+    Entry           *entry = &this->table[di / line_length][di % line_length];
+    const TableIndex dv    = index % radix;
+
+    index /= radix;
+    if(radix - 1 == dv) {
+      entry->write = 1;
+      entry->next  = this->num_states - 1;
+      entry->move  = STOP;
+    } else {
+      entry->write = dv % line_length;
+      entry->next  = (dv / line_length) % this->num_states;
+      entry->move  = dv / (line_length * this->num_states);
+    }
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmTableSpace: number of tables with the shape of a machine's table
+//
+//
+// DESCRIPTION
+//   The number is tmTableRadix() to the power of the number of entries,
+//   e.g. 21^10 = 16,679,880,978,201 for 5 states and 2 characters.
+//
+//
+// RETURN VALUE
+//   Returns -1 if the number does not fit in a TableIndex, 0 otherwise.
+*/
+int
+tmTableSpace(const TuringMachineT *this, TableIndex *tables)
+{
+  const TableIndex radix = tmTableRadix(this);
+  int64_t          di;
+
+  *tables = 1;
+  for(di = 0; di < this->num_states * (this->charset_max + 1); di++) {
+    if(*tables > TABLE_INDEX_MAX / radix) return -1;
+    *tables *= radix;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmTableIndexFormat: write a lexical table index in decimal
+//
+//
+// ARGUMENTS
+//   index (in): lexical table index
+//
+//   string (out): at least TABLE_INDEX_CHARS characters
+//
+//
+// DESCRIPTION
+//   The index is padded with zeros to 14 digits, the width of the
+//   largest 5-state, 2-character index.  printf() has no conversion for
+//   a 128-bit number.
+//
+//
+// RETURN VALUE
+//   Returns string.
+*/
+char *
+tmTableIndexFormat(TableIndex index, char *string)
+{
+  char  digits[TABLE_INDEX_CHARS];
+  char *dp = &digits[TABLE_INDEX_CHARS - 1];
+  int   count = 0;
+
+  *dp = '\0';
+  do {
+    *--dp = '0' + (int) (index % 10);
+    index /= 10;
+    count ++;
+  } while(index || (count < 14));
+  strcpy(string, dp);
+  return string;
+}
+
+
+
+
+/* NAME
+//   tmTableIndexParse: read a lexical table index written in decimal
+//
+//
+// RETURN VALUE
+//   Returns -1 if the string is not a number, or the number does not
+//   fit in a TableIndex.  Returns 0 otherwise.
+*/
+int
+tmTableIndexParse(const char *string, TableIndex *index)
+{
+  const char *sp = string;
+
+  *index = 0;
+  if('\0' == *sp) return -1;
+  for(; *sp != '\0'; sp++) {
+    const int digit = *sp - '0';
+
+    if((digit < 0) || (digit > 9)) return -1;
+    if(*index > (TABLE_INDEX_MAX - digit) / 10) return -1;
+    *index = *index * 10 + digit;
+  }
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmTableIndex: return lexical index of the Turing machine table
+//
+//
+// DESCRIPTION
+//   tmTableIndex is tmTableRank() for programs that keep the index in
+//   an int64_t.
+//
+//
+// RETURN VALUE
+//   Returns -1 if the index does not fit in an int64_t.
+*/
+int64_t
+tmTableIndex(const TuringMachineT *this)
+{
+  TableIndex ti;  /* table index */
+
+  if((tmTableRank(this, &ti) < 0) || (ti > INT64_MAX)) {
+    return -1;
+  }
+  return ti;
+}
+
+
+
+
+/* NAME
+//   tmTableWrite: write a Turing machine table in a machine readable form
+//
+//
+// DESCRIPTION
+//   tmTableWrite writes a Turing machine table in a way such that it
+//   can be read in by tmTableRead.
+*/
+int
+tmTableWrite(const TuringMachineT * const this, const char * const filename)
+{
+  FILE *stream;
+  int si;
+  int ii;
+  static const char move_chars[] = "LRS";
+  TableIndex ti;  /* table index */
+  char index[TABLE_INDEX_CHARS];
+
+  /* Open the tape file for writing */
+  if((stream=fopen(filename, "w"))==NULL) {
+    fprintf(stderr, "tmTableWrite: error opening '%s'\n", filename);
+    return -1;
+  }
+
+  if(tmTableRank(this, &ti) < 0) {
+    fprintf(stream, "# %s: written from %s version %s\n",
+            filename, __FILE__, __DATE__);
+  } else {
+    fprintf(stream, "# %s: table %s written from %s version %s\n",
+            filename, tmTableIndexFormat(ti, index), __FILE__, __DATE__);
+  }
+
+  fprintf(stream, "\ncharset_max %i\n", this->charset_max);
+
+  for(si=0; si < this->num_states; si++) {
+    fprintf(stream, "\nstate %i\n", si);
+    for(ii=0; ii <= this->charset_max; ii++) {
+      fprintf(stream, "input %i write %i move %c next %i\n", ii,
+             this->table[si][ii].write,
+             move_chars[this->table[si][ii].move],
+             this->table[si][ii].next);
+    }
+  }
+  fclose(stream);
+  return 1;
+}
+
+
+
+
+/* NAME
+//   tmTableCurse: use curses to print Turing Machine state transition table
+//
+//
+// ARGUMENTS
+//   wy (in): row to print table, where row 0 is the top
+//     if wy is negative then print without using curses
+//
+//   wx (in): column to print table, where colunm 0 is the left
+//
+//
+// DESCRIPTION
+//   The left-most column of the state transition table indicates the
+//   state.  Each row of the state transition table indicates the
+//   instructions to perform for that given state.  Each of the columns
+//   to the right of the leftmost column are for a given input from the
+//   current tape frame.  The entries in the state transition table
+//   have 3 symbols.  The left symbol indicates the value to be written
+//   onto the current tape frame, the middle symbol indicates the
+//   direction that the tape head will move, and the right symbol
+//   indicates the next state to enter.  The entry that corresponds to
+//   the current state and tape input value is highlighted.
+//
+//   If the terminal text window is too small to fit the table, a
+//   message is printed which indicates the minimum number of lines the
+//   window must have in order to display the table.
+//
+//
+// SEE ALSO
+//   tmTablePrint(), tmTapeFrame(), curses library
+*/
+void
+tmTableCurse(const TuringMachineT *this, const int wy, const int wx)
+{
+  static const char move_chars[] = "LRS";
+
+  int64_t   si;
+  int64_t   ii;
+  int    py = wy;
+  int  (*print)(const char *fmt,...);
+
+  if(wy > 0) {
+    print = printw;
+  } else {
     print = printf;
   }
 
@@ -567,48 +1128,219 @@ tmTableCurse(const TuringMachineT *this, const int wy, const int wx)
 
 
 
+/* TAPE_ALLOC_MIN: number of tape frames allocated for a new tape
+//
+// This must be a multiple of 64, so that a bit-packed tape grows by
+// whole words.
+*/
+#define TAPE_ALLOC_MIN 1024
+
+
+
+
+/* tmTapeBytes: number of bytes of tape memory used to store 'frames' frames
+//
+// For a bit-packed tape, 'frames' must be a multiple of 64.
+*/
+#define tmTapeBytes(this, frames) \
+  ((frames) * (this)->tape_width / 8)
+
+
+
+
+/* tmTapeMemSet: store the tape memory in tape, tape_wide or tape_words */
+static void
+tmTapeMemSet(TuringMachineT *this, char *mem)
+{
+  if(1 == this->tape_width) {
+    this->tape_words = (uint64_t *) mem;
+  } else if(8 == this->tape_width) {
+    this->tape = (int8_t *) mem;
+  } else {
+    this->tape_wide = (Char *) mem;
+  }
+}
+
+
+
+
 /* NAME
-//   tmTapeAlloc: Allocate more memory for tape, if needed
+//   tmTapeReserve: make sure tape memory exists for a span of head positions
+//
+//
+// ARGUMENTS
+//   this (in/out): Turing Machine
+//   left (in): leftmost head position which must be stored
+//   right (in): rightmost head position which must be stored
 //
 //
 // DESCRIPTION
-//   The tape of an abstract Turing Machine is infinitely long.  In
-//   this simulation, the tape is finite, obviously, but the tape can
-//   "grow" dynamically.  Any time a portion of the tape is accessed
-//   which was not previously represented (i.e., was not previously
-//   allocated), more tape is allocated.  tmTapeAlloc() should be
-//   called every time the this->here tape head position is changed.
+//   The memory for the tape grows independently to the left and to the
+//   right.  Each time the tape has to grow on one end, the allocation
+//   grows on that end by at least the current allocated length, so the
+//   cost of growing the tape is amortized over many moves.  New memory
+//   is blanked in bulk.
 //
+//   The tape memory is tape (one byte per frame), tape_wide (16 bits
+//   per frame) or tape_words (one bit per frame), depending on
+//   tape_width.  A bit-packed tape
+//   always grows by a multiple of 64 frames, and always has a whole
+//   word beyond 'right'.
+//
+//   A paged tape (see tape_paged) is reserved by pageReserve(), and a
+//   tape in a memory-mapped file (see tape_map) by mapReserve().
+//
+//   tmTapeReserve() does not change the extent of the tape accessed
+//   so far (left_end, right_end).  Engines that look at the tape in
+//   the neighborhood of the head use it directly; everything else
+//   should use tmTapeAlloc().
 //
-// NOTE
-//   If the memory allocation fails, tmTapeAlloc() exits the process.
+//
+// RETURN VALUE
+//   Returns -1 if memory could not be allocated, in which case the tape
+//   is as it was.
+//   Returns 0 otherwise.
 //
 //
 // SEE ALSO
-//   tmTapeMove(), tmTapeIndex(), realloc()
+//   tmTapeAlloc(), tmTapeIndex(), realloc()
 */
-void
-tmTapeAlloc(TuringMachineT *this)
+int
+tmTapeReserve(TuringMachineT *this, int64_t left, int64_t right)
 {
-  int64_t ti = tmTapeIndex(this);
+  char    *mem;  /* tape memory: tape, tape_wide or tape_words */
+  int64_t  ti;
+
+  if(this->tape_paged) {
+    return pageReserve(this, left, right);
+  }
+
+  if(1 == this->tape_width) right += 64;
+
+  if(this->tape_map != NULL) {
+    return mapReserve(this, left, right);
+  }
+
+  mem =   (1 == this->tape_width) ? (char *) this->tape_words
+        : (8 == this->tape_width) ? (char *) this->tape
+        :                           (char *) this->tape_wide;
+
+  if(NULL == mem) {
+    /* Allocate a new tape, centered on the head */
+    if((mem = calloc(tmTapeBytes(this, TAPE_ALLOC_MIN), 1))==NULL)
+    {
+      fprintf(stderr, "tmTapeAlloc: out of memory\n");
+      return -1;
+    }
+    tmTapeMemSet(this, mem);
+    this->tape_alloc  = TAPE_ALLOC_MIN;
+    this->tape_origin = TAPE_ALLOC_MIN / 2 - this->here;
+  }
+
+  ti = left + this->tape_origin;
 
-  if(this->tape_len <= ti) {
-    int64_t ni;
+  if(ti < 0) {
+    /* Grow the tape to the left */
+    int64_t  grow = MAX(this->tape_alloc, -ti);
+    char    *old  = mem;
 
-    if((this->tape = realloc(this->tape, sizeof(Char) * (ti+1)))==NULL)
+    if(1 == this->tape_width) grow = (grow + 63) & ~(int64_t)63;
+
+    if((mem = malloc(tmTapeBytes(this, this->tape_alloc + grow)))==NULL)
     {
       fprintf(stderr, "tmTapeAlloc: out of memory\n");
-      exit(1);
+      return -1;
     }
+    memset(mem, 0, tmTapeBytes(this, grow));
+    memcpy(&mem[tmTapeBytes(this, grow)], old,
+           tmTapeBytes(this, this->tape_alloc));
+    free(old);
+    tmTapeMemSet(this, mem);
+
+    this->tape_alloc  += grow;
+    this->tape_origin += grow;
+  }
+
+  ti = right + this->tape_origin;
 
-    /* Blank out the new tape elements */
-    for(ni=this->tape_len; ni <= ti; ni++) {
-      /*printf("tmTapeAlloc: blanking tape[%li]\n", ni);*/
-      this->tape[ni] = 0;
+  if(ti >= this->tape_alloc) {
+    /* Grow the tape to the right */
+    int64_t grow = MAX(this->tape_alloc, ti - this->tape_alloc + 1);
+
+    if(1 == this->tape_width) grow = (grow + 63) & ~(int64_t)63;
+
+    if((mem = realloc(mem, tmTapeBytes(this, this->tape_alloc + grow)))==NULL)
+    {
+      fprintf(stderr, "tmTapeAlloc: out of memory\n");
+      return -1;
     }
+    memset(&mem[tmTapeBytes(this, this->tape_alloc)], 0,
+           tmTapeBytes(this, grow));
+    tmTapeMemSet(this, mem);
 
-    this->tape_len = ti + 1;
+    this->tape_alloc += grow;
   }
+
+  return 0;
+}
+
+
+
+
+/* NAME
+//   tmTapeAlloc: Allocate more memory for tape, if needed
+//
+//
+// DESCRIPTION
+//   The tape of an abstract Turing Machine is infinitely long.  In
+//   this simulation, the tape is finite, obviously, but the tape can
+//   "grow" dynamically.  Any time a portion of the tape is accessed
+//   which was not previously represented (i.e., was not previously
+//   allocated), more tape is allocated.  tmTapeAlloc() should be
+//   called every time the this->here tape head position moves outside
+//   of [left_end, right_end].
+//
+//   tmTapeAlloc() records the exact extent of the tape accessed so far
+//   in left_end and right_end, then calls tmTapeReserve() to make sure
+//   the tape memory covers the head.
+//
+//
+// RETURN VALUE
+//   Returns -1 if memory could not be allocated, in which case the
+//   extent of the tape is as it was, and does not cover the head.
+//   Returns 0 otherwise.
+//
+//
+// SEE ALSO
+//   tmTapeMove(), tmTapeReserve(), tmTapeIndex()
+*/
+int
+tmTapeAlloc(TuringMachineT *this)
+{
+  const int64_t left_end  = this->left_end;
+  const int64_t right_end = this->right_end;
+  const int64_t tape_len  = this->tape_len;
+
+  /* Record the extent of the tape accessed so far */
+  if(0 == this->tape_len) {
+    this->left_end  = this->here;
+    this->right_end = this->here;
+  } else if(this->here < this->left_end) {
+    this->left_end  = this->here;
+  } else if(this->here > this->right_end) {
+    this->right_end = this->here;
+  } else {
+    return 0;
+  }
+  this->tape_len = this->right_end - this->left_end + 1;
+
+  if(tmTapeReserve(this, this->here, this->here) < 0) {
+    this->left_end  = left_end;
+    this->right_end = right_end;
+    this->tape_len  = tape_len;
+    return -1;
+  }
+  return 0;
 }
 
 
@@ -628,14 +1360,16 @@ tmTapeAlloc(TuringMachineT *this)
 //   or right by one frame.  tmTapeMove() should be used as the only
 //   way to move a tape head.
 //
-//   If the tape had not previously been long enough to refer to the
-//   index that results from the move, then the tape is reallocated to
-//   include the new tape index, and the new tape elements are
+//   If the move takes the tape head outside of the portion of the tape
+//   accessed so far, then tmTapeAlloc() records the new extent of the
+//   tape, and grows the tape memory if needed.  New tape elements are
 //   initialized to blank (0).
 //
 //
 // RETURN VALUE
 //   Return -1 if a Stop instruction was reached.
+//   Return -2 if the tape could not grow, in which case the head does
+//     not move.
 //   Return 0 if a MOVE_LEFT or a MOVE_RIGHT was performed.
 //
 //
@@ -645,6 +1379,8 @@ tmTapeAlloc(TuringMachineT *this)
 int
 tmTapeMove(TuringMachineT *this, Move move)
 {
+  const int64_t here = this->here;
+
   if(move==MOVE_LEFT) {
     this->here --;
   } else if(move==MOVE_RIGHT) {
@@ -652,7 +1388,10 @@ tmTapeMove(TuringMachineT *this, Move move)
   } else {
     return -1;
   }
-  tmTapeAlloc(this);
+  if(tmTapeAlloc(this) < 0) {
+    this->here = here;
+    return -2;
+  }
   return 0;
 }
 
@@ -679,14 +1418,10 @@ tmTapeMove(TuringMachineT *this, Move move)
 int
 tmTapeWrite(TuringMachineT *this, const char *filename)
 {
-  const int64_t here     = this->here;
-
-  /* far_head: head position corresponding to the end of the tape */
-  const int64_t far_head = tmTapeHead(this, this->tape_len - 1);
-
-  int64_t       start_index;
-  int64_t       last_index;
-  FILE      *stream;
+  const int64_t here        = this->here;
+  const int64_t start_index = this->left_end;
+  const int64_t last_index  = this->right_end;
+  FILE         *stream;
 
   /* Open the tape file for writing */
   if((stream=fopen(filename, "w"))==NULL) {
@@ -699,13 +1434,6 @@ tmTapeWrite(TuringMachineT *this, const char *filename)
           this->tape_len, this->here);
 
   /* Print the starting index */
-  if(far_head >= 0) {
-    start_index = -far_head;
-    last_index = far_head;
-  } else {
-    start_index = far_head;
-    last_index = -(far_head+1);
-  }
   fprintf(stream, "start %lli\n", start_index);
 
   /* Print the current state */
@@ -846,16 +1574,18 @@ tmTapeRead(TuringMachineT *this, char *filename)
   this->here = start;
 
   /* Allocate some memory for the tape */
-  tmTapeAlloc(this);  /* call tmTapeAlloc whenever this->here is changed */
+  if(tmTapeAlloc(this) < 0) {  /* call tmTapeAlloc whenever this->here is changed */
+    fclose(stream);
+    return -7;
+  }
 
   /* Move tape head one frame to the left because the tape head is moved
   // to the right just before setting the frame value.
   // This have to be done after the tmTapeAlloc because we only want to
-  // allocate as much space as we need, and no more.  It would not be
-  // crucial that we do not allocate more space except that if the tape
-  // being read is a tape written from a previous run, and more tape
-  // were allocated than necessary, then the tape would gradually grow
-  // unnecessarily.
+  // record as much of the tape as the file provides, and no more.  If
+  // the tape being read is a tape written from a previous run, and more
+  // tape were recorded than necessary, then the tape would gradually
+  // grow unnecessarily.
   */
   this->here -- ;
 
@@ -869,15 +1599,21 @@ tmTapeRead(TuringMachineT *this, char *filename)
        || ((sscanf(line, "head %i ", &character))==1)
       )
     {
-      if((character < -1) || (character > this->charset_max)) {
+      if(   (character < ((1 == this->tape_width) ? 0 : -1))
+         || (character > this->charset_max))
+      {
         // int32_t charset_max = this->charset_max;  /* type conversion */
         fprintf(stderr, "tmTapeRead: %i: character %i too big > %i\n",
                 line_num, character, this->charset_max);
         return -3;
       }
 
-      tmTapeMove(this, MOVE_RIGHT);
-      tmTapeFrame(this) = character;  /* type conversion */
+      if(   (tmTapeMove(this, MOVE_RIGHT) < 0)
+         || (tmTapeFrameSet(this, character) < 0))  /* type conversion */
+      {
+        fclose(stream);
+        return -7;
+      }
 
       if(!strncmp(line, "head", 4)) {
         if(head_given) {
@@ -922,7 +1658,9 @@ tmTapeRead(TuringMachineT *this, char *filename)
 
   /* Move tape head to initial position */
   this->here = head_start;
-  tmTapeAlloc(this);  /* call tmTapeAlloc whenever this->here is changed */
+  if(tmTapeAlloc(this) < 0) {  /* call tmTapeAlloc whenever this->here is changed */
+    return -7;
+  }
 
   return line_num;  /* return "okay" status */
 }
@@ -932,103 +1670,354 @@ tmTapeRead(TuringMachineT *this, char *filename)
 
 /* NAME
 //   tmTapeBlank:  erase Turing machine tape and initialize a new one
+//
+//
+// RETURN VALUE
+//   Returns -1 if memory for the tape could not be allocated.
+//   Returns 0 otherwise.
 */
-void
+int
 tmTapeBlank(TuringMachineT *this)
 {
-  tmTapeFree(this);
+  /* Keep the tape memory, if any, and blank out the part of it that
+  // was accessed.  Every other element of tape[] is already blank.
+  */
+  if(this->tape_paged) {
+    pageBlank(this);
+  } else if((1 == this->tape_width) && (this->tape_words != NULL)) {
+    const int64_t left_word  = (this->left_end  + this->tape_origin) >> 6;
+    const int64_t right_word = (this->right_end + this->tape_origin) >> 6;
+
+    memset(&this->tape_words[left_word], 0,
+           sizeof(uint64_t) * (right_word - left_word + 1));
+  } else if((8 == this->tape_width) && (this->tape != NULL)) {
+    memset(&this->tape[this->left_end + this->tape_origin], 0,
+           this->tape_len);
+  } else if((16 == this->tape_width) && (this->tape_wide != NULL)) {
+    memset(&this->tape_wide[this->left_end + this->tape_origin], 0,
+           sizeof(Char) * this->tape_len);
+  }
+  this->tape_len = 0;
+  tmTapeCountClear(this);
 
   /* Set the tape head position at the left end of where the
   // tape file provides tape data.
   */
   this->here = 0;
 
-  /* Allocate some memory for the tape */
-  tmTapeAlloc(this);  /* call tmTapeAlloc whenever this->here is changed */
+  /* Allocate some memory for the tape */
+  return tmTapeAlloc(this);  /* call tmTapeAlloc whenever this->here is changed */
+}
+
+
+
+
+/* NAME
+//   tmFork: make a copy of a machine which carries on from where it is
+//
+//
+// DESCRIPTION
+//   The fork has its own table, state, head, tape and symbol counts,
+//   so either machine can be changed and run, on the same thread or
+//   another, without the other seeing it.  A search can fork a machine
+//   which reached a transition it has not used yet, give each fork a
+//   different transition there, and run them on from that point
+//   instead of from a blank tape.
+//
+//   A paged tape (see tape_paged) is shared with the fork page by
+//   page, and a page is only copied when one of the machines first
+//   writes to it (see pageFork), so forking costs one pointer per page
+//   spanned by the tape, however much is written on it.  Any other
+//   tape is copied whole.
+//
+//   The compiled program is not copied, as tmSimulate() compiles it,
+//   and the cycle detector is not copied either.  A tape in a
+//   memory-mapped file, or a machine with more than one tape, cannot
+//   be forked.  The machine must not be running on another thread
+//   while it is forked.
+//
+//
+// RETURN VALUE
+//   Returns the fork, or NULL if memory could not be allocated or the
+//   machine cannot be forked.
+//
+//
+// SEE ALSO
+//   tmNew(), tmDestroy(), pageFork()
+*/
+TuringMachineT *
+tmFork(TuringMachineT *this)
+{
+  const int64_t   line_length = this->charset_max + 1;
+  TuringMachineT *fork;
+  State           si;
+
+  if((this->tape_map != NULL) || (this->multi != NULL)) {
+    fprintf(stderr, "tmFork: a machine with a memory-mapped tape or more"
+            " than one tape cannot be forked\n");
+    return NULL;
+  }
+
+  if((fork = tmNew())==NULL) {
+    return NULL;
+  }
+
+  fork->charset_max = this->charset_max;
+  fork->state       = this->state;
+  fork->num_states  = this->num_states;
+  fork->here        = this->here;
+  fork->tape_len    = this->tape_len;
+  fork->left_end    = this->left_end;
+  fork->right_end   = this->right_end;
+  fork->tape_origin = this->tape_origin;
+  fork->tape_alloc  = this->tape_alloc;
+  fork->tape_width  = this->tape_width;
+  fork->tape_paged  = this->tape_paged;
+  fork->break_state = this->break_state;
+  fork->blank_test  = this->blank_test;
+
+  if(this->table != NULL) {
+    Entry *table = malloc(sizeof(Entry) * line_length * this->num_states);
+
+    if(   (NULL == table)
+       || ((fork->table = malloc(sizeof(Entry *) * this->num_states))==NULL))
+    {
+      free(table);
+      tmDestroy(fork);
+      return NULL;
+    }
+    memcpy(table, this->table[0],
+           sizeof(Entry) * line_length * this->num_states);
+    for(si = 0; si < this->num_states; si++) {
+      fork->table[si] = &table[si * line_length];
+    }
+  }
+
+  if(this->symbol_count != NULL) {
+    if((fork->symbol_count = malloc(sizeof(int64_t) * line_length))==NULL) {
+      tmDestroy(fork);
+      return NULL;
+    }
+    memcpy(fork->symbol_count, this->symbol_count,
+           sizeof(int64_t) * line_length);
+  }
+
+  if(this->tape_paged) {
+    if(pageFork(fork, this) < 0) {
+      tmDestroy(fork);
+      return NULL;
+    }
+  } else {
+    const char *mem =   (1 == this->tape_width) ? (char *) this->tape_words
+                      : (8 == this->tape_width) ? (char *) this->tape
+                      :                           (char *) this->tape_wide;
+
+    if(mem != NULL) {
+      char *copy = malloc(tmTapeBytes(this, this->tape_alloc));
+
+      if(NULL == copy) {
+        tmDestroy(fork);
+        return NULL;
+      }
+      memcpy(copy, mem, tmTapeBytes(this, this->tape_alloc));
+      tmTapeMemSet(fork, copy);
+    }
+  }
+
+  return fork;
+}
+
+
+
+
+/* NAME
+//   tmTapePrint: print Turing Machine tape
+//
+//
+// DESCRIPTION
+//   The tape of a Turing Machine is printed.  The tape frame at which
+//   the tape head is sitting is indicated by a head location marker The
+//   tape frame where the head started (tape frame 0) is indicated by a
+//   frame index marker.
+//
+//
+// SEE ALSO
+//   tmTapeIndex()
+*/
+void
+tmTapePrint(TuringMachineT *this)
+{
+  int64_t ti;
+  int64_t left_end;
+  int64_t right_end;
+  int64_t here = this->here;
+
+  printf("TAPE:\n");
+  printf("-----\n");
+  left_end  = this->left_end;
+  right_end = this->right_end;
+
+#if (VERBOSE >= 2)
+  printf("tape spans from %li to %li\n", left_end, right_end);
+  this->here = left_end;
+  printf("tape indices are %li", tmTapeIndex(this));
+  this->here = right_end;
+  printf(" to %li\n", tmTapeIndex(this));
+  this->here = here;
+#endif
+
+  /* Print tape */
+  for(ti=left_end; (this->here=ti) <= right_end; ti++) {
+    int64_t tape_frame = tmTapeFrame(this);  /* type conversion */
+
+    if(ti==0) {
+      printf(" [0]>");
+    }
+    if(ti==here) {
+      printf(" [head@%lli]>", ti);
+    }
+    printf(" %1lli", tape_frame);
+  }
+  this->here = here;  /* restore tape head location */
+  printf("\n");
+}
+
+
+
+
+#ifndef __GNUC__
+/* tmPopCount64: number of bits set in a 64-bit word; see POPCOUNT64 */
+int
+tmPopCount64(uint64_t w)
+{
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int)((w * 0x0101010101010101ULL) >> 56);
+}
+#endif
+
+
+
+
+/* tmTapeOneCount: count the number of '1's on a Turing Machine tape
+//
+// DESCRIPTION
+//   The count is kept up to date as the tape is written, so this takes
+//   no time at all.
+//
+// RETURN VALUE
+//   Return the number of '1's on the tape.
+//
+// SEE ALSO
+//   tmTapeSymbolCount()
+*/
+int64_t
+tmTapeOneCount(const TuringMachineT *this)
+{
+  if(this->charset_max < 1) {
+    return 0;
+  }
+  return this->symbol_count[1];
+}
+
+
+
+
+/* NAME
+//   tmTapeSymbolCount: count the tape frames that hold a symbol
+//
+//
+// DESCRIPTION
+//   Frames are counted within the extent of the tape accessed so far,
+//   [left_end, right_end].  Every frame outside of it is blank.
+//
+//   Counts of symbols other than blank are kept up to date by every
+//   write to the tape (see symbol_count).  The blank frames are the
+//   rest of the tape, so counting them takes charset_max additions.
+//
+//
+// RETURN VALUE
+//   Returns the number of frames holding 'symbol'.
+*/
+int64_t
+tmTapeSymbolCount(const TuringMachineT *this, Char symbol)
+{
+  int64_t count;
+  Char    c;
+
+  if((symbol < 0) || (symbol > this->charset_max)) {
+    return 0;
+  }
+  if(symbol > 0) {
+    return this->symbol_count[symbol];
+  }
+
+  count = this->tape_len;
+  for(c = 1; c <= this->charset_max; c++) {
+    count -= this->symbol_count[c];
+  }
+  return count;
 }
 
 
 
 
 /* NAME
-//   tmTapePrint: print Turing Machine tape
+//   tmTapeAllBlank: whether every frame of the tape is blank
 //
 //
 // DESCRIPTION
-//   The tape of a Turing Machine is printed.  The tape frame at which
-//   the tape head is sitting is indicated by a head location marker The
-//   tape frame where the head started (tape frame 0) is indicated by a
-//   frame index marker.
+//   Looks at the counts of the symbols other than blank (see
+//   symbol_count), so it takes charset_max tests, however long the
+//   tape.  This is the busy beaver test of tmSimulateSteps() and
+//   cycleSimulateSteps(), which must agree on it.
+//
+//
+// RETURN VALUE
+//   Returns 1 if no frame holds a symbol other than blank, else 0.
 //
 //
 // SEE ALSO
-//   tmTapeIndex()
+//   tmTapeSymbolCount(), tmIterTest()
 */
-void
-tmTapePrint(TuringMachineT *this)
+int
+tmTapeAllBlank(const TuringMachineT *this)
 {
-  int64_t ti;
-  int64_t left_end;
-  int64_t right_end;
-  int64_t here = this->here;
-
-  printf("TAPE:\n");
-  printf("-----\n");
-  if(this->tape_len % 2 == 0) {
-    /* last element on tape is odd, i.e. has a negative index */
-    left_end = - this->tape_len / 2;
-    right_end = this->tape_len + left_end - 1;
-  } else {
-    /* last element on tape is even, i.e. has a non-negative index */
-    right_end = this->tape_len / 2;
-    left_end = right_end - this->tape_len + 1;
-  }
-
-#if (VERBOSE >= 2)
-  printf("tape spans from %li to %li\n", left_end, right_end);
-  this->here = left_end;
-  printf("tape indices are %li", tmTapeIndex(this));
-  this->here = right_end;
-  printf(" to %li\n", tmTapeIndex(this));
-  this->here = here;
-#endif
-
-  /* Print tape */
-  for(ti=left_end; (this->here=ti) <= right_end; ti++) {
-    int64_t tape_frame = tmTapeFrame(this);  /* type conversion */
+  Char c;
 
-    if(ti==0) {
-      printf(" [0]>");
-    }
-    if(ti==here) {
-      printf(" [head@%lli]>", ti);
+  for(c = 1; c <= this->charset_max; c++) {
+    if(this->symbol_count[c]) {
+      return 0;
     }
-    printf(" %1lli", tape_frame);
   }
-  this->here = here;  /* restore tape head location */
-  printf("\n");
+  return 1;
 }
 
 
 
 
-/* tmTapeOneCount: count the number of '1's on a Turing Machine tape
+/* NAME
+//   tmIterTest: number of shifts the busy beaver test looks at
+//
+//
+// DESCRIPTION
+//   If blank_test is set, a machine that is back in state 0 on a blank
+//   tape within its first iter_test shifts is given up on, as it
+//   will do the same thing over and over again.  This is a quick way
+//   to throw out many machines in a busy beaver search.
+//
 //
 // RETURN VALUE
-//   Return the number of '1's on the tape.
+//   Returns iter_test, or 0 if blank_test is not set.
 */
 int64_t
-tmTapeOneCount(const TuringMachineT *this)
+tmIterTest(const TuringMachineT *this)
 {
-  int64_t ti;
-  int64_t count = 0;
-
-  for(ti=0; ti < this->tape_len; ti++) {
-    if(this->tape[ti] == 1) {
-      count ++;
-    }
+  if(! this->blank_test) {
+    return 0;
   }
-  return count;
+  return this->num_states * (this->charset_max + 1);
 }
 
 
@@ -1104,15 +2093,8 @@ tmTapeCurse(const TuringMachineT *this, int wy, int wx)
   }
 
   /* Find ends of tape */
-  if(this->tape_len % 2 == 0) {
-    /* last element on tape is odd, i.e. has a negative index */
-    left_end  = - this->tape_len / 2;
-    right_end =   this->tape_len + left_end - 1;
-  } else {
-    /* last element on tape is even, i.e. has a non-negative index */
-    right_end =             this->tape_len / 2;
-    left_end  = right_end - this->tape_len + 1;
-  }
+  left_end  = this->left_end;
+  right_end = this->right_end;
 
   /* Calculate what segment of the tape to display */
   tape_print_left  = this->here - size_x / 4;
@@ -1174,7 +2156,7 @@ tmTapeCurse(const TuringMachineT *this, int wy, int wx)
 
   for(ti=tape_print_left; ti <= tape_print_right; ti++) {
     shallow_copy.here = ti;
-    printw(" %1li", this->tape[tmTapeIndex(&shallow_copy)]);
+    printw(" %1i", tmTapeFrame(&shallow_copy));
   }
 
   if(tape_print_right < right_end) {
@@ -1258,6 +2240,8 @@ tmTapeCurse(const TuringMachineT *this, int wy, int wx)
 //   Return 1 if a "stop" statement was reached.
 //   Return 0 if a "MOVE_LEFT" or "MOVE_RIGHT" was done to the tape
 //   head, along with the associated other steps.
+//   Return -1 if memory for the tape could not be allocated, in which
+//   case the state is not changed.
 //
 //
 // SEE ALSO
@@ -1267,101 +2251,616 @@ int
 tmUpdate(TuringMachineT *this)
 {
   /* Read the tape here */
-  const Char input  = tmTapeFrame(this);
-  const Move move   = this->table[this->state][input].move;
+  const Char          input = tmTapeFrame(this);
+  const Entry * const entry = &this->table[this->state][input];
+  const Move          move  = entry->move;
 
   /* Write the value for this input */
-  tmTapeFrame(this) = this->table[this->state][input].write;
+  if(tmTapeFrameSet(this, entry->write) < 0) {
+    return -1;
+  }
+
+  /* Move the tape */
+  if(-2 == tmTapeMove(this, move)) {
+    return -1;
+  }
+
+  /* Set the machine into the new state */
+  this->state = entry->next;
+
+  if(STOP == move) {
+    return 1; /* Turing machine reached STOP */
+  }
+
+  return 0; /* keep going */
+}
+
+
+
+
+/* tmStatePrint: print the current state and tape head position
+//
+// For debugging.
+//
+// SEE ALSO
+//   tmStateCurse()
+*/
+void
+tmStatePrint(const TuringMachineT *this)
+{
+  // int32_t state = this->state;  /* type conversion */
+  printf("state %i    head %lli\n", this->state, this->here);
+}
+
+
+
+
+/* NAME
+//   tmRunBits: run the compiled program on a bit-packed tape
+//
+//
+// DESCRIPTION
+//   tmRunBits is the part of tmRun() that runs machines whose tape is
+//   stored 1 bit per frame (see tape_width).  The 64-bit word holding
+//   the frame under the head is kept in a register, so reading and
+//   writing a frame is a shift and a mask, and memory is only touched
+//   when the head moves onto a different word.  The count of 1's is
+//   kept in a register too.
+//
+//   Arguments and return values are those of tmRun().
+//
+//
+// SEE ALSO
+//   tmRun(), tmTableCompile()
+*/
+
+/* RUN_BITS_STEP: execute one shift of the compiled program
+//
+// Used only by tmRunBits, which owns all of the variables referred to.
+// Leaves the loop it is in when the machine stops or the head crosses
+// the edge of the tape accessed so far.
+*/
+#define RUN_BITS_STEP \
+{ \
+  const int read = (word >> bit) & 1; \
+  const Op op = rowp[read]; \
+  const int32_t delta = OP_DELTA(op); \
+ \
+  ones += (OP_WRITE(op) & 1) - read; \
+  word ^= (uint64_t)((read ^ OP_WRITE(op)) & 1) << bit; \
+  rowp  = program + OP_ROW(op); \
+  shifts ++; \
+ \
+  if(0 == delta) { \
+    *event = EVENT_STOP; \
+    break; \
+  } \
+  here += delta; \
+ \
+  if((uint64_t)(here - left_end) >= (uint64_t)tape_len) { \
+    /* Head crossed the edge of the tape accessed so far */ \
+    *wordp     = word; \
+    this->here = here; \
+    if(tmTapeAlloc(this) < 0) { \
+      here  -= delta; \
+      *event = EVENT_ERROR; \
+      break; \
+    } \
+    wordp      = &this->tape_words[tmTapeIndex(this) >> 6]; \
+    word       = *wordp; \
+    *event     = EVENT_EDGE; \
+    break; \
+  } \
+ \
+  bit += delta; \
+  if(bit & ~63) { \
+    /* Head moved onto the next word */ \
+    *wordp  = word; \
+    wordp  += delta; \
+    bit    &= 63; \
+    word    = *wordp; \
+  } \
+}
+
+static int64_t
+tmRunBits(TuringMachineT *this, int64_t budget, Event *event)
+{
+  const Op * const program = this->program;
+  int64_t          shifts  = 0;
+  const Op        *rowp;     /* the current state's row in program */
+  int64_t          here;     /* tape head position */
+  uint64_t        *wordp;    /* tape word holding the frame under the head */
+  uint64_t         word;     /* cached value of *wordp */
+  int64_t          bit;      /* bit of word under the head */
+  int64_t          left_end; /* left end of the tape accessed so far */
+  int64_t          tape_len; /* length of the tape accessed so far */
+  int64_t          ones;     /* number of 1's on the tape */
+
+  /* Load the machine into local variables */
+  rowp     = program + this->state * (this->charset_max + 1);
+  here     = this->here;
+  wordp    = &this->tape_words[tmTapeIndex(this) >> 6];
+  bit      = tmTapeIndex(this) & 63;
+  word     = *wordp;
+  left_end = this->left_end;
+  tape_len = this->tape_len;
+  ones     = this->symbol_count[1];
+
+  *event = EVENT_BUDGET;
+
+  if(this->break_state < 0) {
+    while(shifts < budget) RUN_BITS_STEP;
+  } else {
+    const Op * const break_row =
+      program + this->break_state * (this->charset_max + 1);
+
+    while(shifts < budget) {
+      RUN_BITS_STEP;
+      if(break_row == rowp) {
+        *event = EVENT_BREAK;
+        break;
+      }
+    }
+  }
+
+  /* Store the local variables back into the machine */
+  *wordp      = word;
+  this->here  = here;
+  this->state = (rowp - program) / (this->charset_max + 1);
+  this->symbol_count[1] = ones;
+
+  return shifts;
+}
+
+#undef RUN_BITS_STEP
+
+
+
+
+/* RUN_STEP: execute one shift of the compiled program
+//
+// Used only by tmRunBytes and tmRunWide, which own all of the variables
+// referred to.  OpT is their kind of op word, WRITE, DELTA and ROW its
+// accessors, and TAPE their tape.  Leaves the loop it is in when the
+// machine stops or the head crosses the edge of the tape accessed so
+// far.
+*/
+#define RUN_STEP(OpT, WRITE, DELTA, ROW, TAPE) \
+{ \
+  const Char read = *head; \
+  const OpT op = rowp[read]; \
+  const int32_t delta = DELTA(op); \
+ \
+  count[read] --; \
+  count[WRITE(op)] ++; \
+  *head = WRITE(op); \
+  rowp  = program + ROW(op); \
+  shifts ++; \
+ \
+  if(0 == delta) { \
+    *event = EVENT_STOP; \
+    break; \
+  } \
+  head += delta; \
+ \
+  if((uint64_t)(head - left) >= (uint64_t)tape_len) { \
+    /* Head crossed the edge of the tape accessed so far */ \
+    this->here = (head - this->TAPE) - this->tape_origin; \
+    if(tmTapeAlloc(this) < 0) { \
+      head  -= delta; \
+      *event = EVENT_ERROR; \
+      break; \
+    } \
+    head   = &this->TAPE[tmTapeIndex(this)]; \
+    *event = EVENT_EDGE; \
+    break; \
+  } \
+}
+
+
+
+
+/* NAME
+//   tmRunBytes: run the compiled program on a tape of 8-bit frames
+//
+//
+// DESCRIPTION
+//   The machine registers (state row, pointer to the tape frame under
+//   the head) are held in local variables.  The tape is only grown when
+//   the head crosses the edge of the tape accessed so far.
+//
+//   Arguments and return values are those of tmRun().
+//
+//
+// SEE ALSO
+//   tmRun(), tmTableCompile()
+*/
+static int64_t
+tmRunBytes(TuringMachineT *this, int64_t budget, Event *event)
+{
+  const int64_t line_length = this->charset_max + 1;
+  const Op     *program     = this->program;
+  int64_t      *count       = this->symbol_count;
+  int64_t       shifts      = 0;
+  const Op     *rowp;     /* the current state's row in program */
+  int8_t       *head;     /* tape frame under the tape head */
+  int8_t       *left;     /* left end of the tape accessed so far */
+  int64_t       tape_len; /* length of the tape accessed so far */
+
+  /* Load the machine into local variables */
+  rowp     = program + this->state * line_length;
+  head     = &this->tape[tmTapeIndex(this)];
+  left     = &this->tape[this->left_end + this->tape_origin];
+  tape_len = this->tape_len;
+
+  *event = EVENT_BUDGET;
+
+  if(this->break_state < 0) {
+    while(shifts < budget) RUN_STEP(Op, OP_WRITE, OP_DELTA, OP_ROW, tape);
+  } else {
+    const Op * const break_row = program + this->break_state * line_length;
+
+    while(shifts < budget) {
+      RUN_STEP(Op, OP_WRITE, OP_DELTA, OP_ROW, tape);
+      if(break_row == rowp) {
+        *event = EVENT_BREAK;
+        break;
+      }
+    }
+  }
+
+  /* Store the local variables back into the machine */
+  this->here  = (head - this->tape) - this->tape_origin;
+  this->state = (rowp - program) / line_length;
+
+  return shifts;
+}
+
+
+
+
+/* NAME
+//   tmRunWide: run the compiled program on a tape of 16-bit frames
+//
+//
+// DESCRIPTION
+//   tmRunWide is tmRunBytes() with 16-bit frames and the OpWide form
+//   of the compiled table, so that machines with small alphabets do not
+//   pay for the width of large ones.
+//
+//   Arguments and return values are those of tmRun().
+//
+//
+// SEE ALSO
+//   tmRun(), tmTableCompileWide()
+*/
+static int64_t
+tmRunWide(TuringMachineT *this, int64_t budget, Event *event)
+{
+  const int64_t   line_length = this->charset_max + 1;
+  const OpWide   *program     = this->program_wide;
+  int64_t        *count       = this->symbol_count;
+  int64_t         shifts      = 0;
+  const OpWide   *rowp;     /* the current state's row in program */
+  Char           *head;     /* tape frame under the tape head */
+  Char           *left;     /* left end of the tape accessed so far */
+  int64_t         tape_len; /* length of the tape accessed so far */
+
+  /* Load the machine into local variables */
+  rowp     = program + this->state * line_length;
+  head     = &this->tape_wide[tmTapeIndex(this)];
+  left     = &this->tape_wide[this->left_end + this->tape_origin];
+  tape_len = this->tape_len;
+
+  *event = EVENT_BUDGET;
+
+  if(this->break_state < 0) {
+    while(shifts < budget) RUN_STEP(OpWide, OPW_WRITE, OPW_DELTA, OPW_ROW, tape_wide);
+  } else {
+    const OpWide * const break_row =
+      program + this->break_state * line_length;
+
+    while(shifts < budget) {
+      RUN_STEP(OpWide, OPW_WRITE, OPW_DELTA, OPW_ROW, tape_wide);
+      if(break_row == rowp) {
+        *event = EVENT_BREAK;
+        break;
+      }
+    }
+  }
+
+  /* Store the local variables back into the machine */
+  this->here  = (head - this->tape_wide) - this->tape_origin;
+  this->state = (rowp - program) / line_length;
+
+  return shifts;
+}
+
+#undef RUN_STEP
+
+
+
+
+/* NAME
+//   tmRun: run a Turing Machine until something happens
+//
+//
+// ARGUMENTS
+//   budget (in): most shifts to run
+//
+//   event (out): why tmRun() returned
+//
+//
+// DESCRIPTION
+//   tmRun runs the compiled form of the table in a tight loop that
+//   only returns on one of these events:
+//
+//     EVENT_STOP    the machine reached a stop instruction
+//     EVENT_BUDGET  'budget' shifts were run
+//     EVENT_EDGE    the head crossed the edge of the tape accessed so
+//                   far, and the tape grew by a frame
+//     EVENT_BREAK   the machine entered break_state
+//     EVENT_ERROR   the tape could not grow; the machine is left with
+//                   the head where it was before the failed shift
+//
+//   Limits such as a maximum tape length, polling for user input, and
+//   the busy beaver test are up to the caller, between calls to tmRun,
+//   so they cost nothing per shift.  The machine after tmRun is exactly
+//   as it would be after the same number of calls to tmUpdate().
+//
+//   The table must already be compiled for the tape width:  see
+//   tmTableCompile(), or tmTableCompileWide() for a tape_width of 16
+//   or a paged tape.  Each tape width has its own kernel, and a paged
+//   tape is run by pageRun().
+//
+//
+// RETURN VALUE
+//   Returns the number of shifts run.
+//
+//
+// SEE ALSO
+//   tmSimulate(), tmSimulateSteps(), tmUpdate()
+*/
+int64_t
+tmRun(TuringMachineT *this, int64_t budget, Event *event)
+{
+  if(this->tape_paged) {
+    return pageRun(this, budget, event);
+  }
+  if(1 == this->tape_width) {
+    return tmRunBits(this, budget, event);
+  }
+  if(8 == this->tape_width) {
+    return tmRunBytes(this, budget, event);
+  }
+  return tmRunWide(this, budget, event);
+}
+
+
+
+
+/* NAME
+//   tmProgramCompile: compile the table for the width of the tape
+//
+//
+// RETURN VALUE
+//   Same as tmTableCompile().
+*/
+static int
+tmProgramCompile(TuringMachineT *this)
+{
+  if(16 == this->tape_width) {
+    return tmTableCompileWide(this);
+  }
+  return tmTableCompile(this);
+}
+
+
+
+
+/* NAME
+//   tmSimulate: perform a Turing Machine simulation
+//
+//
+// DESCRIPTION
+//   A Turing Machine simulation is performed without any frills.
+//
+//   tmSimulate compiles the table (see tmTableCompile) and runs it with
+//   tmSimulateSteps(), which calls tmRun() for as many shifts at a time
+//   as the limits allow.  The results are identical to calling
+//   tmUpdate() in a loop.
+//
+//   When the machine has a cycle detector (see cycle), it is run by
+//   cycleSimulateSteps() instead, one shift at a time, so that a
+//   machine that repeats a configuration is given up on as soon as
+//   the repeat is found.
+//
+//   A machine with more than one tape (see multi) is run by
+//   multiSimulate() instead.
+//
+//
+// ARGUMENTS
+//   max_iters (in): maximum number of iterations (shifts) before quitting
+//
+//   tape_len_max (in): maximum tape length before quitting
+//
+//
+// RETURN VALUE
+//   Returns number of shifts if stop occured withing turing machine.
+//   Returns -1 if max_iters was reached.
+//   Returns -2 if tape_len_max was reached.
+//   Returns -3 if (blank_test) the machine returned to state 0 on a
+//     blank tape early on; see tmIterTest().
+//   Returns -4 if the table could not be compiled, or memory could not
+//     be allocated, in which case the machine is left partway through
+//     the run.
+//   Returns -5 if (cycle) the machine repeated a configuration.
+//
+//
+// SEE ALSO
+//   tmUpdate(), tmVisualSimulate(), tmTableCompile(), tmRun(),
+//   cycleSimulateSteps(), multiSimulate()
+*/
+int64_t
+tmSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max)
+{
+  int64_t iters = 0;
+  int     status;
+
+  if(this->multi != NULL) {
+    return multiSimulate(this, max_iters, tape_len_max);
+  }
+
+  if(tmProgramCompile(this) < 0) {
+    return -4;
+  }
+
+  if(this->cycle != NULL) {
+    status = cycleSimulateSteps(this->cycle, this, &iters, max_iters,
+                                tape_len_max, tmIterTest(this));
+  } else {
+    status = tmSimulateSteps(this, &iters, max_iters, max_iters,
+                             tape_len_max, tmIterTest(this));
+  }
 
-  /* Move the tape */
-  tmTapeMove(this, this->table[this->state][input].move);
+  if(status < 0) {
+    return status;
+  }
 
-  /* Set the machine into the new state */
-  this->state = this->table[this->state][input].next;
+  if(status > 0) {
+    return iters;
+  }
 
-  if(STOP == move) {
-    return 1; /* Turing machine reached STOP */
+  if(this->tape_len >= tape_len_max) {
+    return -2;
   }
 
-  return 0; /* keep going */
+  return -1;
 }
 
 
 
 
-/* tmStatePrint: print the current state and tape head position
+/* NAME
+//   tmSimulateSteps: run the machine up to a number of shifts
 //
-// For debugging.
 //
-// SEE ALSO
-//   tmStateCurse()
+// DESCRIPTION
+//   Runs the machine with tmRun() until it stops, *iters reaches
+//   'until' or max_iters, or the tape reaches tape_len_max, checking
+//   the tape length after every shift that grows the tape.
+//
+//   Engines that move the machine many shifts at a time use
+//   tmSimulateSteps() to finish a run near a limit, so that they stop
+//   on exactly the same shift as tmSimulate() would.  The table must
+//   be compiled, as for tmRun().
+//
+//   For the first iter_test shifts, check whether the machine is back
+//   in state 0 on a blank tape (see tmIterTest), with a breakpoint on
+//   state 0.
+//
+//
+// RETURN VALUE
+//   Returns 1 if the machine stopped.
+//   Returns -3 if the machine returned to state 0 on a blank tape.
+//   Returns -4 if memory for the tape could not be allocated.
+//   Returns 0 otherwise.
 */
-void
-tmStatePrint(const TuringMachineT *this)
+int
+tmSimulateSteps(TuringMachineT *this, int64_t *iters, int64_t until,
+                int64_t max_iters, int64_t tape_len_max, int64_t iter_test)
 {
-  // int32_t state = this->state;  /* type conversion */
-  printf("state %i    head %lli\n", this->state, this->here);
+  const State break_state = this->break_state;
+  int         status      = 0;
+
+  until = MIN(until, max_iters);
+
+  while((*iters < until) && (this->tape_len < tape_len_max)) {
+    int64_t budget = until - *iters;
+    Event   event;
+
+    if(*iters < iter_test) {
+      this->break_state = 0;
+      budget = MIN(budget, iter_test - *iters);
+    } else {
+      this->break_state = break_state;
+    }
+
+    *iters += tmRun(this, budget, &event);
+
+    /* A machine that stopped has stopped, whatever its tape */
+    if(EVENT_STOP == event) {
+      status = 1;
+      break;
+    }
+    if((*iters <= iter_test) && (0 == this->state)
+       && tmTapeAllBlank(this))
+    {
+      status = -3;
+      break;
+    }
+    if(EVENT_ERROR == event) {
+      status = -4;
+      break;
+    }
+  }
+
+  this->break_state = break_state;
+  return status;
 }
 
 
 
 
 /* NAME
-//   tmSimulate: perform a Turing Machine simulation
+//   tmEnginePrologue: start a run of the machine for a simulation engine
 //
 //
 // DESCRIPTION
-//   A Turing Machine simulation is performed without any frills.
-//
+//   Compiles the table and runs the first tmIterTest() shifts with
+//   tmSimulateSteps(), so the busy beaver test looks at every one of
+//   them, before an engine moves the machine many shifts at a time.
 //
-// ARGUMENTS
-//   max_iters (in): maximum number of iterations (shifts) before quitting
+//   A machine whose symbols are too wide for an Op (see OP_CHARSET_MAX)
+//   has no engine but tmRun() on the 16-bit kernel, so it is run to the
+//   end here, as tmSimulate() would run it.  The engine then finds it
+//   at a limit, or stopped, and goes on to its epilogue.
 //
 //
 // RETURN VALUE
-//   Returns number of shifts if stop occured withing turing machine.
-//   Returns -1 if max_iters was reached.
+//   Same as tmSimulateSteps(), or as cycleSimulateSteps() for a wide
+//   machine with a cycle detector.
+//   Returns -4 if the table could not be compiled.
 //
 //
 // SEE ALSO
-//   tmUpdate(), tmVisualSimulate()
+//   tmSimulate(), tmSimulateSteps(), tmIterTest()
 */
-int64_t
-tmSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max)
+int
+tmEnginePrologue(TuringMachineT *this, int64_t *iters, int64_t max_iters,
+                 int64_t tape_len_max)
 {
-  int64_t       stop      = 0;
-  int64_t       iters;
-
-#ifdef BUSY_BEAVER_SEARCH
-  /* The BUSY_BEAVER_SEARCH code slows this loop down by %. */
-  const int64_t iter_test = this->num_states * (this->charset_max + 1);
-#endif
+  const int64_t iter_test = tmIterTest(this);
 
-  for(iters=0;
-      !stop && (iters < max_iters) && (this->tape_len < tape_len_max);
-      iters++)
-  {
-    stop = tmUpdate(this);
-#ifdef BUSY_BEAVER_SEARCH
-    if(iters < iter_test) {
-      if(0 == this->state) {
-        if(! tmTapeOneCount(this)) {
-          return -3;
-        }
-      }
+  if(this->charset_max > OP_CHARSET_MAX) {
+    if(tmProgramCompile(this) < 0) {
+      return -4;
     }
-#endif
-  }
-
-  if(stop) {
-    return iters;
+    if(this->cycle != NULL) {
+      return cycleSimulateSteps(this->cycle, this, iters, max_iters,
+                                tape_len_max, iter_test);
+    }
+    return tmSimulateSteps(this, iters, max_iters, max_iters, tape_len_max,
+                           iter_test);
   }
 
-  if(this->tape_len >= tape_len_max) {
-    return -2;
+  if(tmTableCompile(this) < 0) {
+    return -4;
   }
 
-  return -1;
+  /* The busy beaver test looks at every one of the first few shifts */
+  return tmSimulateSteps(this, iters, iter_test, max_iters, tape_len_max,
+                         iter_test);
 }
 
 
@@ -1445,6 +2944,12 @@ tmCursesDisplay(const TuringMachineT *this, int64_t iters)
 
 
 
+/* VISUAL_BATCH: shifts between keyboard polls when nothing is displayed */
+#define VISUAL_BATCH 65536
+
+
+
+
 /* NAME
 //   tmVisualSimulate: perform Turing Machine simulation with display
 //
@@ -1457,9 +2962,16 @@ tmCursesDisplay(const TuringMachineT *this, int64_t iters)
 //   segment of the tape in the vicinity of the tape head.  The display
 //   is all textual, and uses the "curses" screen handling package.
 //
+//   While the display is updated, the machine runs one shift per
+//   update.  With the display turned off, it runs VISUAL_BATCH shifts
+//   at a time with tmRun(), and the keyboard is only polled between
+//   batches.
+//
 //
 // RETURN VALUE
 //   Return the number of iterations (aka shifts) executed.
+//   Return -4 if the table could not be compiled, or memory could not
+//   be allocated.
 */
 int64_t
 tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max, int debug)
@@ -1467,6 +2979,11 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
   int       input          = 0; /* input character from keyboard */
   int64_t iters       = 0; /* number of shifts Turing Machine has executed */
   int       update_display = 1; /* flag: update display of Turing Machine? */
+  Event     event          = EVENT_BUDGET; /* why tmRun() returned */
+
+  if(tmProgramCompile(this) < 0) {
+    return -4;
+  }
 
   /* Set up curses "visual mode" */
   initscr();
@@ -1486,18 +3003,9 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
   /* Display "visual mode" stuff */
   tmCursesDisplay(this, iters);
 
-  /* Main simulation loop: */
-  /* Note that 'iters' is initialized to '1' instead of '0'.
-  // This is because 'iters' is incremented after the end of the loop
-  // body, but before the end of the loop body, we print out the number
-  // of iterations that have passed.  Also, the very last iteration of
-  // the loop ends with a 'break' statement, which means that the end of
-  // the loop body is not executed on the last iteration.  Since 'iters'
-  // is initialized to '1', the number of iterations that have passed is
-  // correct after the point the 'tmUpdate' call is made.
-  */
-  for(iters=1; (iters < max_iters) && (this->tape_len < tape_len_max); iters++)
-  {
+  /* Main simulation loop */
+  while((iters < max_iters) && (this->tape_len < tape_len_max)) {
+    int64_t budget = 1;  /* shifts to run before polling the keyboard */
 
     /* Read a keyboard key press, if there is one */
     input = getch();
@@ -1535,7 +3043,11 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
     }
 
     /* Step forward the Turing Machine */
-    if(tmUpdate(this)) {
+    if(!update_display && !debug) {
+      budget = MIN(VISUAL_BATCH, max_iters - iters);
+    }
+    iters += tmRun(this, budget, &event);
+    if((EVENT_STOP == event) || (EVENT_ERROR == event)) {
       /* The Turing Machine stopped, so break the simulation loop */
       break;
     }
@@ -1553,7 +3065,10 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
 
   /* Print some info about how the simulation went */
   move(0,0);
-  if(iters >= max_iters) {
+  if(EVENT_ERROR == event) {
+    printw("OUT OF MEMORY after %lli shifts -- press a key to finish",
+           (long long) iters);
+  } else if(iters >= max_iters) {
     printw("MAXIMUM ITERATIONS REACHED -- press a key to finish");
   } else if(input == 27) {
     printw("MACHINE HALTED BY USER after %lli shifts -- press a key to finish",
@@ -1575,6 +3090,9 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
 
   endwin();
 
+  if(EVENT_ERROR == event) {
+    return -4;
+  }
   return iters;
 }
 
@@ -1609,7 +3127,7 @@ tmVisualSimulate(TuringMachineT *this, int64_t max_iters, int64_t tape_len_max,
 //
 //
 // SEE ALSO
-//   tmTableIndex(), tmTableWeed(), tmTableBFS()
+//   tmTableIndex(), tmTableWeed(), tmTableReach()
 */
 int
 tmTableNext(TuringMachineT *this)
@@ -1619,28 +3137,26 @@ tmTableNext(TuringMachineT *this)
 
   for(si = 0; si < this->num_states; si++) {
     for(ii = 0; ii <= this->charset_max; ii++) {
-      if(this->table[si][ii].write == this->charset_max) {
+      if(this->table[si][ii].move == STOP) {
+        /* STOP is a single value of the entry: wrap it and carry into
+        // the next entry
+        */
+        this->table[si][ii].write = 0;
+        this->table[si][ii].next = 0;
+        this->table[si][ii].move = MOVE_LEFT;
+      } else if(this->table[si][ii].write == this->charset_max) {
         /* wrap this field and advance to next field */
         this->table[si][ii].write = 0;
 
         if(this->table[si][ii].next == (this->num_states - 1)) {
-          /* wrap this field and advance the next field */
+          /* wrap this field, increment the move and return */
           this->table[si][ii].next = 0;
-
+          this->table[si][ii].move ++;
           if(this->table[si][ii].move == STOP) {
-            /* wrap entire entry and loop */
-            this->table[si][ii].write = 0;
-            this->table[si][ii].next = 0;
-            this->table[si][ii].move = MOVE_LEFT;
-          } else {
-            /* increment and return */
-            this->table[si][ii].move ++;
-            if(this->table[si][ii].move == STOP) {
-              this->table[si][ii].write = 1;
-              this->table[si][ii].next = (this->num_states - 1);
-            }
-            return 0;
+            this->table[si][ii].write = 1;
+            this->table[si][ii].next = (this->num_states - 1);
           }
+          return 0;
         } else {
           /* increment and return */
           this->table[si][ii].next ++;
@@ -1684,137 +3200,120 @@ tmTableContainsStop(TuringMachineT *this)
 
 
 
+/* REACH_LOWEST: number of the lowest set bit of a nonzero word */
+#ifdef __GNUC__
+#define REACH_LOWEST(bits) __builtin_ctzll(bits)
+#else
+static int
+REACH_LOWEST(uint64_t bits)
+{
+  int n = 0;
+
+  while(!(bits & 1)) {
+    bits >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
+
+
+
 /* NAME
-//   tmTableBFS: breadth first search of Turing Machine table
+//   tmTableReach: which states, and what kinds of entry, a table can reach
 //
 //
 // DESCRIPTION
-//   tmTableBFS does a fairly ignorant descent through a Turing Machine
-//   table to see whether possibly reachable entries satisfy some
-//   criterion, which is determined by 'test'.
+//   Walks the table from state 0, one wave of newly found states at a
+//   time, and visits each state it can reach once.  The states are
+//   kept as bitsets of 64 states a word: 'found' holds every state
+//   found so far, and 'wave' those whose entries are yet to be looked
+//   at.  Each entry adds its next state to both if 'found' lacks it,
+//   and ORs what kind of entry it is into reach->found:
+//
+//     REACH_LEFT, REACH_RIGHT, REACH_STOP: the entry moves this way
+//     REACH_ONE:                           the entry writes a 1
 //
-//   Algorithm:
-//     Push state 0 into FIFO.
-//     Loop until (state counter exceeds number of states), or (FIFO is empty):
-//       Pop the FIFO to get a state.
-//       For each entry of this state:
-//         If entry satisfies test, then return 1.
-//         Push next state of this entry into FIFO.
-//       Increment state conter.
+//   The walk ends when a wave finds no new state, or once every state
+//   and every kind of entry has been found, as nothing more can change.
+//
+//   The bitsets live in the machine's reach_scratch, so machines can
+//   be walked at the same time.  reach->states points at 'found', and
+//   is good until the table is walked again.
 //
 //
 // RETURN VALUES
-//   Return result of 'test' if test() ever gives nonzero result.
-//   Return zero otherwise.
+//   Return 0 and fill in 'reach' if the walk was done.
+//   Return -1 if memory for reach_scratch could not be allocated.
+//
+//
+// SEE ALSO
+//   tmTableWeed()
 */
 int
-tmTableBFS(TuringMachineT *this, int test(const Entry * const))
+tmTableReach(TuringMachineT *this, TableReachT *reach)
 {
-  int count = 0;             /* iteration counter */
-  int *state_pushed = NULL;  /* array of Booleans */
-  int state;                 /* index of state being considered */
-  int test_value;            /* value returned by test */
-  int ii;                    /* table input character index */
-  static FifoT *fifo = NULL; /* used for breadth first search */
-
-  if(fifo == NULL) {
-    /* We will be using a FIFO of the same size each time so there's
-    // no reason to allocate it each time.  Just use one FIFO and recycle
-    // it.
-    */
-    fifo = fifoNew(this->num_states * (this->charset_max + 1));
-  }
+  const int words = (this->num_states + 63) / 64;
+  uint64_t *found;          /* bitset of states found */
+  uint64_t *wave;           /* bitset of states found but not looked at */
+  int       more;           /* flag: the last wave found a state */
+  int       wi, ii;
 
-  /* Allocate the Boolean array in stack space (automatic) */
-  if((state_pushed = alloca(sizeof(int) * (this->num_states + 1))) == NULL)
-  {
-    fprintf(stderr, "tmTableBFS: out of memory\n");
-    fifoDestroy(fifo);
-    abort();
-    return -1;
-  }
+  if(this->reach_words < words) {
+    uint64_t *scratch;
 
-  /* Reset Booleans to false: no states pushed yet */
-  {
-    int si;
-    for(si=0; si <= this->num_states; si++) {
-      state_pushed[si] = 0;
+    if((scratch = realloc(this->reach_scratch, sizeof(uint64_t) * 2 * words))
+       ==NULL)
+    {
+      fprintf(stderr, "tmTableReach: out of memory\n");
+      return -1;
     }
+    this->reach_scratch = scratch;
+    this->reach_words   = words;
   }
+  found = this->reach_scratch;
+  wave  = this->reach_scratch + words;
+  memset(found, 0, sizeof(uint64_t) * 2 * words);
 
-  /* Push state 0 into fifo */
-  fifoAdd(fifo, (void*)1);
-  state_pushed[0] = 1;
-  count = 1;
-
-  while( (count <= this->num_states) && ((state=(int)fifoPop(fifo))!=0) )
-  {
-    /* For the FIFO, states are indexed starting at 1, so adjust */
-    state--;
+  found[0] = wave[0] = 1;
+  reach->states  = found;
+  reach->reached = 1;
+  reach->found   = 0;
 
-    for(ii=0; ii <= this->charset_max; ii++) {
-      if(test != NULL) {
-        if((test_value=test(&this->table[state][ii]))) {
-          fifoReset(fifo);
-          return test_value;
+  do {
+    more = 0;
+    for(wi = 0; wi < words; wi++) {
+      uint64_t bits = wave[wi];
+
+      wave[wi] = 0;
+      while(bits) {
+        const Entry *entry = this->table[wi * 64 + REACH_LOWEST(bits)];
+
+        bits &= bits - 1;
+        for(ii = 0; ii <= this->charset_max; ii++) {
+          const State    next = entry[ii].next;
+          const uint64_t bit  = (uint64_t) 1 << (next & 63);
+
+          reach->found |=   (1u << entry[ii].move)
+                          | ((1 == entry[ii].write) ? REACH_ONE : 0);
+          if(!(found[next >> 6] & bit)) {
+            found[next >> 6] |= bit;
+            wave[next >> 6]  |= bit;
+            reach->reached ++;
+            more = 1;
+          }
         }
-      }
-
-      /* If 'next' state has not been in the FIFO, push it in */
-      if(!state_pushed[this->table[state][ii].next]) {
-        /* Push next state of this entry into fifo.
-        // (For the FIFO, states are indexed starting at 1, so adjust)
-        */
-        fifoAdd(fifo, (void*)(this->table[state][ii].next + 1));
-        state_pushed[this->table[state][ii].next] = 1;
 
-        count ++;
+        if(   (reach->reached == this->num_states)
+           && (reach->found == REACH_ALL))
+        {
+          return 0;
+        }
       }
     }
-  }
-
-  /* Table feature was not reachable */
-  fifoReset(fifo);
-  if(test != NULL) {
-    return 0;
-  } else {
-    return count;
-  }
-}
-
-
-
-
-/* found* functions: test functions for tmTableBFS
-*/
-int
-foundStop(const Entry * const this)
-{
-  if(this->move == STOP) return 1;
-  return 0;
-}
-
-
-int
-foundOne(const Entry * const this)
-{
-  if(this->write == 1) return 1;
-  return 0;
-}
+  } while(more);
 
-
-int
-foundLeft(const Entry * const this)
-{
-  if(this->move == MOVE_LEFT) return 1;
-  return 0;
-}
-
-
-int
-foundRight(const Entry * const this)
-{
-  if(this->move == MOVE_RIGHT) return 1;
   return 0;
 }
 
@@ -1825,6 +3324,11 @@ foundRight(const Entry * const this)
 //   tmTableWeed: weed out useless (for busy beaver) Turing Machine tables
 //
 //
+// DESCRIPTION
+//   Every rule about the entries a machine can reach is answered by a
+//   single walk of the table; see tmTableReach().
+//
+//
 // RETURN VALUES
 //   Return 0 if this table is not rejected;
 //   Return nonzero if this table is rejected.
@@ -1832,6 +3336,8 @@ foundRight(const Entry * const this)
 int
 tmTableWeed(TuringMachineT *this)
 {
+  TableReachT reach;
+
   if(0 == this->table[0][0].next) {
     return 1;
   } else if(STOP == this->table[0][0].move) {
@@ -1839,19 +3345,22 @@ tmTableWeed(TuringMachineT *this)
   } else if(!tmTableContainsStop(this)) {
     /* No stops present in the table: never stops */
     return 3;
-  } else if(!tmTableBFS(this, foundStop)) {
+  } else if(tmTableReach(this, &reach) < 0) {
+    /* Can not tell: reject it, as the walk itself would have */
+    return 5;
+  } else if(!(reach.found & REACH_STOP)) {
     /* Stop not reachable: never stops */
     return 4;
-  } else if(tmTableBFS(this, NULL) < this->num_states) {
+  } else if(reach.reached < this->num_states) {
     /* Machine does not refer to all states */
     return 5;
-  } else if(!tmTableBFS(this, foundOne)) {
+  } else if(!(reach.found & REACH_ONE)) {
     /* No ones reachable: this machine can not be a useful busy beaver */
     return 6;
-  } else if(tmTableBFS(this, foundLeft) && !tmTableBFS(this, foundRight)) {
+  } else if(!(reach.found & REACH_RIGHT)) {
     /* Machine moves only to the left */
     return 7;
-  } else if(tmTableBFS(this, foundRight) && !tmTableBFS(this, foundLeft)) {
+  } else if(!(reach.found & REACH_LEFT)) {
     /* Machine moves only to the right */
     return 8;
   }
@@ -1861,32 +3370,77 @@ tmTableWeed(TuringMachineT *this)
 
 
 
-/* turing_machine: global reference to current Turing machine
-//   intended for use in interrupt handler
-*/
-static TuringMachineT *turing_machine;
-
-
-
-
 /* NAME
-//   handle_int: signal handler for busy beaver search
+//   tmTableCanonical: whether a table is the one of its kind the search runs
 //
 //
 // DESCRIPTION
-//   Searching for busy beavers takes a long time.  In order to be able
-//   to continue the search where it left off, it is useful to trap
-//   signals which would interrupt the process.  handle_int catches
-//   some signals and outputs enough information to continue the search
-//   for busy beavers where the search left off.
+//   Many tables run the same way as others, so a search need only run
+//   one table of each kind:
+//
+//   - The numbers of the states other than state 0 do not matter.  The
+//     table runs if its states are numbered in the order a breadth
+//     first walk of the table from state 0 finds them, looking at the
+//     entries of each state in order of input.
+//
+//   - A machine that moves left where another moves right, and right
+//     where it moves left, runs as its mirror image.  The table runs
+//     if the first entry the walk finds that moves, moves MOVE_FIRST.
+//
+//   - The entries of states the walk does not find are never used.
+//     The table runs if they are all the first entry in lexical order,
+//     i.e. write 0, move L, next 0.
+//
+//   An entry that stops has only one value (see tmTableNext), so its
+//   write and next do not matter.  As the states are numbered in the
+//   order they are found, no list of them is needed.
+//
+//
+// RETURN VALUES
+//   Return 1 if the search should run this table;
+//   Return 0 if it runs the same way as one the search runs.
+//
+//
+// SEE ALSO
+//   tmTableWeed(), tmBusyBeaverSearch()
 */
-void
-handle_int(int signum)
+int
+tmTableCanonical(const TuringMachineT *this)
 {
-  printf("\n");
-  tmTablePrint(turing_machine);
-  tmTableWrite(turing_machine, "interrupt.tm");
-  exit(1);
+  State si;
+  State found = 1;  /* states found so far: 0 to found-1 */
+  int   moved = 0;  /* flag: the walk found an entry that moves */
+  Char  ii;
+
+  for(si = 0; si < found; si++) {
+    for(ii = 0; ii <= this->charset_max; ii++) {
+      const Entry *entry = &this->table[si][ii];
+
+      if(STOP == entry->move) continue;
+
+      if(! moved) {
+        if(entry->move != MOVE_FIRST) return 0;
+        moved = 1;
+      }
+      if(entry->next > found) {
+        return 0;
+      } else if(entry->next == found) {
+        found ++;
+      }
+    }
+  }
+
+  for(si = found; si < this->num_states; si++) {
+    for(ii = 0; ii <= this->charset_max; ii++) {
+      const Entry *entry = &this->table[si][ii];
+
+      if((entry->write != 0) || (entry->move != MOVE_LEFT) || (entry->next != 0))
+      {
+        return 0;
+      }
+    }
+  }
+  return 1;
 }
 
 
@@ -1909,7 +3463,9 @@ handle_int(int signum)
   fflush(stdout); \
   if(table_count % PERIOD == 0) { \
     tmTableWrite(this, "periodic.tm"); \
-    printf("\ntable %014lli, %lli simulated\n", table_count, table_sim_count); \
+    printf("\ntable %s, %lli simulated, %lli symmetric\n", \
+           tmTableIndexFormat(table_count, index), \
+           (long long) table_sim_count, (long long) table_sym_count); \
     tmTablePrint(this); \
   } \
 }
@@ -1964,35 +3520,44 @@ handle_int(int signum)
 //
 //   Several simple methods are employed to attempt to determine ahead
 //   of time whether a machine will make a good busy beaver.  See
-//   tmTableWeed() for a list of these methods.  More sophisticated
-//   methods are certainly possible (such as symmetry under state-row
-//   swapping or simple loop checking), and could considerably reduce the
-//   effective search space.
+//   tmTableWeed() for a list of these methods.  A table that runs the
+//   same way as another, as its states are numbered differently or it
+//   is the mirror image of the other, is skipped as symmetric (see
+//   tmTableCanonical), and the number skipped is printed at the end.
+//   More sophisticated methods are certainly possible (such as simple
+//   loop checking), and could considerably reduce the effective search
+//   space.
 */
 int64_t
 tmBusyBeaverSearch(TuringMachineT *this, int64_t max_iters,
                    int64_t tape_len_max, int visual, int debug)
 {
   int weed;
-  int64_t table_count = -1;
+  TableIndex table_count;
+  char index[TABLE_INDEX_CHARS];
   int64_t table_sim_count = 0;
+  int64_t table_sym_count = 0;
   int64_t iters;
   int64_t ones_max = 0;
 
-  turing_machine = this;
-
-  signal(SIGINT, handle_int);
-  signal(SIGHUP, handle_int);
-
-  if(table_count < 0) {
-    table_count = tmTableIndex(this);
+  if(tmTableRank(this, &table_count) < 0) {
+    fprintf(stderr, "tmBusyBeaverSearch: too many tables to number\n");
+    return -1;
   }
 
   do {
-    while((weed=tmTableWeed(this))) {
-      tmTableNext(this);
+    if((weed=tmTableWeed(this))) {
+      PATIENCE;
+      table_count ++;
+      continue;
+    }
+
+    if(! tmTableCanonical(this)) {
+      /* The search runs another table that runs the same way */
+      table_sym_count ++;
       PATIENCE;
       table_count ++;
+      continue;
     }
 
     table_sim_count ++;
@@ -2009,7 +3574,8 @@ tmBusyBeaverSearch(TuringMachineT *this, int64_t max_iters,
       if(count >= (ones_max-1)) {
         char filename[128];
 
-        printf("\ntable %014lli ties, with %lli\n", table_count, ones_max);
+        printf("\ntable %s ties, with %lli\n",
+               tmTableIndexFormat(table_count, index), (long long) ones_max);
 
         ones_max = MAX(count, ones_max);
         printf("\n");
@@ -2021,7 +3587,7 @@ tmBusyBeaverSearch(TuringMachineT *this, int64_t max_iters,
         sprintf(filename, "max%04lli.tape", count);
         tmTapeWrite(this, filename);
 
-        printf("table %014lli\n", table_count);
+        printf("table %s\n", tmTableIndexFormat(table_count, index));
         printf("The machine executed %lli shifts\n", iters);
         printf("tape had %lli 1's\n", count);
         printf("tape was %lli frames long\n", this->tape_len);
@@ -2035,152 +3601,24 @@ tmBusyBeaverSearch(TuringMachineT *this, int64_t max_iters,
     } else if(-3 == iters) {
       printf("L");
       fflush(stdout);
+    } else if(-5 == iters) {
+      printf("c");
+      fflush(stdout);
     }
 
     /* Reset the Turing machine */
     this->state = 0;
-    tmTapeBlank(this);
+    if(tmTapeBlank(this) < 0) {
+      return -1;
+    }
 
     PATIENCE;
 
     table_count ++;
   } while(!tmTableNext(this)) ;
 
-  return 0;
-}
-
-
-
-
-int
-main(int argc, char **argv)
-{
-  int debug             = 0; /* flag: debug mode (i.e. single step mode) */
-  int visual            = 0; /* flag: visual mode. */
-  int verbose           = 0; /* flag: verbose mode */
-  int search            = 0; /* flag: search mode */
-
-  int64_t iters = 0;   /* number of shifts the Turing Machine has executed */
-
-  // max_iters: maximum number of iterations before the machine is stopped.
-  const int64_t max_iters     = INT64_MAX ;
-
-  const int64_t tape_len_max      = 409750;
-
-  TuringMachine tm              = tmNew();
-
-
-  /* Command line argument parsing variables.  See getopt() */
-  int oc;
-  int err_flag                  = 0;
-  extern char *optarg;
-  extern int optind, opterr, optopt;
-  char *machine_file            = NULL;
-  char *tape_file               = NULL;
-
-
-  /* Parse command line arguments */
-  while ((oc = getopt(argc, argv, "m:t:dsvV")) != -1) {
-    switch (oc) {
-      case 'm':
-        machine_file = optarg;
-      break;
-
-      case 't':
-        tape_file = optarg;
-      break;
-
-      case 'd':
-        debug = 1;
-        visual = 1;
-      break;
-
-      case 's':
-        search = 1;
-      break;
-
-      case 'v':
-        visual = 1;
-      break;
-
-      case 'V':
-        verbose = 1;
-      break;
-
-      case '?':
-        err_flag++;
-    }
-  }
-
-  if (err_flag) {
-    fprintf(stderr, "usage: %s -m machine_file -t tape_file [-d] [-v] [-V]\n",
-            argv[0]);
-    exit(2);
-  }
-
-  if(machine_file == NULL) {
-    fprintf(stderr, "%s: must specify machine_file\n", argv[0]);
-    exit(3);
-  }
-
-  if(tape_file == NULL) {
-    fprintf(stderr, "%s: tape_file not specified.  Assuming blank.\n", argv[0]);
-  }
-
-
-  if(verbose) {
-    /* max_iters is printed partly for information and partly to see
-    // whether a number as large as max_iters is properly being stored
-    // in the integer variable.
-    */
-    printf("maximum iterations = %lli\n", max_iters);
-  }
-
-  /* Read the Turing Machine state transition table */
-  if(tmTableRead(tm, machine_file) < 0) exit(1);
-
-  /* Read the Turing Machine tape */
-  if(tape_file != NULL) {
-    if(tmTapeRead(tm, tape_file) < 0) exit(2);
-  } else {
-    tmTapeBlank(tm);
-  }
-
-  if(verbose && !visual) {
-    tmTablePrint(tm);
-    tmTapePrint(tm);
-    printf("table is lexically %014lli\n", tmTableIndex(tm));
-  }
-
-  if(search) {
-    iters = tmBusyBeaverSearch(tm, max_iters, tape_len_max, visual, debug);
-
-  } else if(visual) {
-    iters = tmVisualSimulate(tm, max_iters, tape_len_max, debug);
-
-  } else {
-    /* Execute Turing Machine without "visual mode" display */
-    iters = tmSimulate(tm, max_iters, tape_len_max);
-  }
-
-  if(verbose) {
-    /* Print some information about the how the simulation went */
-
-    tmTapeWrite(tm, "out.tape");
-    printf("tape was %lli frames long\n", tm->tape_len);
-
-    if(iters >= 0) {
-      int64_t count = tmTapeOneCount(tm);
-
-      tmTapePrint(tm);
-      printf("The machine executed %lli shifts\n", iters);
-      printf("tape had %lli 1's\n", count);
-    } else if(-1 == iters) {
-      printf("too many iterations\n");
-    } else if(-2 == iters) {
-      printf("tape too long\n");
-    }
-  }
+  printf("\n%lli tables simulated, %lli skipped as symmetric\n",
+         (long long) table_sim_count, (long long) table_sym_count);
 
   return 0;
 }
@@ -5,28 +5,156 @@
 // Provided as is.  No warrentees, express or implied.
 */
 
+#ifndef _TM_H__INCLUDED_
+#define _TM_H__INCLUDED_
 
+#include <stdint.h>
 
 
-/* Using "int" for Char seems to run faster, but takes more memory
-// than "short" or "signed char".
+
+
+/* MIN, MAX: return smaller, larger of the two input numbers */
+#ifndef MIN
+#define MIN(a,b) (((a)<(b))?(a):(b))
+#endif
+#ifndef MAX
+#define MAX(a,b) (((a)>(b))?(a):(b))
+#endif
+
+
+
+
+/* Char holds any tape symbol, up to CHARSET_MAX.  The tape itself
+// stores frames in as few bits as the machine's charset_max allows; see
+// tape_width.
 */
-typedef signed char Char;
+typedef int16_t Char;
 typedef enum {MOVE_LEFT, MOVE_RIGHT, STOP} Move;
+
+/* MOVE_FIRST: which way the first move goes, of a machine and its
+// mirror image, in the one a busy beaver search runs.  tmTableCanonical()
+// and the search in Tree Normal Form (see tnf.c) both keep to it, so
+// the machines they report can be compared.
+*/
+#define MOVE_FIRST MOVE_LEFT
 typedef int State;
 
+/* Event: why tmRun() returned; see tmRun() */
+typedef enum {EVENT_STOP, EVENT_BUDGET, EVENT_EDGE, EVENT_BREAK, EVENT_ERROR}
+  Event;
+
+#define CHARSET_MAX INT16_MAX
+
+/* TableIndex: lexical index of a state transition table; see
+// tmTableRank().  128 bits number every table of up to 11 states and 2
+// characters, 7 and 3, or 5 and 4, where 64 bits stop at 6 states and 2
+// characters.
+*/
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 TableIndex;
+#else
+typedef uint64_t TableIndex;
+#endif
+
+#define TABLE_INDEX_MAX ((TableIndex) -1)
 
+/* TABLE_INDEX_CHARS: room for a TableIndex in decimal, and its NUL */
+#define TABLE_INDEX_CHARS 41
 
+/* CycleT: cycle detector; see cycle.h */
+typedef struct CycleS CycleT;
 
+/* MapT: memory-mapped tape file; see map.h */
+typedef struct MapS MapT;
+
+/* MultiT: table and tapes of a multi-tape machine; see multi.h */
+typedef struct MultiS MultiT;
+
+
+
+
+/* Entry: one state transition, packed into 8 bytes */
 typedef struct {
-  Char write;  /* character to write at this place on tape */
-  Move move;   /* which way to move tape head */
-  State next;  /* which state to enter next */
+  Char write;   /* character to write at this place on tape */
+  int8_t move;  /* which way to move tape head: a Move */
+  State next;   /* which state to enter next */
 } Entry;
 
 
 
 
+/* REACH_*: kinds of table entry; see TableReachT */
+#define REACH_LEFT  (1u << MOVE_LEFT)
+#define REACH_RIGHT (1u << MOVE_RIGHT)
+#define REACH_STOP  (1u << STOP)
+#define REACH_ONE   (1u << 3)
+#define REACH_ALL   (REACH_LEFT | REACH_RIGHT | REACH_STOP | REACH_ONE)
+
+
+
+
+/* TableReachT: what a walk of a table from state 0 reached; see
+// tmTableReach()
+*/
+typedef struct {
+  const uint64_t *states;  /* bitset of the states reached, 64 a word */
+  State           reached; /* number of states reached */
+  unsigned        found;   /* REACH_* kinds among their entries */
+} TableReachT;
+
+
+
+
+/* Op: compiled table entry, packed into a single 32-bit word
+//
+//   bits  0.. 7: character to write
+//   bits  8.. 9: head delta, 2-bit two's complement (-1, +1, or 0 for STOP)
+//   bits 10..31: offset of the next state's row in the compiled program,
+//                i.e. next * (charset_max + 1)
+//
+// See tmTableCompile().
+*/
+typedef uint32_t Op;
+
+#define OP_ROW_MAX    ((1 << 22) - 1)
+
+#define OP_PACK(write, delta, row) \
+  (  ((Op)(unsigned char)(write)) \
+   | (((Op)(delta) & 3) << 8) \
+   | ((Op)(row) << 10))
+
+#define OP_WRITE(op)  ((Char)((op) & 0xff))
+#define OP_DELTA(op)  (((int32_t)((op) << 22)) >> 30)
+#define OP_ROW(op)    ((op) >> 10)
+
+/* OP_CHARSET_MAX: largest charset_max whose symbols fit in an Op */
+#define OP_CHARSET_MAX 127
+
+
+
+
+/* OpWide: compiled table entry for machines with 16-bit symbols
+//
+//   bits  0..15: character to write
+//   bits 16..17: head delta, as in Op
+//   bits 18..63: offset of the next state's row in the compiled program
+//
+// See tmTableCompileWide().
+*/
+typedef uint64_t OpWide;
+
+#define OPW_PACK(write, delta, row) \
+  (  ((OpWide)(uint16_t)(write)) \
+   | (((OpWide)(delta) & 3) << 16) \
+   | ((OpWide)(row) << 18))
+
+#define OPW_WRITE(op) ((Char)((op) & 0xffff))
+#define OPW_DELTA(op) (((int32_t)((uint32_t)(op) << 14)) >> 30)
+#define OPW_ROW(op)   ((op) >> 18)
+
+
+
+
 typedef struct {
   Char charset_max; /* Largest allowable character in the charset.
                     // The charset is the list of valid inputs and
@@ -50,12 +178,192 @@ typedef struct {
 
   int32_t num_states;  /* number of states of this machine */
 
+  Op *program;      /* Compiled execution form of the table:
+                    // one contiguous array indexed as
+                    //   program[state * (charset_max+1) + input]
+                    // Built from table by tmTableCompile(), and must be
+                    // rebuilt whenever table changes.
+                    */
+
+  OpWide *program_wide; /* Compiled execution form of the table, for
+                        // machines with 16-bit symbols: indexed like
+                        // program.  Built by tmTableCompileWide().
+                        */
+
   int64_t here;        /* current tape head position */
 
-  int64_t tape_len;    /* Length of tape accessed so far */
+  int64_t tape_len;    /* Length of tape accessed so far:
+                       //   right_end - left_end + 1
+                       */
+
+  int64_t left_end;    /* leftmost head position accessed so far */
+
+  int64_t right_end;   /* rightmost head position accessed so far */
+
+  int64_t tape_origin; /* index into tape[] of head position 0 */
+
+  int64_t tape_alloc;  /* number of elements allocated for tape[] */
+
+  int tape_width;    /* Bits per tape frame, chosen by tmTableRead()
+                    // from charset_max:
+                    //    1: tape_words, when charset_max is 1
+                    //    8: tape, when charset_max is at most 127
+                    //   16: tape_wide, otherwise
+                    // Each width has its own simulation kernel; see
+                    // tmSimulate().
+                    */
+
+  int8_t *tape;     /* data tape, when tape_width is 8:
+                    // head position "here" is stored at
+                    //   tape[here + tape_origin]
+                    // Every element outside of [left_end, right_end]
+                    // is blank (0).
+                    */
+
+  Char *tape_wide;  /* data tape, when tape_width is 16:
+                    // stored like tape
+                    */
+
+  uint64_t *tape_words; /* data tape, when tape_width is 1:
+                        // head position "here" is stored at bit
+                        //   (here + tape_origin) % 64
+                        // of
+                        //   tape_words[(here + tape_origin) / 64]
+                        */
+
+  int tape_paged;   /* flag: store the tape in tape_pages instead of
+                    // tape, tape_wide or tape_words.  Must be set
+                    // before the tape is first allocated.
+                    */
+
+  Char **tape_pages; /* data tape, when tape_paged is set: head position
+                     // "here" is stored at
+                     //   tape_pages[ti / PAGE_FRAMES][ti % PAGE_FRAMES]
+                     // where ti = here + tape_origin.  Pages never
+                     // written to share one blank page, and forked
+                     // machines share pages until they write to them.
+                     // See page.h.
+                     */
+
+  int64_t tape_pages_resident; /* number of pages with their own memory */
+
+  MapT *tape_map;   /* When not NULL, tape, tape_wide or tape_words is
+                    // memory-mapped from a file, which mapReserve()
+                    // grows in place of tmTapeReserve().  See map.h.
+                    */
+
+  int64_t *symbol_count; /* Number of tape frames holding each symbol:
+                         // symbol_count[c] for c from 1 to charset_max,
+                         // kept up to date by every write to the tape.
+                         // symbol_count[0] is scratch; the number of
+                         // blank frames comes from tmTapeSymbolCount().
+                         */
+
+  State break_state; /* tmRun() returns after a shift into this state,
+                     // or -1 for no breakpoint
+                     */
+
+  int blank_test;   /* flag: give up on a machine that returns to state 0
+                    // on a blank tape within its first few shifts,
+                    // as a busy beaver search does.  See tmIterTest().
+                    */
 
-  Char *tape;       /* data tape */
+  CycleT *cycle;    /* When not NULL, tmSimulate() gives up on a machine
+                    // that repeats a configuration, possibly shifted
+                    // along the tape.  See cycleSimulateSteps().
+                    */
+
+  MultiT *multi;    /* When not NULL, the machine has more than one tape,
+                    // and its table is held here instead of in table.
+                    // Set by tmTableRead().  See multi.h.
+                    */
+
+  uint64_t *reach_scratch; /* Scratch space for tmTableReach(): two
+                           // bitsets of reach_words words each
+                           */
+
+  int32_t reach_words;     /* words in each bitset of reach_scratch */
 } TuringMachineT;
 
 
 typedef TuringMachineT* TuringMachine;
+
+
+
+
+/* POPCOUNT64: number of bits set in a 64-bit word */
+#ifdef __GNUC__
+#define POPCOUNT64(w) __builtin_popcountll(w)
+#else
+#define POPCOUNT64(w) tmPopCount64(w)
+int      tmPopCount64(uint64_t w);
+#endif
+
+
+
+
+/* Turing Machine methods shared with the simulation engines (tm.c) */
+int      tmTableCompile(TuringMachineT *this);
+int      tmTableCompileWide(TuringMachineT *this);
+int      tmTapeAlloc(TuringMachineT *this);
+int      tmTapeReserve(TuringMachineT *this, int64_t left, int64_t right);
+int64_t  tmTapeOneCount(const TuringMachineT *this);
+int      tmTapeAllBlank(const TuringMachineT *this);
+int64_t  tmTapeSymbolCount(const TuringMachineT *this, Char symbol);
+int64_t  tmIterTest(const TuringMachineT *this);
+int      tmUpdate(TuringMachineT *this);
+int      tmTapeFrameSet(TuringMachineT *this, Char value);
+Char     tmTapeFrameAt(const TuringMachineT *this, int64_t here);
+int64_t  tmRun(TuringMachineT *this, int64_t budget, Event *event);
+int64_t  tmSimulate(TuringMachineT *this, int64_t max_iters,
+                    int64_t tape_len_max);
+int      tmSimulateSteps(TuringMachineT *this, int64_t *iters, int64_t until,
+                         int64_t max_iters, int64_t tape_len_max,
+                         int64_t iter_test);
+int      tmEnginePrologue(TuringMachineT *this, int64_t *iters,
+                          int64_t max_iters, int64_t tape_len_max);
+
+
+
+
+/* Turing Machine methods for programs that use the library (tm.c)
+//
+// Everything a simulation needs is held in its TuringMachineT, and
+// failures are returned rather than ending the process, so any number
+// of machines can be simulated at once, one per thread.  The visual
+// mode (tmVisualSimulate, tmTableCurse) draws on the one curses screen
+// of the process.
+*/
+TuringMachineT * tmNew(void);
+void     tmDestroy(TuringMachineT *this);
+TuringMachineT * tmFork(TuringMachineT *this);
+int64_t  tmTableRead(TuringMachineT *this, char *filename);
+int      tmTableWrite(const TuringMachineT * const this,
+                      const char * const filename);
+int64_t  tmTableIndex(const TuringMachineT *this);
+int      tmTableRank(const TuringMachineT *this, TableIndex *index);
+int      tmTableUnrank(TuringMachineT *this, TableIndex index);
+int      tmTableSpace(const TuringMachineT *this, TableIndex *tables);
+char *   tmTableIndexFormat(TableIndex index, char *string);
+int      tmTableIndexParse(const char *string, TableIndex *index);
+int      tmTableNext(TuringMachineT *this);
+int      tmTableWeed(TuringMachineT *this);
+int      tmTableCanonical(const TuringMachineT *this);
+int      tmTableReach(TuringMachineT *this, TableReachT *reach);
+void     tmTableCurse(const TuringMachineT *this, const int wy, const int wx);
+int64_t  tmTapeRead(TuringMachineT *this, char *filename);
+int      tmTapeWrite(TuringMachineT *this, const char *filename);
+int      tmTapeBlank(TuringMachineT *this);
+void     tmTapeFree(TuringMachineT *this);
+void     tmTapePrint(TuringMachineT *this);
+int64_t  tmVisualSimulate(TuringMachineT *this, int64_t max_iters,
+                          int64_t tape_len_max, int debug);
+int64_t  tmBusyBeaverSearch(TuringMachineT *this, int64_t max_iters,
+                            int64_t tape_len_max, int visual, int debug);
+
+/* tmTablePrint: print Turing Machine state transition table */
+#define tmTablePrint(this) tmTableCurse(this, -1, -1)
+
+
+
+#endif
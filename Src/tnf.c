@@ -0,0 +1,283 @@
+/* tnf.c: busy beaver search over machines in Tree Normal Form
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "tnf.h"
+
+
+
+
+/* NAME
+//   tnfUndefine: make every entry of a table undefined
+//
+//
+// SEE ALSO
+//   TnfT
+*/
+static void
+tnfUndefine(TuringMachineT *this)
+{
+  State si;
+  Char  ii;
+
+  for(si = 0; si < this->num_states; si++) {
+    for(ii = 0; ii <= this->charset_max; ii++) {
+      this->table[si][ii].write = ii;
+      this->table[si][ii].move  = STOP;
+      this->table[si][ii].next  = si;
+    }
+  }
+}
+
+
+
+
+/* NAME
+//   tnfReport: report a machine that stopped, as tmBusyBeaverSearch() does
+//
+//
+// DESCRIPTION
+//   The entries the machine never used are written as entries that
+//   stop, as tmTableNext() makes them, so that the table has the
+//   lexical index of the first table the lexical search would find it
+//   in.
+*/
+static void
+tnfReport(TnfT *this, TuringMachineT *tm, int64_t iters)
+{
+  const int64_t count = tmTapeOneCount(tm);
+  State         si;
+  Char          ii;
+
+  this->stopped ++;
+  this->shifts_max = MAX(this->shifts_max, iters);
+
+  if(count >= (this->ones_max - 1)) {
+    TableIndex ti;
+    char       index[TABLE_INDEX_CHARS] = "-";
+    char       filename[128];
+
+    for(si = 0; si < tm->num_states; si++) {
+      for(ii = 0; ii <= tm->charset_max; ii++) {
+        if(STOP == tm->table[si][ii].move) {
+          tm->table[si][ii].write = 1;
+          tm->table[si][ii].next  = tm->num_states - 1;
+        }
+      }
+    }
+    if(tmTableRank(tm, &ti) == 0) tmTableIndexFormat(ti, index);
+
+    printf("\ntable %s ties, with %lli\n", index, (long long) this->ones_max);
+
+    this->ones_max = MAX(count, this->ones_max);
+    printf("\n");
+    tmTablePrint(tm);
+
+    sprintf(filename, "max%04lli.tm", (long long) count);
+    tmTableWrite(tm, filename);
+
+    sprintf(filename, "max%04lli.tape", (long long) count);
+    tmTapeWrite(tm, filename);
+
+    printf("table %s\n", index);
+    printf("The machine executed %lli shifts\n", (long long) iters);
+    printf("tape had %lli 1's\n", (long long) count);
+    printf("tape was %lli frames long\n", (long long) tm->tape_len);
+  }
+}
+
+
+
+
+/* NAME
+//   tnfExpand: search the subtree of machines under a partial machine
+//
+//
+// ARGUMENTS
+//   this (in/out): the search
+//
+//   tm (in/out): machine partway through its run, with 'defined'
+//   entries defined and states 0 to used-1 used
+//
+//   iters (in): shifts the machine has run
+//
+//
+// DESCRIPTION
+//   Runs the machine until it reaches an entry it has not defined.  Each
+//   way to define that entry gives a subtree, searched on a fork of the
+//   machine (see tmFork), which carries on from that point rather than
+//   from the start of the tape.  The machines of a subtree that does
+//   not reach an undefined entry all run the same way; what became of
+//   them is printed as tmBusyBeaverSearch() prints it for one machine.
+//
+//   The ways to define the entry are any character to write, either
+//   move, and any state used so far or the first one not yet used, so
+//   that machines which differ only by the numbering of their states
+//   are only searched once.  The entry can also stop the machine, but
+//   only if another entry is left undefined, as otherwise no entry
+//   would stop it.
+//
+//   The first entry, which the machine reaches at once, only moves
+//   MOVE_FIRST, as every machine that first moves the other way is the
+//   mirror image of one that does not, and only goes to state 1, as
+//   tmTableWeed() has it.
+*/
+static void
+tnfExpand(TnfT *this, TuringMachineT *tm, int64_t iters, State used,
+          int defined)
+{
+  const int entries = tm->num_states * (tm->charset_max + 1);
+  int64_t   shifts;
+  State     si, next;
+  Char      ii;
+  int       write, move;
+
+  tm->cycle = this->cycle;
+  shifts = tmSimulate(tm, this->max_iters - iters, this->tape_len_max);
+  tm->cycle = NULL;
+
+  this->machines ++;
+  if(0 == this->machines % TNF_PERIOD) {
+    printf("\n%lli machines, %lli stopped\n",
+           (long long) this->machines, (long long) this->stopped);
+    fflush(stdout);
+  }
+
+  /* A machine given up on never reaches an undefined entry, so neither
+  // does any machine of its subtree.  For -3 this holds as the tape is
+  // all blank (see tmTapeAllBlank): the machine is back where it
+  // started, and would only do the same again.
+  */
+  if(-4 == shifts) {
+    this->error = 1;
+    return;
+  } else if(shifts < 0) {
+    putchar(  (-1 == shifts) ? 'i' : (-2 == shifts) ? 't'
+            : (-3 == shifts) ? 'L' : 'c');
+    return;
+  }
+
+  /* The undefined entry stopped the machine just before it.  It did
+  // not really shift.
+  */
+  iters += shifts - 1;
+  si = tm->state;
+  ii = tmTapeFrameAt(tm, tm->here);
+
+  if(defined + 1 < entries) {
+    for(next = (0 == defined); next <= MIN(used, tm->num_states - 1); next++) {
+      for(move = MOVE_LEFT; move <= MOVE_RIGHT; move++) {
+        if((0 == defined) && (move != MOVE_FIRST)) continue;
+
+        for(write = 0; write <= tm->charset_max; write++) {
+          TuringMachineT *fork;
+
+          if(this->error) return;
+          if((fork = tmFork(tm))==NULL) {
+            this->error = 1;
+            return;
+          }
+          fork->table[si][ii].write = write;
+          fork->table[si][ii].move  = move;
+          fork->table[si][ii].next  = next;
+          tnfExpand(this, fork, iters, MAX(used, next + 1), defined + 1);
+          tmDestroy(fork);
+        }
+      }
+    }
+  }
+
+  /* The machine that stops at once is of no interest */
+  if(0 == defined) return;
+
+  /* Last, the entry stops the machine, which no subtree needs now */
+  tm->table[si][ii].write = 1;
+  tm->table[si][ii].move  = STOP;
+  tm->table[si][ii].next  = tm->num_states - 1;
+  if(tmUpdate(tm) < 0) {
+    this->error = 1;
+    return;
+  }
+  tnfReport(this, tm, iters + 1);
+}
+
+
+
+
+/* NAME
+//   tmBusyBeaverSearchTNF: search for a busy beaver in Tree Normal Form
+//
+//
+// ARGUMENTS
+//   this (in/out): Turing machine, giving the number of states and
+//   characters, and the tape to start on
+//
+//   max_iters (in): maximum number of iterations for each machine
+//
+//   tape_len_max (in): maximum tape length for each machine
+//
+//
+// DESCRIPTION
+//   tmBusyBeaverSearch() goes through every table in lexical order, and
+//   tmTableWeed() throws most of them away.  Most of the rest differ
+//   only in entries the machine never uses, or in how the states are
+//   numbered, so the same machine is simulated many times over.
+//
+//   tmBusyBeaverSearchTNF() instead starts from a machine with every
+//   entry undefined, and defines each entry when the machine first
+//   reaches it (see tnfExpand).  Each machine is simulated once, up to
+//   the numbering of its states and a mirror image, and partly shared
+//   with every machine that runs the same way up to where they differ.
+//   This is Tree Normal Form.  It cuts the tables for 5 states and 2
+//   characters from 21^10 to about 10^8.
+//
+//   Machines are reported as tmBusyBeaverSearch() reports them, with
+//   the lexical index of the table.  this->cycle, if set, is used for
+//   every machine.  The table of 'this' is left undefined.
+//
+//
+// RETURN VALUE
+//   Returns -1 if memory could not be had, in which case the search
+//   stopped part of the way through.  Returns 0 otherwise.
+//
+//
+// SEE ALSO
+//   tmBusyBeaverSearch(), tmFork()
+*/
+int64_t
+tmBusyBeaverSearchTNF(TuringMachineT *this, int64_t max_iters,
+                      int64_t tape_len_max)
+{
+  TnfT search;
+
+  memset(&search, 0, sizeof(search));
+  search.max_iters    = max_iters;
+  search.tape_len_max = tape_len_max;
+  search.cycle        = this->cycle;
+
+  tnfUndefine(this);
+  tnfExpand(&search, this, 0, 1, 0);
+  this->cycle = search.cycle;
+
+  printf("\n%lli machines in Tree Normal Form simulated, %lli stopped,"
+         " most shifts %lli\n",
+         (long long) search.machines, (long long) search.stopped,
+         (long long) search.shifts_max);
+  fflush(stdout);
+
+  if(search.error) {
+    fprintf(stderr, "tmBusyBeaverSearchTNF: out of memory\n");
+    return -1;
+  }
+  return 0;
+}
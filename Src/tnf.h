@@ -0,0 +1,48 @@
+/* tnf.h: busy beaver search over machines in Tree Normal Form
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _TNF_H__INCLUDED_
+#define _TNF_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* TNF_PERIOD: how many machines between reports of how the search goes */
+#define TNF_PERIOD (1 << 20)
+
+
+
+
+/* TnfT: a search over the tree of machines in Tree Normal Form
+//
+// A table entry the machines of a subtree have not used yet is
+// undefined.  It is held as an entry that stops without changing
+// anything, i.e. write = input, next = state, move = STOP, so that a
+// machine which reaches it is left as it was just before the entry.
+*/
+typedef struct {
+  int64_t  max_iters;
+  int64_t  tape_len_max;
+  CycleT  *cycle;       /* cycle detector for every machine, or NULL */
+  int64_t  ones_max;    /* most 1's left by a machine so far */
+  int64_t  shifts_max;  /* most shifts by a machine that stopped */
+  int64_t  machines;    /* number of machines simulated */
+  int64_t  stopped;     /* number of machines that stopped */
+  int      error;       /* flag: memory could not be had */
+} TnfT;
+
+
+
+
+int64_t  tmBusyBeaverSearchTNF(TuringMachineT *this, int64_t max_iters,
+                               int64_t tape_len_max);
+
+
+
+#endif
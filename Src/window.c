@@ -0,0 +1,371 @@
+/* window.c: Turing Machine simulation with window-exit tables
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+
+
+#include "tm.h"
+#include "window.h"
+
+
+
+
+/* WINDOW_STEPS_MAX: most shifts simulated for a single window lookup
+//
+// A machine can run forever without leaving a window.  Such a lookup
+// stops after WINDOW_STEPS_MAX shifts with the head still inside the
+// window, which is a perfectly good (and cacheable) result.
+*/
+#define WINDOW_STEPS_MAX 65536
+
+
+
+
+/* NAME
+//   windowNew: allocate a new window-exit table
+//
+//
+// ARGUMENTS
+//   width (in): window width, in tape frames, from 1 to WINDOW_WIDTH_MAX
+//
+//   cache_bits (in): log2 of the number of window exits kept
+//
+//
+// RETURN VALUE
+//   Returns NULL if the arguments are bad or memory could not be
+//   allocated.
+*/
+WindowT *
+windowNew(int width, int cache_bits)
+{
+  WindowT *this;
+
+  if((width < 1) || (width > WINDOW_WIDTH_MAX)) {
+    fprintf(stderr, "windowNew: width must be from 1 to %i\n",
+            WINDOW_WIDTH_MAX);
+    return NULL;
+  }
+  if((cache_bits < 1) || (cache_bits > 30)) {
+    fprintf(stderr, "windowNew: cache_bits must be from 1 to 30\n");
+    return NULL;
+  }
+
+  if((this = calloc(1, sizeof(WindowT))) == NULL) {
+    fprintf(stderr, "windowNew: out of memory\n");
+    return NULL;
+  }
+
+  if((this->cache = calloc((size_t)1 << cache_bits, sizeof(WindowExitT)))
+     == NULL)
+  {
+    fprintf(stderr, "windowNew: out of memory\n");
+    free(this);
+    return NULL;
+  }
+
+  this->width      = width;
+  this->cache_bits = cache_bits;
+  this->lookups    = 0;
+  this->hits       = 0;
+
+  return this;
+}
+
+
+
+
+/* NAME
+//   windowReset: forget all window exits
+//
+//
+// DESCRIPTION
+//   Window exits depend on the state transition table, so the cache
+//   must be reset whenever the table changes.
+*/
+void
+windowReset(WindowT *this)
+{
+  memset(this->cache, 0, sizeof(WindowExitT) << this->cache_bits);
+  this->lookups = 0;
+  this->hits    = 0;
+}
+
+
+
+
+void
+windowDestroy(WindowT *this)
+{
+  if(this != NULL) {
+    free(this->cache);
+    free(this);
+  }
+}
+
+
+
+
+void
+windowPrint(const WindowT *this)
+{
+  printf("window: %i frames, %lli lookups, %lli hits (%.1f%%)\n",
+         this->width, (long long) this->lookups, (long long) this->hits,
+         this->lookups ? (100.0 * this->hits / this->lookups) : 0.0);
+}
+
+
+
+
+/* NAME
+//   windowLoad: read 'width' tape frames starting at head position 'left'
+//
+//
+// DESCRIPTION
+//   Frame left+i goes into bit i of the result.  The tape must be
+//   bit-packed, and tape memory must exist for the whole window plus
+//   one word (see tmTapeReserve).
+*/
+static uint64_t
+windowLoad(const TuringMachineT *tm, int64_t left, int width)
+{
+  const int64_t   ti    = left + tm->tape_origin;
+  const uint64_t *words = &tm->tape_words[ti >> 6];
+  const int       shift = ti & 63;
+  uint64_t        window;
+
+  window = words[0] >> shift;
+  if(shift && (shift + width > 64)) {
+    window |= words[1] << (64 - shift);
+  }
+  if(width < 64) {
+    window &= ((uint64_t)1 << width) - 1;
+  }
+  return window;
+}
+
+
+
+
+/* NAME
+//   windowStore: write 'width' tape frames starting at head position 'left'
+//
+//
+// DESCRIPTION
+//   The count of 1's on the tape follows the write, as it does for
+//   tmTapeFrameSet().
+//
+//
+// SEE ALSO
+//   windowLoad
+*/
+static void
+windowStore(TuringMachineT *tm, int64_t left, int width, uint64_t window)
+{
+  const int64_t   ti    = left + tm->tape_origin;
+  uint64_t       *words = &tm->tape_words[ti >> 6];
+  const int       shift = ti & 63;
+  const uint64_t  mask  = (width < 64) ? (((uint64_t)1 << width) - 1)
+                                       : ~(uint64_t)0;
+
+  tm->symbol_count[1] +=   POPCOUNT64(window)
+                         - POPCOUNT64(windowLoad(tm, left, width));
+
+  words[0] = (words[0] & ~(mask << shift)) | (window << shift);
+  if(shift && (shift + width > 64)) {
+    words[1] =   (words[1] & ~(mask >> (64 - shift)))
+               | (window >> (64 - shift));
+  }
+}
+
+
+
+
+/* NAME
+//   windowExit: find what the machine does to a window
+//
+//
+// DESCRIPTION
+//   Look up (state, window, offset) in the cache.  If it is not there,
+//   simulate the machine on the window alone until the head leaves the
+//   window, the machine stops, or WINDOW_STEPS_MAX shifts pass, and
+//   store the result in the cache.
+//
+//   The table must be compiled.
+*/
+static const WindowExitT *
+windowExit(WindowT *this, const TuringMachineT *tm, uint64_t window,
+           int offset)
+{
+  const int64_t  line_length = tm->charset_max + 1;
+  const uint64_t key   = (uint64_t)tm->state * WINDOW_WIDTH_MAX + offset;
+  const uint64_t hash  =   ((window ^ (key * 0x9e3779b97f4a7c15ULL))
+                            * 0xbf58476d1ce4e5b9ULL)
+                         >> (64 - this->cache_bits);
+  WindowExitT   *entry = &this->cache[hash];
+
+  this->lookups ++;
+
+  if(   entry->steps && (entry->window == window)
+     && (entry->state == tm->state) && (entry->offset == offset))
+  {
+    this->hits ++;
+    return entry;
+  }
+
+  /* Simulate the machine on this window alone */
+  {
+    const Op *rowp  = tm->program + tm->state * line_length;
+    int64_t   steps = 0;
+    int       here  = offset;
+    int       lo    = offset;
+    int       hi    = offset;
+    int       stop  = 0;
+    uint64_t  bits  = window;
+
+    do {
+      const Op      op    = rowp[(bits >> here) & 1];
+      const int32_t delta = OP_DELTA(op);
+
+      bits ^= (((bits >> here) ^ OP_WRITE(op)) & 1) << here;
+      rowp  = tm->program + OP_ROW(op);
+      steps ++;
+
+      if(0 == delta) {
+        stop = 1;
+        break;
+      }
+      here += delta;
+      lo = MIN(lo, here);
+      hi = MAX(hi, here);
+    } while((here >= 0) && (here < this->width)
+            && (steps < WINDOW_STEPS_MAX));
+
+    entry->window = window;
+    entry->state  = tm->state;
+    entry->offset = offset;
+    entry->result = bits;
+    entry->steps  = steps;
+    entry->next   = (rowp - tm->program) / line_length;
+    entry->exit   = here;
+    entry->lo     = lo;
+    entry->hi     = hi;
+    entry->stop   = stop;
+  }
+
+  return entry;
+}
+
+
+
+
+/* NAME
+//   tmWindowSimulate: perform a Turing Machine simulation using window exits
+//
+//
+// DESCRIPTION
+//   Most of the time a busy beaver shuffles back and forth within a few
+//   dozen frames of its head.  tmWindowSimulate loads the 'width'
+//   frames around the head into a register, and looks up (state,
+//   window contents, head offset) in a lazily filled table of window
+//   exits (see windowExit).  One lookup jumps straight to the state and
+//   window contents at the moment the head leaves the window, however
+//   many shifts that took.  The window is then stored back onto the
+//   tape and re-centered on the head.
+//
+//   When a window exit would run past max_iters or tape_len_max, the
+//   rest of the simulation is done one shift at a time, so that shift
+//   counts, final tapes and return values are identical to those of
+//   tmSimulate().
+//
+//   Only machines with a bit-packed tape (charset_max 1) have window
+//   tables.  Other machines are simply run by tmSimulate().
+//
+//   The window-exit table depends on the state transition table, so
+//   'window' must be reset (windowReset) if the table changes.
+//
+//
+// RETURN VALUE
+//   Same as tmSimulate().
+//
+//
+// SEE ALSO
+//   tmSimulate(), windowExit()
+*/
+int64_t
+tmWindowSimulate(TuringMachineT *this, WindowT *window, int64_t max_iters,
+                 int64_t tape_len_max)
+{
+  const int width  = window->width;
+  int64_t   iters  = 0;
+  int       status = 0;
+
+  if((this->tape_width != 1) || this->tape_paged) {
+    return tmSimulate(this, max_iters, tape_len_max);
+  }
+
+  status = tmEnginePrologue(this, &iters, max_iters, tape_len_max);
+
+  while((0 == status) && (iters < max_iters)
+        && (this->tape_len < tape_len_max))
+  {
+    const int64_t      left = this->here - width / 2;
+    const WindowExitT *exit;
+    int64_t            left_end;
+    int64_t            right_end;
+
+    /* Memory for the window and for the frames just outside of it */
+    if(tmTapeReserve(this, left - 1, left + width) < 0) {
+      status = -4;
+      break;
+    }
+
+    exit = windowExit(window, this, windowLoad(this, left, width),
+                      this->here - left);
+
+    left_end  = MIN(this->left_end,  left + exit->lo);
+    right_end = MAX(this->right_end, left + exit->hi);
+
+    if(   (iters + exit->steps > max_iters)
+       || (right_end - left_end + 1 >= tape_len_max))
+    {
+      /* The machine reaches a limit within this window */
+      status = tmSimulateSteps(this, &iters, max_iters, max_iters,
+                               tape_len_max, 0);
+      break;
+    }
+
+    windowStore(this, left, width, exit->result);
+
+    this->here      = left + exit->exit;
+    this->state     = exit->next;
+    this->left_end  = left_end;
+    this->right_end = right_end;
+    this->tape_len  = right_end - left_end + 1;
+    iters += exit->steps;
+
+    if(exit->stop) {
+      status = 1;
+    }
+  }
+
+  if(status < 0) {
+    return status;
+  }
+
+  if(status > 0) {
+    return iters;
+  }
+
+  if(this->tape_len >= tape_len_max) {
+    return -2;
+  }
+
+  return -1;
+}
@@ -0,0 +1,65 @@
+/* window.h: Turing Machine simulation with window-exit tables
+//
+// Provided as is.  No warrentees, express or implied.
+*/
+
+#ifndef _WINDOW_H__INCLUDED_
+#define _WINDOW_H__INCLUDED_
+
+#include <stdint.h>
+
+#include "tm.h"
+
+
+
+
+/* WINDOW_WIDTH_MAX: widest window, in tape frames, that fits a register */
+#define WINDOW_WIDTH_MAX 64
+
+
+
+
+/* WindowExitT: what happens to a window from a given starting point
+//
+// The key is (state, window, offset).  The rest describes the machine
+// at the moment its head leaves the window, or stops inside it.
+*/
+typedef struct {
+  uint64_t window;  /* key: window contents, frame i at bit i */
+  uint64_t result;  /* window contents when the head leaves */
+  int64_t  steps;   /* shifts taken.  Zero means this slot is empty. */
+  State    state;   /* key: state on entry */
+  State    next;    /* state when the head leaves, or after stopping */
+  int8_t   offset;  /* key: head offset within the window on entry */
+  int8_t   exit;    /* head offset when the head leaves (-1 or width),
+                    // or where the machine stopped.
+                    */
+  int8_t   lo;      /* leftmost head offset visited */
+  int8_t   hi;      /* rightmost head offset visited */
+  int8_t   stop;    /* flag: machine stopped inside the window */
+} WindowExitT;
+
+
+
+
+typedef struct {
+  int          width;      /* window width in tape frames */
+  int          cache_bits; /* log2 of the number of cache slots */
+  WindowExitT *cache;      /* direct-mapped table of window exits */
+  int64_t      lookups;    /* number of window lookups */
+  int64_t      hits;       /* number of lookups found in the cache */
+} WindowT;
+
+
+
+
+WindowT * windowNew(int width, int cache_bits);
+void      windowReset(WindowT *this);
+void      windowDestroy(WindowT *this);
+void      windowPrint(const WindowT *this);
+int64_t   tmWindowSimulate(TuringMachineT *this, WindowT *window,
+                           int64_t max_iters, int64_t tape_len_max);
+
+
+
+#endif